@@ -43,6 +43,11 @@ uniform uint uActiveEntityID;
 const float offset = 1.0 / 300.0;
 const float weight = 0.06;
 
+// Single channel sdfs store the same distance in r, g and b, so the median works for both sdf types
+float median(float r, float g, float b) {
+    return max(min(r, g), min(max(r, g), b));
+}
+
 void main()
 {
     vec4 texColor = vec4(1, 1, 1, 1);
@@ -169,7 +174,7 @@ void main()
     float aa = 0.49;
 
     if (fTexSlot > 0) {
-        float c = texColor.r;
+        float c = median(texColor.r, texColor.g, texColor.b);
         if (c > midpoint)
         {
             color = fColor;
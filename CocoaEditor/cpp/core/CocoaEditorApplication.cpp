@@ -70,6 +70,8 @@ namespace Cocoa
 
 			CocoaEditor* application = (CocoaEditor*)Application::Get();
 			Scene::FreeResources(scene);
+			// Nothing from the old project can be shared with the new one
+			AssetManager::Clear();
 			Scene::Init(scene);
 			Scene::Save(scene, Settings::General::s_CurrentScene);
 			m_SourceFileWatcher = std::make_shared<SourceFileWatcher>(scriptsPath);
@@ -315,6 +317,7 @@ namespace Cocoa
 		// In debug builds free all the memory to make sure there are no leaks
 		DebugDraw::Destroy();
 		Scene::FreeResources(m_CurrentScene);
+		AssetManager::Clear();
 #endif
 		
 		// This won't really do anything in release builds
@@ -12,6 +12,7 @@
 #include "cocoa/util/CMath.h"
 #include "cocoa/util/JsonExtended.h"
 #include "cocoa/systems/RenderSystem.h"
+#include "cocoa/scenes/RegistrySnapshot.h"
 
 #include <examples/imgui_impl_glfw.h>
 #ifndef _JADE_IMPL_IMGUI
@@ -37,6 +38,7 @@ namespace Cocoa
 		static glm::vec2 m_GameviewSize = glm::vec2();
 		static glm::vec2 m_GameviewMousePos = glm::vec2();
 		static bool m_BlockEvents = false;
+		static RegistrySnapshot m_PlaySnapshot;
 
 		static void* m_Window;
 
@@ -165,9 +167,7 @@ namespace Cocoa
 				{
 					if (!isPlaying)
 					{
-						CPath tmpPath = Settings::General::s_EngineAssetsPath;
-						NCPath::Join(tmpPath, NCPath::CreatePath("tmp.jade"));
-						Scene::Save(scene, tmpPath);
+						NRegistrySnapshot::Capture(scene, m_PlaySnapshot);
 						Scene::Play(scene);
 						isPlaying = true;
 					}
@@ -178,9 +178,7 @@ namespace Cocoa
 					if (isPlaying)
 					{
 						Scene::Stop(scene);
-						CPath tmpPath = Settings::General::s_EngineAssetsPath;
-						NCPath::Join(tmpPath, NCPath::CreatePath("tmp.jade"));
-						Scene::Load(scene, tmpPath);
+						NRegistrySnapshot::Restore(scene, m_PlaySnapshot);
 						isPlaying = false;
 					}
 					ImGui::EndMenu();
@@ -14,6 +14,8 @@
 #include "cocoa/util/CMath.h"
 #include "cocoa/util/Settings.h"
 #include "cocoa/file/File.h"
+#include "cocoa/scenes/AsyncSceneSaver.h"
+#include "cocoa/scenes/RegistrySnapshot.h"
 
 #include <imgui.h>
 
@@ -48,6 +50,8 @@ namespace Cocoa
 		static bool HandleMouseButtonPressed(MouseButtonPressedEvent& e, SceneData& scene);
 		static bool HandleMouseButtonReleased(MouseButtonReleasedEvent& e, SceneData& scene);
 		static bool HandleMouseScroll(MouseScrolledEvent& e, SceneData& scene);
+		static void SetWindowTitle(const char* status);
+		static void OnSceneSaved(const CPath& filename, bool success);
 
 		void Init(SceneData& scene)
 		{
@@ -74,7 +78,9 @@ namespace Cocoa
 
 			if (File::IsFile(tmpScriptDll))
 			{
-				Scene::Save(scene, Settings::General::s_CurrentScene);
+				// Script components live in the library's registry, so they are copied out before it goes away
+				RegistrySnapshot scripts;
+				NRegistrySnapshot::CaptureScripts(scripts);
 				EditorLayer::SaveProject();
 				ScriptSystem::FreeScriptLibrary();
 
@@ -82,7 +88,7 @@ namespace Cocoa
 				File::CopyFile(tmpScriptDll, NCPath::CreatePath(NCPath::GetDirectory(scriptDll, -1)), "ScriptModule");
 				ScriptSystem::Reload();
 				ScriptSystem::InitImGui(ImGui::GetCurrentContext());
-				Scene::LoadScriptsOnly(scene, Settings::General::s_CurrentScene);
+				NRegistrySnapshot::RestoreScripts(scene, scripts);
 
 				File::DeleteFile(tmpScriptDll);
 			}
@@ -184,7 +190,8 @@ namespace Cocoa
 
 				if (e.GetKeyCode() == COCOA_KEY_S)
 				{
-					Scene::Save(scene, Settings::General::s_CurrentScene);
+					SetWindowTitle(" (Saving...)");
+					AsyncSceneSaver::Save(scene, Settings::General::s_CurrentScene, OnSceneSaved);
 					EditorLayer::SaveProject();
 				}
 
@@ -203,6 +210,18 @@ namespace Cocoa
 			return false;
 		}
 
+		static void SetWindowTitle(const char* status)
+		{
+			std::string winTitle = std::string(NCPath::Filename(Settings::General::s_CurrentProject)) + " -- " +
+				std::string(NCPath::Filename(Settings::General::s_CurrentScene)) + status;
+			Application::Get()->GetWindow()->SetTitle(winTitle.c_str());
+		}
+
+		static void OnSceneSaved(const CPath& filename, bool success)
+		{
+			SetWindowTitle(success ? "" : " (Save failed)");
+		}
+
 		bool HandleKeyRelease(KeyReleasedEvent& e, SceneData& scene)
 		{
 			if (e.GetKeyCode() == COCOA_KEY_LEFT_CONTROL)
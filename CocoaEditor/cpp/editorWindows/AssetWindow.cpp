@@ -12,6 +12,7 @@
 #include "cocoa/core/Application.h"
 #include "cocoa/scenes/Scene.h"
 #include "cocoa/renderer/fonts/FontUtil.h"
+#include "cocoa/renderer/TextureAtlas.h"
 
 namespace Cocoa
 {
@@ -124,7 +125,8 @@ namespace Cocoa
 
 				if (ImGui::BeginDragDropSource(ImGuiDragDropFlags_SourceAllowNullID))
 				{
-					ImGui::SetDragDropPayload("TEXTURE_HANDLE_ID", &texResourceId, sizeof(int));        // Set payload to carry the index of our item (could be anything)
+					uint32 textureHandleId = AssetManager::GetTextureHandle(texResourceId).m_AssetId;
+					ImGui::SetDragDropPayload("TEXTURE_HANDLE_ID", &textureHandleId, sizeof(uint32));        // Set payload to carry the handle of our item
 					ImageButton(tex, NCPath::Filename(tex.Path), m_ButtonSize);
 					ImGui::EndDragDropSource();
 				}
@@ -135,18 +137,47 @@ namespace Cocoa
 
 			if (IconButton(ICON_FA_PLUS, "Add Texture", m_ButtonSize))
 			{
-				std::string initialPath;
-				FileDialogResult result;
-				if (FileDialog::GetOpenFileName(initialPath, result))
+				ImGui::OpenPopup("TextureImporter");
+			}
+
+			if (ImGui::BeginPopup("TextureImporter", ImGuiWindowFlags_NoDocking))
+			{
+				// Compressed textures are cooked once and cached by the hash of the source file
+				static CompressionQuality compression = CompressionQuality::None;
+				static const std::array<const char*, 4> compressionOptions = { "None", "Fast", "Normal", "High" };
+				CImGui::UndoableCombo<CompressionQuality>(compression, "Compression: ", compressionOptions.data(), (int)compressionOptions.size());
+
+				// Mipmapped textures only keep the levels that are visible on the gpu
+				static bool generateMips = false;
+				CImGui::Checkbox("Generate Mips: ", &generateMips);
+
+				ImGui::NewLine();
+				if (CImGui::Button("Select Texture File", { 0, 0 }, false))
 				{
-					Texture texSpec;
-					texSpec.IsDefault = false;
-					texSpec.MagFilter = FilterMode::Nearest;
-					texSpec.MinFilter = FilterMode::Nearest;
-					texSpec.WrapS = WrapMode::Repeat;
-					texSpec.WrapT = WrapMode::Repeat;
-					AssetManager::LoadTextureFromFile(texSpec, NCPath::CreatePath(result.filepath));
+					std::string initialPath;
+					FileDialogResult result;
+					if (FileDialog::GetOpenFileName(initialPath, result))
+					{
+						Texture texSpec;
+						texSpec.IsDefault = false;
+						texSpec.MagFilter = FilterMode::Nearest;
+						texSpec.MinFilter = FilterMode::Nearest;
+						texSpec.WrapS = WrapMode::Repeat;
+						texSpec.WrapT = WrapMode::Repeat;
+						texSpec.Compression = compression;
+						texSpec.GenerateMips = generateMips;
+						AssetManager::LoadTextureFromFileAsync(texSpec, NCPath::CreatePath(result.filepath));
+					}
+					ImGui::CloseCurrentPopup();
 				}
+				ImGui::EndPopup();
+			}
+
+			// Small textures get packed into shared pages so sprites using them can be drawn together
+			ImGui::SameLine();
+			if (IconButton(ICON_FA_TH_LARGE, "Build Atlas", m_ButtonSize))
+			{
+				TextureAtlas::Build(TextureAtlas::GetDefaultDirectory());
 			}
 		}
 
@@ -157,14 +188,14 @@ namespace Cocoa
 			for (auto& font : fonts)
 			{
 				i++;
-				if (font.IsDefault())
+				if (font.IsDefault() || font.IsNull())
 				{
 					continue;
 				}
 
 				int fontResourceId = i;
 				ImGui::PushID(fontResourceId);
-				const Texture& fontTexture = AssetManager::GetTexture(font.m_FontTexture.m_AssetId);
+				const Texture& fontTexture = AssetManager::GetTexture(font.m_FontTexture);
 
 				if (ImageButton(fontTexture, NCPath::Filename(font.m_Path), m_ButtonSize))
 				{
@@ -173,7 +204,8 @@ namespace Cocoa
 
 				if (ImGui::BeginDragDropSource(ImGuiDragDropFlags_SourceAllowNullID))
 				{
-					ImGui::SetDragDropPayload("FONT_HANDLE_ID", &fontResourceId, sizeof(int));        // Set payload to carry the index of our item (could be anything)
+					uint32 fontHandleId = AssetManager::GetFontHandle(fontResourceId).m_AssetId;
+					ImGui::SetDragDropPayload("FONT_HANDLE_ID", &fontHandleId, sizeof(uint32));        // Set payload to carry the handle of our item
 					ImageButton(fontTexture, NCPath::Filename(font.m_Path), m_ButtonSize);
 					ImGui::EndDragDropSource();
 				}
@@ -230,10 +262,15 @@ namespace Cocoa
 				static int upscaleResolution = 4096;
 				CImGui::UndoableDragInt("Upscale Resolution: ", upscaleResolution);
 
+				// Multi-channel sdfs keep sharp corners, so a much smaller font size can be used
+				static bool multiChannel = false;
+				CImGui::Checkbox("Multi-channel SDF: ", &multiChannel);
+
 				ImGui::NewLine();
 				if (CImGui::Button("Generate Font", { 0, 0 }, false))
 				{
-					AssetManager::LoadFontFromTtfFile(NCPath::CreatePath(fontPath), fontSize, outputTexture, glyphRangeStart, glyphRangeEnd, padding, upscaleResolution);
+					AssetManager::LoadFontFromTtfFile(NCPath::CreatePath(fontPath), fontSize, outputTexture, glyphRangeStart, glyphRangeEnd, padding, upscaleResolution,
+						multiChannel ? FontSdfType::MultiChannel : FontSdfType::SingleChannel);
 					ImGui::CloseCurrentPopup();
 				}
 				ImGui::EndPopup();
@@ -199,7 +199,7 @@ namespace Cocoa
 
 				if (spr.m_Sprite.m_Texture)
 				{
-					const Texture& tex = AssetManager::GetTexture(spr.m_Sprite.m_Texture.m_AssetId);
+					const Texture& tex = AssetManager::GetTexture(spr.m_Sprite.m_Texture);
 					CImGui::InputText("##SpriteRendererTexture", (char*)NCPath::Filename(tex.Path),
 						NCPath::FilenameSize(tex.Path), ImGuiInputTextFlags_ReadOnly);
 				}
@@ -211,9 +211,8 @@ namespace Cocoa
 				{
 					if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("TEXTURE_HANDLE_ID"))
 					{
-						IM_ASSERT(payload->DataSize == sizeof(int));
-						int textureResourceId = *(const int*)payload->Data;
-						spr.m_Sprite.m_Texture = textureResourceId;
+						IM_ASSERT(payload->DataSize == sizeof(uint32));
+						spr.m_Sprite.m_Texture = Handle<Texture>(*(const uint32*)payload->Data);
 					}
 					ImGui::EndDragDropTarget();
 				}
@@ -231,6 +230,7 @@ namespace Cocoa
 				CImGui::UndoableDragInt("Z-Index: ##fonts", fontRenderer.m_ZIndex);
 				CImGui::UndoableColorEdit4("Font Color: ", fontRenderer.m_Color);
 				CImGui::UndoableDragInt("Font Size: ", fontRenderer.fontSize);
+				CImGui::Checkbox("Cache Text: ", &fontRenderer.m_Cached);
 
 				static char textBuffer[100];
 				Log::Assert(fontRenderer.text.size() < 100, "Font Renderer only supports text sizes up to 100 characters.");
@@ -242,7 +242,7 @@ namespace Cocoa
 
 				if (fontRenderer.m_Font)
 				{
-					const Font& font = AssetManager::GetFont(fontRenderer.m_Font.m_AssetId);
+					const Font& font = AssetManager::GetFont(fontRenderer.m_Font);
 					CImGui::InputText("##FontRendererTexture", (char*)NCPath::Filename(font.m_Path),
 						NCPath::FilenameSize(font.m_Path), ImGuiInputTextFlags_ReadOnly);
 				}
@@ -254,9 +254,8 @@ namespace Cocoa
 				{
 					if (const ImGuiPayload* payload = ImGui::AcceptDragDropPayload("FONT_HANDLE_ID"))
 					{
-						IM_ASSERT(payload->DataSize == sizeof(int));
-						int fontResourceId = *(const int*)payload->Data;
-						fontRenderer.m_Font = fontResourceId;
+						IM_ASSERT(payload->DataSize == sizeof(uint32));
+						fontRenderer.m_Font = Handle<Font>(*(const uint32*)payload->Data);
 					}
 					ImGui::EndDragDropTarget();
 				}
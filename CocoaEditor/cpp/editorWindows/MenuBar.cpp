@@ -9,9 +9,12 @@
 #include "cocoa/core/Application.h"
 #include "cocoa/file/FileDialog.h"
 #include "cocoa/file/File.h"
+#include "cocoa/file/PackFile.h"
+#include "cocoa/util/Log.h"
 #include "cocoa/components/SpriteRenderer.h"
 #include "cocoa/components/Transform.h"
 #include "cocoa/util/Settings.h"
+#include "cocoa/scenes/WorldStreamer.h"
 
 namespace Cocoa
 {
@@ -106,6 +109,33 @@ namespace Cocoa
 						}
 					}
 
+					if (CImGui::MenuButton("Export Scene As Json"))
+					{
+						FileDialogResult result{};
+						if (FileDialog::GetSaveFileName(".", result, { {"Json Files *.json", "*.json"}, {"All Files", "*.*"} }, ".json"))
+						{
+							Scene::ExportJson(scene, NCPath::CreatePath(result.filepath));
+						}
+					}
+
+					if (CImGui::MenuButton("Build World Cells"))
+					{
+						// Scenes with a cell directory are split into cells every time they are saved
+						File::CreateDirIfNotExists(WorldStreamer::GetCellDirectory(Settings::General::s_CurrentScene));
+						Scene::Save(scene, Settings::General::s_CurrentScene);
+					}
+
+					if (CImGui::MenuButton("Build Asset Pack"))
+					{
+						const CPath& projectDirectory = Settings::General::s_WorkingDirectory;
+						CPath packPath = PackFile::GetDefaultPath(projectDirectory);
+						int numFiles = PackFile::Build(projectDirectory, packPath);
+						if (numFiles >= 0)
+						{
+							Log::Info("Packed %d files into '%s'.", numFiles, packPath.Path.c_str());
+						}
+					}
+
 					ImGui::EndMenu();
 				}
 
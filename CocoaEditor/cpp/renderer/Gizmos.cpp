@@ -13,6 +13,7 @@
 #include "cocoa/util/Settings.h"
 #include "cocoa/commands/ICommand.h"
 #include "cocoa/systems/RenderSystem.h"
+#include "cocoa/scenes/SpatialIndex.h"
 #include "cocoa/components/Spritesheet.h"
 
 namespace Cocoa
@@ -122,7 +123,12 @@ namespace Cocoa
 
 		static GizmoData Gizmos[6];
 
+		static bool m_BoxSelecting = false;
+		static glm::vec2 m_BoxSelectStart;
+		static std::vector<entt::entity> m_BoxSelection;
+
 		// Forward Declarations        
+		static Entity PickEntity(SceneData& scene, const glm::vec2& mousePosWorld);
 		static bool HandleKeyPress(KeyPressedEvent& e, SceneData& scene);
 		static bool HandleKeyRelease(KeyReleasedEvent& e, SceneData& scene);
 		static bool HandleMouseButtonPressed(MouseButtonPressedEvent& e, SceneData& scene);
@@ -178,6 +184,14 @@ namespace Cocoa
 
 		void EditorUpdate(SceneData& scene, float dt)
 		{
+			if (m_BoxSelecting)
+			{
+				glm::vec2 mousePosWorld = NCamera::ScreenToOrtho(*m_Camera);
+				glm::vec2 center = (m_BoxSelectStart + mousePosWorld) * 0.5f;
+				glm::vec2 size = glm::abs(mousePosWorld - m_BoxSelectStart);
+				DebugDraw::AddBox2D(center, size, 0.0f, 2.0f * m_Camera->Zoom, { 0.4f, 0.6f, 1.0f });
+			}
+
 			Entity activeEntity = InspectorWindow::GetActiveEntity();
 			if (!NEntity::IsNull(activeEntity))
 			{
@@ -290,11 +304,7 @@ namespace Cocoa
 				const Camera& camera = scene.SceneCamera;
 				glm::vec2 mousePosWorld = NCamera::ScreenToOrtho(camera);
 
-				glm::vec2 normalizedMousePos = Input::NormalizedMousePos();
-				const Framebuffer& mainFramebuffer = RenderSystem::GetMainFramebuffer();
-				uint32 pixel = NFramebuffer::ReadPixelUint32(mainFramebuffer, 1, (uint32)(normalizedMousePos.x * 3840), (uint32)(normalizedMousePos.y * 2160));
-
-				Entity entity = Scene::GetEntity(scene, pixel);
+				Entity entity = m_HotGizmo == -1 ? PickEntity(scene, mousePosWorld) : NEntity::CreateNull();
 				Entity selectedEntity = m_HotGizmo == -1 ? entity : InspectorWindow::GetActiveEntity();
 
 				m_OriginalDragClickPos = CMath::Vector3From2(mousePosWorld);
@@ -312,8 +322,11 @@ namespace Cocoa
 				}
 				else
 				{
+					// Dragging over empty space selects everything inside the box
 					InspectorWindow::ClearAllEntities();
 					m_ActiveGizmo = -1;
+					m_BoxSelecting = true;
+					m_BoxSelectStart = mousePosWorld;
 				}
 			}
 
@@ -327,7 +340,37 @@ namespace Cocoa
 				m_MouseDragging = false;
 				CommandHistory::SetNoMergeMostRecent();
 			}
+
+			if (m_BoxSelecting && e.GetMouseButton() == COCOA_MOUSE_BUTTON_LEFT)
+			{
+				m_BoxSelecting = false;
+				glm::vec2 mousePosWorld = NCamera::ScreenToOrtho(scene.SceneCamera);
+				m_BoxSelection.clear();
+				SpatialIndex::QueryBox(glm::min(m_BoxSelectStart, mousePosWorld), glm::max(m_BoxSelectStart, mousePosWorld), m_BoxSelection);
+				for (entt::entity entity : m_BoxSelection)
+				{
+					if (scene.Registry.valid(entity))
+					{
+						InspectorWindow::AddEntity(Entity{ entity, &scene });
+					}
+				}
+			}
 			return false;
 		}
+
+		static Entity PickEntity(SceneData& scene, const glm::vec2& mousePosWorld)
+		{
+			Entity entity = SpatialIndex::Pick(scene, mousePosWorld);
+			if (!NEntity::IsNull(entity) || scene.Registry.view<FontRenderer>().empty())
+			{
+				return entity;
+			}
+
+			// Text isn't in the spatial index, so it can only be found in the picking buffer
+			glm::vec2 normalizedMousePos = Input::NormalizedMousePos();
+			const Framebuffer& mainFramebuffer = RenderSystem::GetMainFramebuffer();
+			uint32 pixel = NFramebuffer::ReadPixelUint32(mainFramebuffer, 1, (uint32)(normalizedMousePos.x * 3840), (uint32)(normalizedMousePos.y * 2160));
+			return Scene::GetEntity(scene, pixel);
+		}
 	}
 }
\ No newline at end of file
@@ -38,6 +38,7 @@ namespace Cocoa
 			source << "#include \"cocoa/core/Core.h\"\n";
 			source << "#include \"cocoa/util/Log.h\"\n";
 			source << "#include \"cocoa/core/Entity.h\"\n";
+			source << "#include \"cocoa/scenes/ComponentSerializer.h\"\n";
 
 			const std::filesystem::path base = NCPath::GetDirectory(filepath, -1);
 			for (auto clazz : classes)
@@ -183,6 +184,11 @@ namespace Cocoa
 					numVisited++;
 				}
 			}
+
+			for (auto clazz : classes)
+			{
+				source << "\t\t\tComponentSerializer::RegisterScript(\"" << clazz.m_ClassName.c_str() << "\");\n";
+			}
 			source << "\t\t}\n";
 
 			// Generate Init ImGui function
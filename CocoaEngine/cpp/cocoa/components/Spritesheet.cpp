@@ -9,7 +9,7 @@ namespace Cocoa
 		{
 			Spritesheet res;
 			res.TextureHandle = textureHandle;
-			const Texture& texture = AssetManager::GetTexture(textureHandle.m_AssetId);
+			const Texture& texture = AssetManager::GetTexture(textureHandle);
 
 			// NOTE: If you don't reserve the space before hand, when the vector grows it will
 			// change the pointers it holds
@@ -4,6 +4,13 @@
 #include "cocoa/core/Application.h"
 #include "cocoa/renderer/DebugDraw.h"
 #include "cocoa/core/Entity.h"
+#include "cocoa/renderer/AsyncTextureLoader.h"
+#include "cocoa/renderer/TextureStreamer.h"
+#include "cocoa/file/PackFile.h"
+#include "cocoa/file/File.h"
+#include "cocoa/scenes/ComponentSerializer.h"
+#include "cocoa/scenes/AsyncSceneSaver.h"
+#include "cocoa/scenes/WorldStreamer.h"
 
 namespace Cocoa
 {
@@ -23,6 +30,19 @@ namespace Cocoa
 		s_Instance = this;
 
 		m_Window->SetEventCallback(std::bind(&Application::OnEvent, this, std::placeholders::_1));
+
+		// Shipping builds read their assets out of a single pack next to the game instead of loose files
+		CPath packPath = PackFile::GetDefaultPath(File::GetCwd());
+		if (File::IsFile(packPath))
+		{
+			PackFile::Mount(packPath, File::GetCwd());
+		}
+
+		ComponentSerializer::Init();
+		AsyncTextureLoader::Init();
+		TextureStreamer::Init();
+		AsyncSceneSaver::Init();
+		WorldStreamer::Init();
 	}
 
 	Application::~Application()
@@ -45,6 +65,9 @@ namespace Cocoa
 			float dt = time - m_LastFrameTime;
 			m_LastFrameTime = time;
 
+			AsyncTextureLoader::Update();
+			AsyncSceneSaver::Update();
+
 			BeginFrame();
 			m_AppData.AppOnUpdate(m_CurrentScene, dt);
 			m_AppData.AppOnRender(m_CurrentScene);
@@ -60,6 +83,11 @@ namespace Cocoa
 		//	layer->OnDetach();
 		//}
 
+		WorldStreamer::Destroy();
+		AsyncSceneSaver::Destroy();
+		AsyncTextureLoader::Destroy();
+		TextureStreamer::Destroy();
+		PackFile::Unmount();
 		m_Window->Destroy();
 	}
 
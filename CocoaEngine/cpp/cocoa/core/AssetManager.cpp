@@ -1,8 +1,12 @@
 #include "cocoa/core/AssetManager.h"
 #include "cocoa/util/Log.h"
 #include "cocoa/renderer/Texture.h"
+#include "cocoa/renderer/AsyncTextureLoader.h"
+#include "cocoa/renderer/TextureStreamer.h"
+#include "cocoa/renderer/TextureAtlas.h"
 #include "cocoa/file/File.h"
 #include "cocoa/util/JsonExtended.h"
+#include "cocoa/util/Settings.h"
 
 namespace Cocoa
 {
@@ -12,6 +16,68 @@ namespace Cocoa
 	uint32 AssetManager::s_CurrentScene = 0;
 	uint32 AssetManager::s_ResourceCount = 0;
 
+	// Bookkeeping that turns each asset vector into a slot map. Occupied always has one entry per asset in the vector,
+	// generations are kept across Clear so handles from before the clear stay invalid
+	struct AssetSlots
+	{
+		std::vector<uint32> Generations;
+		std::vector<bool> Occupied;
+		std::vector<uint32> FreeList;
+
+		// Number of scenes referencing the asset in each slot, and the residency tick at which the last one let go
+		std::vector<uint32> RefCounts;
+		std::vector<uint64> LastReleased;
+	};
+
+	// Handle ids of every asset a scene holds a reference on
+	struct SceneAssets
+	{
+		std::unordered_set<uint32> Textures;
+		std::unordered_set<uint32> Fonts;
+		std::unordered_set<uint32> Shaders;
+	};
+
+	// Internal Variables
+	static AssetSlots m_TextureSlots;
+	static AssetSlots m_FontSlots;
+	static AssetSlots m_ShaderSlots;
+
+	// Absolute path -> asset id, so looking up or importing an asset doesn't compare against every loaded asset
+	static std::unordered_map<std::string, uint32> m_TextureIndex;
+	static std::unordered_map<std::string, uint32> m_FontIndex;
+	static std::unordered_map<std::string, uint32> m_ShaderIndex;
+
+	static std::unordered_map<uint32, SceneAssets> m_SceneAssets;
+	static uint64 m_ResidencyTick = 0;
+
+	// Resource id in the last loaded scene file -> handle the asset ended up with
+	static std::unordered_map<uint32, Handle<Texture>> m_TextureRemap;
+	static std::unordered_map<uint32, Handle<Font>> m_FontRemap;
+
+	// Forward Declarations
+	template<typename T>
+	static int AcquireSlot(std::vector<T>& assets, AssetSlots& slots, int id);
+	template<typename T>
+	static void ReleaseSlot(AssetSlots& slots, uint32 index);
+	template<typename T>
+	static Handle<T> SlotHandle(const AssetSlots& slots, uint32 index);
+	template<typename T>
+	static bool IsSlotValid(const AssetSlots& slots, Handle<T> handle);
+	static void GrowSlots(AssetSlots& slots, uint32 numSlots, bool addToFreeList);
+	template<typename T>
+	static void ClearSlots(AssetSlots& slots);
+
+	static std::string IndexKey(const CPath& path);
+	static int FindInIndex(const std::unordered_map<std::string, uint32>& index, const AssetSlots& slots, const CPath& path);
+	static void AddToIndex(std::unordered_map<std::string, uint32>& index, const CPath& path, uint32 id);
+	static void RemoveFromIndex(std::unordered_map<std::string, uint32>& index, const CPath& path, uint32 id);
+
+	static SceneAssets& CurrentSceneAssets();
+	template<typename T>
+	static void Retain(AssetSlots& slots, std::unordered_set<uint32>& sceneAssets, Handle<T> handle);
+	template<typename T>
+	static void ReleaseReferences(AssetSlots& slots, const std::unordered_set<uint32>& sceneAssets);
+
 	void AssetManager::Init(uint32 scene)
 	{
 		s_CurrentScene = scene;
@@ -19,11 +85,11 @@ namespace Cocoa
 		// TODO: Clear assets somehow?
 	}
 
-	const Shader& AssetManager::GetShader(uint32 resourceId)
+	const Shader& AssetManager::GetShader(Handle<Shader> handle)
 	{
-		if (resourceId < s_Shaders.size())
+		if (IsSlotValid(m_ShaderSlots, handle))
 		{
-			return s_Shaders[resourceId];
+			return s_Shaders[handle.Index()];
 		}
 
 		return NShader::CreateShader();
@@ -31,17 +97,13 @@ namespace Cocoa
 
 	Handle<Shader> AssetManager::GetShader(const CPath& path)
 	{
-		int i = 0;
-		for (auto& shader : s_Shaders)
-		{
-			if (shader.Filepath == path)
-			{
-				return Handle<Shader>(i);
-			}
-			i++;
-		}
+		int id = FindInIndex(m_ShaderIndex, m_ShaderSlots, path);
+		return id != -1 ? SlotHandle<Shader>(m_ShaderSlots, id) : Handle<Shader>();
+	}
 
-		return Handle<Shader>();
+	Handle<Shader> AssetManager::GetShaderHandle(uint32 resourceId)
+	{
+		return SlotHandle<Shader>(m_ShaderSlots, resourceId);
 	}
 
 	Handle<Shader> AssetManager::LoadShaderFromFile(const CPath& path, bool isDefault, int id)
@@ -49,42 +111,66 @@ namespace Cocoa
 		Handle<Shader> shader = GetShader(path);
 		if (!shader.IsNull())
 		{
-			Log::Warning("Tried to load asset that has already been loaded '%s'", path.Path.c_str());
+			// The engine asks for its default assets again every time a scene is initialized
+			if (!isDefault)
+			{
+				Log::Warning("Tried to load asset that has already been loaded '%s'", path.Path.c_str());
+				Retain(m_ShaderSlots, CurrentSceneAssets().Shaders, shader);
+			}
 			return shader;
 		}
 
+		// If id is -1, we don't care where you place the shader so long as it gets loaded. Otherwise the slot at id
+		// must be free
+		int index = AcquireSlot(s_Shaders, m_ShaderSlots, id);
+		if (index == -1)
+		{
+			Log::Error("Could not place shader at requested id. The slot is already taken.");
+			return Handle<Shader>();
+		}
+
 		CPath absPath = File::GetAbsolutePath(path);
-		int index = id;
+		s_Shaders[index] = NShader::CreateShader(absPath, isDefault);
+		AddToIndex(m_ShaderIndex, s_Shaders[index].Filepath, index);
 
-		// If id is -1, we don't care where you place the texture so long as it gets loaded
-		if (index == -1)
+		shader = SlotHandle<Shader>(m_ShaderSlots, index);
+		if (!isDefault)
 		{
-			index = s_Shaders.size();
-			s_Shaders.emplace_back(NShader::CreateShader(absPath, isDefault));
+			Retain(m_ShaderSlots, CurrentSceneAssets().Shaders, shader);
 		}
-		// Otherwise, place the texture in the id location specified, and report error if a texture is already located there for some reason
-		else
+		return shader;
+	}
+
+	void AssetManager::UnloadShader(Handle<Shader> handle)
+	{
+		if (!IsSlotValid(m_ShaderSlots, handle))
 		{
-			Log::Assert(index < s_Shaders.size(), "Id must be smaller then shader size.");
-			Log::Assert(NShader::IsNull(s_Shaders[index]), "Texture slot must be free to place a texture at the specified id.");
-			if (NShader::IsNull(s_Shaders[index]))
-			{
-				s_Shaders[index] = NShader::CreateShader(absPath, isDefault);
-			}
-			else
-			{
-				Log::Error("Could not place shader at requested id. The slot is already taken.");
-			}
+			Log::Warning("Tried to unload a shader that is not loaded '%d'.", handle.m_AssetId);
+			return;
+		}
+
+		Shader& shader = s_Shaders[handle.Index()];
+		RemoveFromIndex(m_ShaderIndex, shader.Filepath, handle.Index());
+		NShader::Delete(shader);
+		shader = NShader::CreateShader();
+		ReleaseSlot<Shader>(m_ShaderSlots, handle.Index());
+
+		for (auto& [scene, sceneAssets] : m_SceneAssets)
+		{
+			sceneAssets.Shaders.erase(handle.m_AssetId);
 		}
+	}
 
-		return Handle<Shader>(index);
+	bool AssetManager::IsValid(Handle<Shader> handle)
+	{
+		return IsSlotValid(m_ShaderSlots, handle);
 	}
 
-	const Texture& AssetManager::GetTexture(uint32 resourceId)
+	const Texture& AssetManager::GetTexture(Handle<Texture> handle)
 	{
-		if (resourceId < s_Textures.size())
+		if (IsSlotValid(m_TextureSlots, handle))
 		{
-			return s_Textures[resourceId];
+			return s_Textures[handle.Index()];
 		}
 
 		return TextureUtil::NullTexture;
@@ -92,20 +178,16 @@ namespace Cocoa
 
 	Handle<Texture> AssetManager::GetTexture(const CPath& path)
 	{
-		int i = 0;
-		for (auto& tex : s_Textures)
-		{
-			if (tex.Path == path)
-			{
-				return Handle<Texture>(i);
-			}
-			i++;
-		}
+		int id = FindInIndex(m_TextureIndex, m_TextureSlots, path);
+		return id != -1 ? SlotHandle<Texture>(m_TextureSlots, id) : Handle<Texture>();
+	}
 
-		return Handle<Texture>();
+	Handle<Texture> AssetManager::GetTextureHandle(uint32 resourceId)
+	{
+		return SlotHandle<Texture>(m_TextureSlots, resourceId);
 	}
 
-	Handle<Texture> AssetManager::LoadTextureFromJson(const json& j, bool isDefault, int id)
+	Handle<Texture> AssetManager::LoadTextureFromJson(const json& j, bool isDefault, int id, bool async)
 	{
 		Texture texture = TextureUtil::Deserialize(j);
 		texture.IsDefault = isDefault;
@@ -113,38 +195,46 @@ namespace Cocoa
 		Handle<Texture> textureHandle = GetTexture(texture.Path);
 		if (!textureHandle.IsNull())
 		{
-			Log::Warning("Tried to load asset that has already been loaded '%s'.", texture.Path.Path.c_str());
+			if (!isDefault)
+			{
+				Log::Warning("Tried to load asset that has already been loaded '%s'.", texture.Path.Path.c_str());
+				Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
+			}
 			return textureHandle;
 		}
 
-		CPath absPath = File::GetAbsolutePath(texture.Path);
-		int index = id;
-
-		// Make sure to generate texture *before* pushing back since we are pushing back a copy
-		TextureUtil::Generate(texture, texture.Path);
-
-		// If id is -1, we don't care where you place the font so long as it gets loaded
+		// If id is -1, we don't care where you place the texture so long as it gets loaded. Otherwise the slot at id
+		// must be free
+		int index = AcquireSlot(s_Textures, m_TextureSlots, id);
 		if (index == -1)
 		{
-			index = s_Textures.size();
-			s_Textures.push_back(texture);
+			Log::Error("Could not place texture at requested id. The slot is already taken.");
+			return Handle<Texture>();
+		}
+
+		if (async)
+		{
+			TextureUtil::GeneratePlaceholder(texture);
 		}
-		// Otherwise, place the font in the id location specified, and report error if a font is already located there for some reason
 		else
 		{
-			Log::Assert(index < s_Textures.size(), "Id must be smaller then texture size.");
-			Log::Assert(TextureUtil::IsNull(s_Textures[index]), "Texture slot must be free to place a texture at the specified id.");
-			if (TextureUtil::IsNull(s_Textures[index]))
-			{
-				s_Textures[index] = texture;
-			}
-			else
-			{
-				Log::Error("Could not place texture at requested id. The slot is already taken.");
-			}
+			TextureUtil::Generate(texture, texture.Path);
+		}
+		s_Textures[index] = texture;
+		AddToIndex(m_TextureIndex, texture.Path, index);
+
+		textureHandle = SlotHandle<Texture>(m_TextureSlots, index);
+		if (!isDefault)
+		{
+			Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
+		}
+
+		if (async)
+		{
+			AsyncTextureLoader::Queue(textureHandle, texture.Path, texture.Compression, texture.GenerateMips);
 		}
 
-		return Handle<Texture>(index);
+		return textureHandle;
 	}
 
 	Handle<Texture> AssetManager::LoadTextureFromFile(Texture& texture, const CPath& path, int id)
@@ -152,62 +242,131 @@ namespace Cocoa
 		Handle<Texture> textureHandle = GetTexture(path);
 		if (!textureHandle.IsNull())
 		{
-			Log::Warning("Tried to load asset that has already been loaded '%s'", path.Path.c_str());
+			if (!texture.IsDefault)
+			{
+				Log::Warning("Tried to load asset that has already been loaded '%s'", path.Path.c_str());
+				Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
+			}
 			return textureHandle;
 		}
 
-		CPath absPath = File::GetAbsolutePath(path);
-		int index = id;
+		// If id is -1, we don't care where you place the texture so long as it gets loaded. Otherwise the slot at id
+		// must be free
+		int index = AcquireSlot(s_Textures, m_TextureSlots, id);
+		if (index == -1)
+		{
+			Log::Error("Could not place texture at requested id. The slot is already taken.");
+			return Handle<Texture>();
+		}
+
 		texture.Path = path;
 		TextureUtil::Generate(texture, path);
+		s_Textures[index] = texture;
+		AddToIndex(m_TextureIndex, path, index);
 
-		// If id is -1, we don't care where you place the texture so long as it gets loaded
-		if (index == -1)
+		textureHandle = SlotHandle<Texture>(m_TextureSlots, index);
+		if (!texture.IsDefault)
 		{
-			index = s_Textures.size();
-			s_Textures.push_back(texture);
+			Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
 		}
-		// Otherwise, place the texture in the id location specified, and report error if a texture is already located there for some reason
-		else
+		return textureHandle;
+	}
+
+	Handle<Texture> AssetManager::LoadTextureFromFileAsync(Texture& texture, const CPath& path, int id)
+	{
+		Handle<Texture> textureHandle = GetTexture(path);
+		if (!textureHandle.IsNull())
 		{
-			Log::Assert(index < s_Textures.size(), "Id must be smaller then texture size.");
-			Log::Assert(TextureUtil::IsNull(s_Textures[index]), "Texture slot must be free to place a texture at the specified id.");
-			if (TextureUtil::IsNull(s_Textures[index]))
-			{
-				s_Textures[index] = texture;
-			}
-			else
+			if (!texture.IsDefault)
 			{
-				Log::Error("Could not place texture at requested id. The slot is already taken.");
+				Log::Warning("Tried to load asset that has already been loaded '%s'", path.Path.c_str());
+				Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
 			}
+			return textureHandle;
+		}
+
+		// If id is -1, we don't care where you place the texture so long as it gets loaded. Otherwise the slot at id
+		// must be free
+		int index = AcquireSlot(s_Textures, m_TextureSlots, id);
+		if (index == -1)
+		{
+			Log::Error("Could not place texture at requested id. The slot is already taken.");
+			return Handle<Texture>();
 		}
 
-		return Handle<Texture>(index);
+		texture.Path = path;
+		TextureUtil::GeneratePlaceholder(texture);
+		s_Textures[index] = texture;
+		AddToIndex(m_TextureIndex, path, index);
+
+		textureHandle = SlotHandle<Texture>(m_TextureSlots, index);
+		if (!texture.IsDefault)
+		{
+			Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
+		}
+		AsyncTextureLoader::Queue(textureHandle, path, texture.Compression, texture.GenerateMips);
+		return textureHandle;
+	}
+
+	Handle<Texture> AssetManager::AddGeneratedTexture(const Texture& texture)
+	{
+		Log::Assert(!TextureUtil::IsNull(texture), "Cannot add a texture that has not been generated.");
+
+		// Generated textures are never serialized, so they fill the empty slots those leave behind when a scene is reloaded
+		int index = AcquireSlot(s_Textures, m_TextureSlots, -1);
+		s_Textures[index] = texture;
+		s_Textures[index].IsDefault = true;
+		AddToIndex(m_TextureIndex, texture.Path, index);
+		return SlotHandle<Texture>(m_TextureSlots, index);
 	}
 
-	const Font& AssetManager::GetFont(uint32 resourceId)
+	void AssetManager::UnloadTexture(Handle<Texture> handle)
 	{
-		if (resourceId < s_Fonts.size())
+		if (!IsSlotValid(m_TextureSlots, handle))
 		{
-			return s_Fonts[resourceId];
+			Log::Warning("Tried to unload a texture that is not loaded '%d'.", handle.m_AssetId);
+			return;
 		}
 
-		return Font::nullFont;
+		// A pending async load finds the handle invalid and drops its result
+		TextureStreamer::Unregister(handle);
+
+		Texture& texture = s_Textures[handle.Index()];
+		RemoveFromIndex(m_TextureIndex, texture.Path, handle.Index());
+		TextureUtil::Delete(texture);
+		texture = TextureUtil::NullTexture;
+		ReleaseSlot<Texture>(m_TextureSlots, handle.Index());
+
+		for (auto& [scene, sceneAssets] : m_SceneAssets)
+		{
+			sceneAssets.Textures.erase(handle.m_AssetId);
+		}
 	}
 
-	Handle<Font> AssetManager::GetFont(const CPath& path)
+	bool AssetManager::IsValid(Handle<Texture> handle)
 	{
-		int i = 0;
-		for (auto& font : s_Fonts)
+		return IsSlotValid(m_TextureSlots, handle);
+	}
+
+	const Font& AssetManager::GetFont(Handle<Font> handle)
+	{
+		if (IsSlotValid(m_FontSlots, handle))
 		{
-			if (font.m_Path == path)
-			{
-				return Handle<Font>(i);
-			}
-			i++;
+			return s_Fonts[handle.Index()];
 		}
 
-		return Handle<Font>();
+		return Font::nullFont;
+	}
+
+	Handle<Font> AssetManager::GetFont(const CPath& path)
+	{
+		int id = FindInIndex(m_FontIndex, m_FontSlots, path);
+		return id != -1 ? SlotHandle<Font>(m_FontSlots, id) : Handle<Font>();
+	}
+
+	Handle<Font> AssetManager::GetFontHandle(uint32 resourceId)
+	{
+		return SlotHandle<Font>(m_FontSlots, resourceId);
 	}
 
 	Handle<Font> AssetManager::LoadFontFromJson(const CPath& path, const json& j, bool isDefault, int id)
@@ -215,54 +374,53 @@ namespace Cocoa
 		Handle<Font> font = GetFont(path);
 		if (!font.IsNull())
 		{
-			Log::Warning("Tried to load asset that has already been loaded '%s'.", path.Path.c_str());
+			if (!isDefault)
+			{
+				Log::Warning("Tried to load asset that has already been loaded '%s'.", path.Path.c_str());
+				Retain(m_FontSlots, CurrentSceneAssets().Fonts, font);
+			}
 			return font;
 		}
 
-		CPath absPath = File::GetAbsolutePath(path);
-		int index = id;
-
-		// If id is -1, we don't care where you place the font so long as it gets loaded
+		// If id is -1, we don't care where you place the font so long as it gets loaded. Otherwise the slot at id
+		// must be free
+		int index = AcquireSlot(s_Fonts, m_FontSlots, id);
 		if (index == -1)
 		{
-			index = s_Fonts.size();
-			s_Fonts.emplace_back(Font{ absPath, isDefault });
-		}
-		// Otherwise, place the font in the id location specified, and report error if a font is already located there for some reason
-		else
-		{
-			Log::Assert(index < s_Fonts.size(), "Id must be smaller then texture size.");
-			Log::Assert(s_Fonts[index].IsNull(), "Texture slot must be free to place a texture at the specified id.");
-			if (s_Fonts[index].IsNull())
-			{
-				s_Fonts[index] = Font{ absPath, isDefault };
-			}
-			else
-			{
-				Log::Error("Could not place font at requested id. The slot is already taken.");
-			}
+			Log::Error("Could not place font at requested id. The slot is already taken.");
+			return Handle<Font>();
 		}
 
+		CPath absPath = File::GetAbsolutePath(path);
+		s_Fonts[index] = Font{ absPath, isDefault };
 		Font& newFont = s_Fonts.at(index);
 		newFont.Deserialize(j);
-		return Handle<Font>(index);
+		AddToIndex(m_FontIndex, newFont.m_Path, index);
+
+		font = SlotHandle<Font>(m_FontSlots, index);
+		if (!isDefault)
+		{
+			Retain(m_FontSlots, CurrentSceneAssets().Fonts, font);
+		}
+		return font;
 	}
 
-	Handle<Font> AssetManager::LoadFontFromTtfFile(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution)
+	Handle<Font> AssetManager::LoadFontFromTtfFile(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution, FontSdfType sdfType)
 	{
 		Handle<Font> font = GetFont(fontFile);
 		if (!font.IsNull())
 		{
 			Log::Warning("Tried to load asset that has already been loaded '%s'.", fontFile.Path.c_str());
+			Retain(m_FontSlots, CurrentSceneAssets().Fonts, font);
 			return font;
 		}
 
 		CPath absPath = File::GetAbsolutePath(fontFile);
-		int index = s_Fonts.size();
-
-		s_Fonts.push_back(Font{ absPath, false });
+		int index = AcquireSlot(s_Fonts, m_FontSlots, -1);
+		s_Fonts[index] = Font{ absPath, false };
+		AddToIndex(m_FontIndex, absPath, index);
 		Font& newFont = s_Fonts.at(index);
-		newFont.GenerateSdf(fontFile, fontSize, outputFile, glyphRangeStart, glyphRangeEnd, padding, upscaleResolution);
+		newFont.GenerateSdf(fontFile, fontSize, outputFile, glyphRangeStart, glyphRangeEnd, padding, upscaleResolution, sdfType);
 
 		Texture fontTexSpec;
 		fontTexSpec.IsDefault = false;
@@ -272,7 +430,35 @@ namespace Cocoa
 		fontTexSpec.WrapT = WrapMode::Repeat;
 		newFont.m_FontTexture = AssetManager::LoadTextureFromFile(fontTexSpec, outputFile);
 
-		return Handle<Font>(index);
+		font = SlotHandle<Font>(m_FontSlots, index);
+		Retain(m_FontSlots, CurrentSceneAssets().Fonts, font);
+		return font;
+	}
+
+	void AssetManager::UnloadFont(Handle<Font> handle)
+	{
+		if (!IsSlotValid(m_FontSlots, handle))
+		{
+			Log::Warning("Tried to unload a font that is not loaded '%d'.", handle.m_AssetId);
+			return;
+		}
+
+		// The font texture is a separate texture asset, it has to be unloaded on its own
+		Font& font = s_Fonts[handle.Index()];
+		RemoveFromIndex(m_FontIndex, font.m_Path, handle.Index());
+		font.Free();
+		font = Font();
+		ReleaseSlot<Font>(m_FontSlots, handle.Index());
+
+		for (auto& [scene, sceneAssets] : m_SceneAssets)
+		{
+			sceneAssets.Fonts.erase(handle.m_AssetId);
+		}
+	}
+
+	bool AssetManager::IsValid(Handle<Font> handle)
+	{
+		return IsSlotValid(m_FontSlots, handle);
 	}
 
 	json AssetManager::Serialize()
@@ -281,28 +467,53 @@ namespace Cocoa
 
 		res["SceneID"] = s_CurrentScene;
 
-		int i = 0;
-		for (auto& assetIt : s_Textures)
+		// Assets other scenes left resident are not part of this scene, only what it holds a reference on is written.
+		// A font's texture goes with it even if nothing else in the scene uses the texture
+		const SceneAssets& sceneAssets = CurrentSceneAssets();
+		std::unordered_set<uint32> textureIds = sceneAssets.Textures;
+		for (uint32 fontId : sceneAssets.Fonts)
+		{
+			Handle<Font> handle = Handle<Font>(fontId);
+			if (IsSlotValid(m_FontSlots, handle))
+			{
+				textureIds.insert(s_Fonts[handle.Index()].m_FontTexture.m_AssetId);
+			}
+		}
+
+		for (uint32 textureId : textureIds)
 		{
+			Handle<Texture> handle = Handle<Texture>(textureId);
+			if (!IsSlotValid(m_TextureSlots, handle))
+			{
+				continue;
+			}
+
+			uint32 i = handle.Index();
+			const Texture& assetIt = s_Textures[i];
 			if (!assetIt.IsDefault)
 			{
 				json assetSerialized = TextureUtil::Serialize(assetIt);
 				assetSerialized["ResourceId"] = i;
 				res["Textures"][i] = assetSerialized;
 			}
-			i++;
 		}
 
-		i = 0;
-		for (auto& assetIt : s_Fonts)
+		for (uint32 fontId : sceneAssets.Fonts)
 		{
+			Handle<Font> handle = Handle<Font>(fontId);
+			if (!IsSlotValid(m_FontSlots, handle))
+			{
+				continue;
+			}
+
+			uint32 i = handle.Index();
+			const Font& assetIt = s_Fonts[i];
 			if (!assetIt.IsDefault())
 			{
 				json assetSerialized = assetIt.Serialize();
 				assetSerialized["ResourceId"] = i;
 				res["Fonts"][i] = assetSerialized;
 			}
-			i++;
 		}
 
 		return res;
@@ -315,9 +526,19 @@ namespace Cocoa
 
 		if (scene >= 0 && j.contains("Textures"))
 		{
+			s_CurrentScene = scene;
+			m_TextureRemap.clear();
+
 			// Note: We shouldn't have to worry about adding in the size of the default textures because they get 'serialized' as null
 			// Note: Should we keep it this way though?
-			s_Textures.resize(j["Textures"].size());
+			// Slots are never shrunk, anything already loaded past the end of the list keeps its handle
+			uint32 numSlots = (uint32)j["Textures"].size();
+			if (numSlots > s_Textures.size())
+			{
+				s_Textures.resize(numSlots);
+				GrowSlots(m_TextureSlots, numSlots, true);
+			}
+
 			for (auto it = j["Textures"].begin(); it != j["Textures"].end(); ++it)
 			{
 				const json& assetJson = it.value();
@@ -328,9 +549,30 @@ namespace Cocoa
 
 				if (resourceId >= 0)
 				{
-					LoadTextureFromJson(assetJson, false, resourceId);
+					CPath path = NCPath::CreatePath();
+					JsonExtended::AssignIfNotNull(assetJson, "Filepath", path);
+
+					// Textures the previous scene shared with this one are still resident, they just gain a reference
+					Handle<Texture> textureHandle = GetTexture(path);
+					if (!textureHandle.IsNull())
+					{
+						Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
+					}
+					else
+					{
+						// Keep the serialized id when its slot is free, the scene's components refer to textures by it
+						bool slotIsFree = resourceId < m_TextureSlots.Occupied.size() && !m_TextureSlots.Occupied[resourceId];
+						textureHandle = LoadTextureFromJson(assetJson, false, slotIsFree ? (int)resourceId : -1, true);
+					}
+					m_TextureRemap[resourceId] = textureHandle;
 				}
 			}
+
+			// Every texture decodes in parallel, but the rest of the scene expects them to be loaded once this returns
+			AsyncTextureLoader::WaitAll();
+
+			// Pages go in after the scene textures so they don't take any of the serialized ids
+			TextureAtlas::Load(TextureAtlas::GetDefaultDirectory());
 		}
 	}
 
@@ -341,7 +583,15 @@ namespace Cocoa
 
 		if (scene >= 0 && j.contains("Fonts"))
 		{
-			s_Fonts.resize(s_Fonts.size() + j["Fonts"].size());
+			m_FontRemap.clear();
+
+			uint32 numSlots = (uint32)j["Fonts"].size();
+			if (numSlots > s_Fonts.size())
+			{
+				s_Fonts.resize(numSlots);
+				GrowSlots(m_FontSlots, numSlots, true);
+			}
+
 			for (auto it = j["Fonts"].begin(); it != j["Fonts"].end(); ++it)
 			{
 				const json& assetJson = it.value();
@@ -358,27 +608,201 @@ namespace Cocoa
 
 				if (resourceId >= 0)
 				{
-					LoadFontFromJson(path, assetJson, false, resourceId);
+					Handle<Font> fontHandle = GetFont(path);
+					if (!fontHandle.IsNull())
+					{
+						// The font texture may have been evicted and loaded again into a different slot by this scene
+						uint32 fontTextureId = -1;
+						JsonExtended::AssignIfNotNull(assetJson, "FontTextureId", fontTextureId);
+						s_Fonts[fontHandle.Index()].m_FontTexture = GetSceneTexture(fontTextureId);
+						Retain(m_FontSlots, CurrentSceneAssets().Fonts, fontHandle);
+					}
+					else
+					{
+						bool slotIsFree = resourceId < m_FontSlots.Occupied.size() && !m_FontSlots.Occupied[resourceId];
+						fontHandle = LoadFontFromJson(path, assetJson, false, slotIsFree ? (int)resourceId : -1);
+					}
+					m_FontRemap[resourceId] = fontHandle;
 				}
 			}
 		}
 	}
 
+	Handle<Texture> AssetManager::GetSceneTexture(uint32 resourceId)
+	{
+		auto iter = m_TextureRemap.find(resourceId);
+		if (iter != m_TextureRemap.end())
+		{
+			return iter->second;
+		}
+
+		return GetTextureHandle(resourceId);
+	}
+
+	Handle<Font> AssetManager::GetSceneFont(uint32 resourceId)
+	{
+		auto iter = m_FontRemap.find(resourceId);
+		if (iter != m_FontRemap.end())
+		{
+			return iter->second;
+		}
+
+		return GetFontHandle(resourceId);
+	}
+
+	Handle<Texture> AssetManager::ResolveTexture(const json& assetJson)
+	{
+		CPath path = NCPath::CreatePath();
+		JsonExtended::AssignIfNotNull(assetJson, "Filepath", path);
+		Handle<Texture> textureHandle = GetTexture(path);
+		if (!textureHandle.IsNull())
+		{
+			Retain(m_TextureSlots, CurrentSceneAssets().Textures, textureHandle);
+			return textureHandle;
+		}
+
+		return LoadTextureFromJson(assetJson);
+	}
+
+	Handle<Font> AssetManager::ResolveFont(const json& assetJson, Handle<Texture> fontTexture)
+	{
+		CPath path = NCPath::CreatePath();
+		JsonExtended::AssignIfNotNull(assetJson, "Filepath", path);
+		Handle<Font> fontHandle = GetFont(path);
+		if (!fontHandle.IsNull())
+		{
+			Retain(m_FontSlots, CurrentSceneAssets().Fonts, fontHandle);
+			return fontHandle;
+		}
+
+		// The font's json refers to its texture by the resource id it had when the file was saved
+		fontHandle = LoadFontFromJson(path, assetJson);
+		if (!fontHandle.IsNull())
+		{
+			s_Fonts[fontHandle.Index()].m_FontTexture = fontTexture;
+		}
+		return fontHandle;
+	}
+
+	void AssetManager::ReleaseScene(uint32 scene)
+	{
+		auto iter = m_SceneAssets.find(scene);
+		if (iter == m_SceneAssets.end())
+		{
+			return;
+		}
+
+		// Nothing is unloaded here, the next scene may use the same assets. EvictUnreferenced decides what goes
+		ReleaseReferences<Texture>(m_TextureSlots, iter->second.Textures);
+		ReleaseReferences<Font>(m_FontSlots, iter->second.Fonts);
+		ReleaseReferences<Shader>(m_ShaderSlots, iter->second.Shaders);
+		m_SceneAssets.erase(iter);
+		m_ResidencyTick++;
+	}
+
+	void AssetManager::EvictUnreferenced()
+	{
+		uint64 budget = (uint64)glm::max(Settings::Graphics::s_AssetMemoryBudgetMb, 0) * 1024 * 1024;
+		uint64 residentBytes = GetResidentBytes();
+		if (residentBytes > budget)
+		{
+			std::vector<uint32> candidates;
+			for (uint32 i = 0; i < s_Textures.size(); i++)
+			{
+				if (m_TextureSlots.Occupied[i] && !s_Textures[i].IsDefault && m_TextureSlots.RefCounts[i] == 0)
+				{
+					candidates.push_back(i);
+				}
+			}
+
+			// Least recently released goes first
+			std::sort(candidates.begin(), candidates.end(), [](uint32 a, uint32 b)
+			{
+				return m_TextureSlots.LastReleased[a] < m_TextureSlots.LastReleased[b];
+			});
+
+			for (uint32 index : candidates)
+			{
+				if (residentBytes <= budget)
+				{
+					break;
+				}
+
+				residentBytes -= TextureUtil::GetMemorySize(s_Textures[index]);
+				UnloadTexture(SlotHandle<Texture>(m_TextureSlots, index));
+			}
+		}
+
+		// Fonts are cheap to keep around, but one without its texture can't be drawn
+		for (uint32 i = 0; i < s_Fonts.size(); i++)
+		{
+			if (m_FontSlots.Occupied[i] && !s_Fonts[i].IsDefault() && m_FontSlots.RefCounts[i] == 0 && !IsValid(s_Fonts[i].m_FontTexture))
+			{
+				UnloadFont(SlotHandle<Font>(m_FontSlots, i));
+			}
+		}
+	}
+
+	uint32 AssetManager::GetReferenceCount(Handle<Texture> handle)
+	{
+		return IsSlotValid(m_TextureSlots, handle) ? m_TextureSlots.RefCounts[handle.Index()] : 0;
+	}
+
+	uint32 AssetManager::GetReferenceCount(Handle<Font> handle)
+	{
+		return IsSlotValid(m_FontSlots, handle) ? m_FontSlots.RefCounts[handle.Index()] : 0;
+	}
+
+	uint32 AssetManager::GetReferenceCount(Handle<Shader> handle)
+	{
+		return IsSlotValid(m_ShaderSlots, handle) ? m_ShaderSlots.RefCounts[handle.Index()] : 0;
+	}
+
+	uint64 AssetManager::GetResidentBytes()
+	{
+		uint64 residentBytes = 0;
+		for (uint32 i = 0; i < s_Textures.size(); i++)
+		{
+			if (m_TextureSlots.Occupied[i])
+			{
+				residentBytes += TextureUtil::GetMemorySize(s_Textures[i]);
+			}
+		}
+
+		return residentBytes;
+	}
+
 	void AssetManager::Clear()
 	{
+		m_SceneAssets.clear();
+		m_TextureRemap.clear();
+		m_FontRemap.clear();
+
+		// Any pending loads would be uploaded into slots that no longer exist
+		AsyncTextureLoader::CancelAll();
+		TextureStreamer::Clear();
+		TextureAtlas::Clear();
+
 		// Delete all textures on GPU before clear
 		for (auto& tex : s_Textures)
 		{
 			TextureUtil::Delete(tex);
 		}
 		s_Textures.clear();
+		m_TextureIndex.clear();
+		ClearSlots<Texture>(m_TextureSlots);
 
 		// Free all fonts before destroying them
-		for (auto& font : s_Fonts)
+		for (uint32 i = 0; i < s_Fonts.size(); i++)
 		{
-			font.Free();
+			if (m_FontSlots.Occupied[i])
+			{
+				s_Fonts[i].Free();
+			}
 		}
 		s_Fonts.clear();
+		m_FontIndex.clear();
+		ClearSlots<Font>(m_FontSlots);
 
 		// Delete all shaders on clear
 		for (auto& shader : s_Shaders)
@@ -387,5 +811,194 @@ namespace Cocoa
 		}
 		NShader::ClearAllShaderVariables();
 		s_Shaders.clear();
+		m_ShaderIndex.clear();
+		ClearSlots<Shader>(m_ShaderSlots);
+	}
+
+	// ---------------------------------------------------------------------
+	// Internal functions
+	// ---------------------------------------------------------------------
+	template<typename T>
+	static int AcquireSlot(std::vector<T>& assets, AssetSlots& slots, int id)
+	{
+		if (id != -1)
+		{
+			Log::Assert(id < (int)assets.size(), "Id must be smaller then the number of asset slots.");
+			if (id >= (int)assets.size() || slots.Occupied[id])
+			{
+				return -1;
+			}
+
+			// The slot may still be on the free list, it gets skipped when it comes up
+			slots.Occupied[id] = true;
+			return id;
+		}
+
+		while (slots.FreeList.size() > 0)
+		{
+			uint32 index = slots.FreeList.back();
+			slots.FreeList.pop_back();
+			if (index < assets.size() && !slots.Occupied[index])
+			{
+				slots.Occupied[index] = true;
+				return (int)index;
+			}
+		}
+
+		uint32 index = (uint32)assets.size();
+		Log::Assert(index < Handle<T>::INDEX_MASK, "Ran out of asset slots.");
+		assets.emplace_back();
+		GrowSlots(slots, (uint32)assets.size(), false);
+		slots.Occupied[index] = true;
+		return (int)index;
+	}
+
+	template<typename T>
+	static void ReleaseSlot(AssetSlots& slots, uint32 index)
+	{
+		slots.Occupied[index] = false;
+		slots.Generations[index] = (slots.Generations[index] + 1) & Handle<T>::GENERATION_MASK;
+		slots.RefCounts[index] = 0;
+		slots.FreeList.push_back(index);
+	}
+
+	template<typename T>
+	static Handle<T> SlotHandle(const AssetSlots& slots, uint32 index)
+	{
+		if (index >= slots.Occupied.size() || !slots.Occupied[index])
+		{
+			return Handle<T>();
+		}
+
+		return Handle<T>(index, slots.Generations[index]);
+	}
+
+	template<typename T>
+	static bool IsSlotValid(const AssetSlots& slots, Handle<T> handle)
+	{
+		uint32 index = handle.Index();
+		return !handle.IsNull() && index < slots.Occupied.size() && slots.Occupied[index] &&
+			slots.Generations[index] == handle.Generation();
+	}
+
+	static void GrowSlots(AssetSlots& slots, uint32 numSlots, bool addToFreeList)
+	{
+		uint32 oldSize = (uint32)slots.Occupied.size();
+		if (numSlots <= oldSize)
+		{
+			return;
+		}
+
+		slots.Occupied.resize(numSlots, false);
+		slots.RefCounts.resize(numSlots, 0);
+		slots.LastReleased.resize(numSlots, 0);
+		if (slots.Generations.size() < numSlots)
+		{
+			slots.Generations.resize(numSlots, 0);
+		}
+
+		if (addToFreeList)
+		{
+			// Pushed in reverse so the lowest slot gets handed out first
+			for (uint32 i = numSlots; i > oldSize; i--)
+			{
+				slots.FreeList.push_back(i - 1);
+			}
+		}
+	}
+
+	template<typename T>
+	static void ClearSlots(AssetSlots& slots)
+	{
+		// Every handle that was alive before the clear has to be stale after it, even once its slot is filled again
+		for (uint32 i = 0; i < slots.Occupied.size(); i++)
+		{
+			if (slots.Occupied[i])
+			{
+				slots.Generations[i] = (slots.Generations[i] + 1) & Handle<T>::GENERATION_MASK;
+			}
+		}
+		slots.Occupied.clear();
+		slots.FreeList.clear();
+		slots.RefCounts.clear();
+		slots.LastReleased.clear();
+	}
+
+	static std::string IndexKey(const CPath& path)
+	{
+		// Paths are compared the same way CPath's operator== compares them, so relative and absolute paths to the same
+		// file share a key. Empty paths never match anything
+		if (path.Path.size() == 0)
+		{
+			return "";
+		}
+
+		return File::GetAbsolutePath(path).Path;
+	}
+
+	static int FindInIndex(const std::unordered_map<std::string, uint32>& index, const AssetSlots& slots, const CPath& path)
+	{
+		std::string key = IndexKey(path);
+		if (key.size() == 0)
+		{
+			return -1;
+		}
+
+		auto iter = index.find(key);
+		if (iter == index.end() || iter->second >= slots.Occupied.size() || !slots.Occupied[iter->second])
+		{
+			return -1;
+		}
+
+		return (int)iter->second;
+	}
+
+	static void AddToIndex(std::unordered_map<std::string, uint32>& index, const CPath& path, uint32 id)
+	{
+		std::string key = IndexKey(path);
+		if (key.size() > 0)
+		{
+			// The first asset loaded with a path keeps it, just like the old linear search returned the first match
+			index.emplace(key, id);
+		}
+	}
+
+	static void RemoveFromIndex(std::unordered_map<std::string, uint32>& index, const CPath& path, uint32 id)
+	{
+		std::string key = IndexKey(path);
+		auto iter = key.size() > 0 ? index.find(key) : index.end();
+		if (iter != index.end() && iter->second == id)
+		{
+			index.erase(iter);
+		}
+	}
+
+	static SceneAssets& CurrentSceneAssets()
+	{
+		return m_SceneAssets[AssetManager::s_CurrentScene];
+	}
+
+	template<typename T>
+	static void Retain(AssetSlots& slots, std::unordered_set<uint32>& sceneAssets, Handle<T> handle)
+	{
+		// A scene holds at most one reference on an asset, however many times it asks for it
+		if (IsSlotValid(slots, handle) && sceneAssets.insert(handle.m_AssetId).second)
+		{
+			slots.RefCounts[handle.Index()]++;
+		}
+	}
+
+	template<typename T>
+	static void ReleaseReferences(AssetSlots& slots, const std::unordered_set<uint32>& sceneAssets)
+	{
+		for (uint32 assetId : sceneAssets)
+		{
+			Handle<T> handle = Handle<T>(assetId);
+			if (IsSlotValid(slots, handle) && slots.RefCounts[handle.Index()] > 0)
+			{
+				slots.RefCounts[handle.Index()]--;
+				slots.LastReleased[handle.Index()] = m_ResidencyTick;
+			}
+		}
 	}
-}
\ No newline at end of file
+}
@@ -3,6 +3,8 @@
 
 #include "cocoa/core/CWindow.h"
 #include "cocoa/util/Log.h"
+#include "cocoa/renderer/Texture.h"
+#include "cocoa/renderer/TextureCooker.h"
 
 namespace Cocoa
 {
@@ -98,6 +100,10 @@ namespace Cocoa
 		glfwMakeContextCurrent(window);
 
 		Log::Assert(gladLoadGLLoader((GLADloadproc)glfwGetProcAddress), "Unable to initialize GLAD.");
+
+		// Textures may be cooked on worker threads, which can't ask GL themselves
+		TextureCooker::SetBC7Supported(TextureUtil::SupportsCompressedFormat(ByteFormat::BC7_RGBA));
+
 		glfwSetWindowUserPointer(window, this);
 
 		// Set up event callbacks
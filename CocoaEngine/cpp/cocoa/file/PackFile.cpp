@@ -0,0 +1,428 @@
+#include "cocoa/file/PackFile.h"
+#include "cocoa/file/File.h"
+#include "cocoa/util/Lz4.h"
+#include "cocoa/util/Log.h"
+
+#include <filesystem>
+
+namespace Cocoa
+{
+	namespace PackFile
+	{
+		struct PackHeader
+		{
+			uint32 Magic;
+			uint32 Version;
+			uint32 NumEntries;
+			uint32 EntrySize;
+			uint64 TocOffset;
+		};
+
+		// Internal Variables
+		static const uint32 PACK_MAGIC = 0x4B415043; // "CPAK"
+		static const uint32 PACK_VERSION = 1;
+		static const uint64 PACK_ALIGNMENT = 16;
+
+		static MemoryMappedFile* m_Mapping = nullptr;
+		static const PackEntry* m_Entries = nullptr;
+		static uint32 m_NumEntries = 0;
+		static std::string m_RootKey;
+		static std::string m_CwdKey;
+
+		// Forward Declarations
+		static std::string NormalizePath(const std::string& path);
+		static bool IsAbsolute(const std::string& normalizedPath);
+		static std::string RelativeKey(const std::string& rootKey, const std::string& cwdKey, const std::string& path);
+		static uint64 HashKey(const std::string& key);
+		static uint64 AlignUp(uint64 offset);
+		static bool ReadBinaryFile(const std::string& path, std::vector<uint8>& result);
+		static void WritePadding(std::ofstream& outStream, uint64 offset);
+
+		int Build(const CPath& rootDirectory, const CPath& outputFile, bool compress)
+		{
+			std::string rootKey = NormalizePath(File::GetAbsolutePath(rootDirectory).Path);
+			std::string cwdKey = NormalizePath(File::GetCwd().Path);
+			std::string outputKey = RelativeKey(rootKey, cwdKey, File::GetAbsolutePath(outputFile).Path);
+
+			std::vector<std::string> files;
+			std::error_code error;
+			for (auto iter = std::filesystem::recursive_directory_iterator(rootDirectory.Path, std::filesystem::directory_options::skip_permission_denied, error);
+				iter != std::filesystem::recursive_directory_iterator(); iter.increment(error))
+			{
+				if (error)
+				{
+					break;
+				}
+
+				if (iter->is_regular_file(error))
+				{
+					files.push_back(iter->path().string());
+				}
+			}
+
+			if (error)
+			{
+				Log::Warning("Could not list the files in '%s' to pack.", rootDirectory.Path.c_str());
+				return -1;
+			}
+
+			std::ofstream outStream(outputFile.Path, std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!outStream)
+			{
+				Log::Warning("Could not open pack file '%s' for writing.", outputFile.Path.c_str());
+				return -1;
+			}
+
+			// The table of contents goes right after the header, so reserve room for every file up front and stream the
+			// file data in behind it
+			uint64 tocOffset = AlignUp(sizeof(PackHeader));
+			uint64 offset = AlignUp(tocOffset + files.size() * sizeof(PackEntry));
+			std::vector<PackEntry> entries;
+			std::unordered_map<uint64, std::string> packedKeys;
+			std::vector<uint8> data;
+			std::vector<uint8> compressed;
+			for (const std::string& file : files)
+			{
+				std::string key = RelativeKey(rootKey, cwdKey, file);
+				if (key.size() == 0 || key == outputKey)
+				{
+					continue;
+				}
+
+				uint64 pathHash = HashKey(key);
+				auto packedKey = packedKeys.find(pathHash);
+				if (packedKey != packedKeys.end())
+				{
+					Log::Warning("Skipping '%s', its path hash collides with '%s'.", key.c_str(), packedKey->second.c_str());
+					continue;
+				}
+
+				if (!ReadBinaryFile(file, data) || data.size() >= (size_t)UINT32_MAX)
+				{
+					Log::Warning("Could not read '%s' into the pack.", file.c_str());
+					continue;
+				}
+
+				PackEntry entry;
+				entry.PathHash = pathHash;
+				entry.Offset = offset;
+				entry.Size = (uint32)data.size();
+				entry.StoredSize = entry.Size;
+				entry.Compression = PackCompression::None;
+				entry.Padding = 0;
+
+				const uint8* storedData = data.data();
+				if (compress && data.size() > 0)
+				{
+					compressed.resize(Lz4::CompressBound((int)data.size()));
+					int compressedSize = Lz4::Compress(data.data(), (int)data.size(), compressed.data(), (int)compressed.size());
+
+					// Files that barely shrink, like PNGs, are worth more as zero copy reads
+					if (compressedSize > 0 && (uint32)compressedSize < entry.Size - entry.Size / 8)
+					{
+						entry.StoredSize = (uint32)compressedSize;
+						entry.Compression = PackCompression::Lz4;
+						storedData = compressed.data();
+					}
+				}
+
+				WritePadding(outStream, offset);
+				outStream.write((const char*)storedData, entry.StoredSize);
+				if (entry.Compression == PackCompression::None)
+				{
+					outStream.put('\0');
+				}
+
+				offset = AlignUp(entry.Offset + entry.StoredSize + 1);
+				entries.push_back(entry);
+				packedKeys[pathHash] = key;
+			}
+
+			std::sort(entries.begin(), entries.end(), [](const PackEntry& a, const PackEntry& b)
+			{
+				return a.PathHash < b.PathHash;
+			});
+
+			PackHeader header;
+			header.Magic = PACK_MAGIC;
+			header.Version = PACK_VERSION;
+			header.NumEntries = (uint32)entries.size();
+			header.EntrySize = sizeof(PackEntry);
+			header.TocOffset = tocOffset;
+
+			WritePadding(outStream, offset);
+			outStream.seekp(0);
+			outStream.write((const char*)&header, sizeof(PackHeader));
+			outStream.seekp(tocOffset);
+			outStream.write((const char*)entries.data(), entries.size() * sizeof(PackEntry));
+			outStream.close();
+			if (outStream.fail())
+			{
+				Log::Warning("Failed to write pack file '%s'.", outputFile.Path.c_str());
+				return -1;
+			}
+
+			return (int)entries.size();
+		}
+
+		bool Mount(const CPath& packFile, const CPath& rootDirectory)
+		{
+			Unmount();
+
+			MemoryMappedFile* mapping = File::MemoryMapFile(packFile);
+			if (!mapping)
+			{
+				return false;
+			}
+
+			PackHeader header;
+			bool isValid = mapping->m_Size >= sizeof(PackHeader);
+			if (isValid)
+			{
+				memcpy(&header, mapping->m_Data, sizeof(PackHeader));
+				isValid = header.Magic == PACK_MAGIC && header.Version == PACK_VERSION && header.EntrySize == sizeof(PackEntry) &&
+					header.TocOffset % PACK_ALIGNMENT == 0 && header.TocOffset + (uint64)header.NumEntries * sizeof(PackEntry) <= mapping->m_Size;
+			}
+
+			const PackEntry* entries = isValid ? (const PackEntry*)(mapping->m_Data + header.TocOffset) : nullptr;
+			for (uint32 i = 0; isValid && i < header.NumEntries; i++)
+			{
+				// Uncompressed entries are followed by their null terminator
+				const PackEntry& entry = entries[i];
+				uint64 storedEnd = entry.Offset + entry.StoredSize + (entry.Compression == PackCompression::None ? 1 : 0);
+				isValid = storedEnd <= mapping->m_Size &&
+					(entry.Compression == PackCompression::Lz4 || (entry.Compression == PackCompression::None && entry.StoredSize == entry.Size)) &&
+					(i == 0 || entries[i - 1].PathHash < entry.PathHash);
+			}
+
+			if (!isValid)
+			{
+				Log::Warning("Ignoring invalid pack file '%s'.", packFile.Path.c_str());
+				File::UnmapFile(mapping);
+				return false;
+			}
+
+			m_Mapping = mapping;
+			m_Entries = entries;
+			m_NumEntries = header.NumEntries;
+			m_RootKey = NormalizePath(File::GetAbsolutePath(rootDirectory).Path);
+			m_CwdKey = NormalizePath(File::GetCwd().Path);
+			Log::Info("Mounted pack '%s' with %d files.", packFile.Path.c_str(), m_NumEntries);
+			return true;
+		}
+
+		void Unmount()
+		{
+			if (m_Mapping)
+			{
+				File::UnmapFile(m_Mapping);
+			}
+
+			m_Mapping = nullptr;
+			m_Entries = nullptr;
+			m_NumEntries = 0;
+			m_RootKey = "";
+			m_CwdKey = "";
+		}
+
+		bool IsMounted()
+		{
+			return m_Mapping != nullptr;
+		}
+
+		const PackEntry* Find(const CPath& path)
+		{
+			if (!m_Mapping)
+			{
+				return nullptr;
+			}
+
+			std::string key = RelativeKey(m_RootKey, m_CwdKey, path.Path);
+			if (key.size() == 0)
+			{
+				return nullptr;
+			}
+
+			uint64 pathHash = HashKey(key);
+			const PackEntry* entriesEnd = m_Entries + m_NumEntries;
+			const PackEntry* entry = std::lower_bound(m_Entries, entriesEnd, pathHash, [](const PackEntry& entry, uint64 pathHash)
+			{
+				return entry.PathHash < pathHash;
+			});
+
+			return entry != entriesEnd && entry->PathHash == pathHash ? entry : nullptr;
+		}
+
+		const uint8* GetMappedData(const PackEntry& entry)
+		{
+			if (!m_Mapping || entry.Compression != PackCompression::None)
+			{
+				return nullptr;
+			}
+
+			return m_Mapping->m_Data + entry.Offset;
+		}
+
+		bool Decompress(const PackEntry& entry, uint8* output)
+		{
+			if (!m_Mapping)
+			{
+				return false;
+			}
+
+			const uint8* storedData = m_Mapping->m_Data + entry.Offset;
+			if (entry.Compression == PackCompression::None)
+			{
+				memcpy(output, storedData, entry.Size);
+				return true;
+			}
+
+			return Lz4::Decompress(storedData, (int)entry.StoredSize, output, (int)entry.Size) == (int)entry.Size;
+		}
+
+		bool Read(const CPath& path, PackData& result)
+		{
+			const PackEntry* entry = Find(path);
+			if (!entry)
+			{
+				return false;
+			}
+
+			result.Size = entry->Size;
+			result.Data = GetMappedData(*entry);
+			if (result.Data)
+			{
+				return true;
+			}
+
+			result.Decompressed.resize((size_t)entry->Size + 1);
+			if (!Decompress(*entry, result.Decompressed.data()))
+			{
+				Log::Warning("Failed to decompress packed file '%s'.", path.Path.c_str());
+				result.Decompressed.clear();
+				result.Size = 0;
+				return false;
+			}
+
+			result.Decompressed[entry->Size] = '\0';
+			result.Data = result.Decompressed.data();
+			return true;
+		}
+
+		CPath GetDefaultPath(const CPath& rootDirectory)
+		{
+			CPath packPath = rootDirectory;
+			NCPath::Join(packPath, NCPath::CreatePath("assets.cpak"));
+			return packPath;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static std::string NormalizePath(const std::string& path)
+		{
+			// Lookups can't go through File::GetAbsolutePath, it uses the tracked allocator and this runs on the texture
+			// loader threads. Windows paths are case insensitive, so keys are lower case with forward slashes
+			std::vector<std::string> segments;
+			std::string segment;
+			for (size_t i = 0; i <= path.size(); i++)
+			{
+				if (i < path.size() && path[i] != '/' && path[i] != '\\')
+				{
+					segment += (char)tolower((unsigned char)path[i]);
+					continue;
+				}
+
+				if (segment == ".." && segments.size() > 0 && segments.back() != "..")
+				{
+					segments.pop_back();
+				}
+				else if (segment.size() > 0 && segment != ".")
+				{
+					segments.push_back(segment);
+				}
+				segment.clear();
+			}
+
+			std::string result = path.size() > 0 && (path[0] == '/' || path[0] == '\\') ? "/" : "";
+			for (size_t i = 0; i < segments.size(); i++)
+			{
+				if (i > 0)
+				{
+					result += '/';
+				}
+				result += segments[i];
+			}
+
+			return result;
+		}
+
+		static bool IsAbsolute(const std::string& normalizedPath)
+		{
+			return (normalizedPath.size() > 0 && normalizedPath[0] == '/') || (normalizedPath.size() > 1 && normalizedPath[1] == ':');
+		}
+
+		static std::string RelativeKey(const std::string& rootKey, const std::string& cwdKey, const std::string& path)
+		{
+			std::string key = NormalizePath(path);
+			if (!IsAbsolute(key))
+			{
+				key = NormalizePath(cwdKey + "/" + key);
+			}
+
+			// Anything outside of the pack's root is never packed
+			if (key.size() <= rootKey.size() || key.compare(0, rootKey.size(), rootKey) != 0 || key[rootKey.size()] != '/')
+			{
+				return "";
+			}
+
+			return key.substr(rootKey.size() + 1);
+		}
+
+		static uint64 HashKey(const std::string& key)
+		{
+			// 64 bit FNV-1a
+			uint64 hash = 14695981039346656037ull;
+			for (char c : key)
+			{
+				hash ^= (uint8)c;
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		static uint64 AlignUp(uint64 offset)
+		{
+			return (offset + PACK_ALIGNMENT - 1) & ~(PACK_ALIGNMENT - 1);
+		}
+
+		static bool ReadBinaryFile(const std::string& path, std::vector<uint8>& result)
+		{
+			std::ifstream inStream(path, std::ios::in | std::ios::binary);
+			if (!inStream)
+			{
+				return false;
+			}
+
+			inStream.seekg(0, std::ios::end);
+			std::streamoff size = inStream.tellg();
+			if (size < 0)
+			{
+				return false;
+			}
+
+			result.resize((size_t)size);
+			inStream.seekg(0, std::ios::beg);
+			inStream.read((char*)result.data(), size);
+			return !inStream.fail();
+		}
+
+		static void WritePadding(std::ofstream& outStream, uint64 offset)
+		{
+			while ((uint64)outStream.tellp() < offset)
+			{
+				outStream.put('\0');
+			}
+		}
+	}
+}
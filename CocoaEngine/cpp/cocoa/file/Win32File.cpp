@@ -1,5 +1,6 @@
 #ifdef _WIN32
 #include "cocoa/file/File.h"
+#include "cocoa/file/PackFile.h"
 #include "cocoa/util/Log.h"
 #include "cocoa/core/Memory.h"
 
@@ -26,6 +27,32 @@ namespace Cocoa
 		{
 			FileHandle* file = (FileHandle*)AllocMem(sizeof(FileHandle));
 			file->m_Filename = filename.Path.c_str();
+			file->m_Mapped = false;
+
+			const PackEntry* packEntry = PackFile::Find(filename);
+			if (packEntry)
+			{
+				// Packed files are null terminated in the pack too, so uncompressed ones can be handed out as they are
+				file->m_Size = packEntry->Size;
+				file->m_Data = (char*)PackFile::GetMappedData(*packEntry);
+				if (file->m_Data)
+				{
+					file->m_Mapped = true;
+					return file;
+				}
+
+				file->m_Data = (char*)AllocMem(sizeof(char) * (file->m_Size + 1));
+				if (!PackFile::Decompress(*packEntry, (uint8*)file->m_Data))
+				{
+					FreeMem(file->m_Data);
+					file->m_Data = nullptr;
+					file->m_Size = 0;
+					Log::Warning("Failed to decompress packed file '%s'.", filename.Path.c_str());
+					return file;
+				}
+				file->m_Data[file->m_Size] = '\0';
+				return file;
+			}
 
 			FILE* filePointer;
 			filePointer = fopen(file->m_Filename, "rb");
@@ -70,7 +97,12 @@ namespace Cocoa
 		{
 			if (file)
 			{
-				if (file->m_Data)
+				if (file->m_Mapped)
+				{
+					// The data belongs to the pack mapping
+					file->m_Data = nullptr;
+				}
+				else if (file->m_Data)
 				{
 					FreeMem(file->m_Data);
 					file->m_Data = nullptr;
@@ -88,6 +120,62 @@ namespace Cocoa
 			}
 		}
 
+		MemoryMappedFile* MemoryMapFile(const CPath& filename)
+		{
+			HANDLE fileHandle = CreateFileA(filename.Path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+			if (fileHandle == INVALID_HANDLE_VALUE)
+			{
+				Log::Warning("Could not open file '%s' for mapping, error code: %d", filename.Path.c_str(), GetLastError());
+				return nullptr;
+			}
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+			{
+				// Empty files can't be mapped
+				CloseHandle(fileHandle);
+				return nullptr;
+			}
+
+			HANDLE mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+			if (!mappingHandle)
+			{
+				Log::Warning("Could not map file '%s', error code: %d", filename.Path.c_str(), GetLastError());
+				CloseHandle(fileHandle);
+				return nullptr;
+			}
+
+			void* view = MapViewOfFile(mappingHandle, FILE_MAP_COPY, 0, 0, 0);
+			if (!view)
+			{
+				Log::Warning("Could not map view of file '%s', error code: %d", filename.Path.c_str(), GetLastError());
+				CloseHandle(mappingHandle);
+				CloseHandle(fileHandle);
+				return nullptr;
+			}
+
+			MemoryMappedFile* file = (MemoryMappedFile*)AllocMem(sizeof(MemoryMappedFile));
+			file->m_Data = (const uint8*)view;
+			file->m_Size = (uint64)fileSize.QuadPart;
+			file->m_FileHandle = fileHandle;
+			file->m_MappingHandle = mappingHandle;
+			return file;
+		}
+
+		void UnmapFile(MemoryMappedFile* file)
+		{
+			if (!file)
+			{
+				Log::Warning("Tried to unmap invalid file.");
+				return;
+			}
+
+			UnmapViewOfFile(file->m_Data);
+			CloseHandle((HANDLE)file->m_MappingHandle);
+			CloseHandle((HANDLE)file->m_FileHandle);
+			FreeMem(file);
+		}
+
 		bool WriteFile(const char* data, const CPath& filename)
 		{
 			std::ofstream outStream(filename.Path.c_str());
@@ -96,6 +184,45 @@ namespace Cocoa
 			return true;
 		}
 
+		bool WriteFile(const uint8* data, uint32 size, const CPath& filename)
+		{
+			std::ofstream outStream(filename.Path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!outStream)
+			{
+				return false;
+			}
+
+			outStream.write((const char*)data, size);
+			outStream.close();
+			return !outStream.fail();
+		}
+
+		bool WriteFileAtomic(const uint8* data, uint32 size, const CPath& filename)
+		{
+			std::string tmpFilename = filename.Path + ".tmp";
+			std::ofstream outStream(tmpFilename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+			if (!outStream)
+			{
+				return false;
+			}
+
+			outStream.write((const char*)data, size);
+			outStream.close();
+			if (outStream.fail())
+			{
+				DeleteFileA(tmpFilename.c_str());
+				return false;
+			}
+
+			if (!MoveFileExA(tmpFilename.c_str(), filename.Path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH))
+			{
+				DeleteFileA(tmpFilename.c_str());
+				return false;
+			}
+
+			return true;
+		}
+
 		bool CreateFile(const CPath& filename, const char* extToAppend)
 		{
 			CPath fileToWrite = filename;
@@ -2,38 +2,362 @@
 #include "cocoa/components/Transform.h"
 #include "cocoa/core/Application.h"
 #include "cocoa/util/CMath.h"
+#include "cocoa/util/JsonExtended.h"
 #include "cocoa/util/Settings.h"
 
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
 namespace Cocoa
 {
 	namespace Physics2D
 	{
+		enum class PhysicsCommandType : uint8
+		{
+			AddBody,
+			RemoveBody,
+			ApplyForce,
+			ApplyImpulse,
+			SetVelocity,
+			Teleport
+		};
+
+		struct PhysicsCommand
+		{
+			PhysicsCommandType Type;
+			SceneData* Scene;
+			entt::entity Entity;
+			glm::vec2 Vector;
+			float RotationDegrees;
+		};
+
+		// Previous is the pose right before the last step, rendering blends from it to the final pose
+		struct BodyPose
+		{
+			b2Vec2 Position;
+			float Angle;
+			b2Vec2 PreviousPosition;
+			float PreviousAngle;
+			bool Awake;
+		};
+
+		// The bodies a step reports poses for. GroupIndex is where the entity sat in the rigidbody group when the step
+		// was started, so reading the poses back can skip the sparse lookup while the group hasn't changed
+		struct StepBodies
+		{
+			std::vector<entt::entity> Entities;
+			std::vector<uint32> GroupIndices;
+			std::vector<b2Body*> Bodies;
+			std::vector<BodyPose> Poses;
+		};
+
+		// What a body's fixture was last built from, so it's only rebuilt when one of the components changed
+		struct BodyRecord
+		{
+			b2Body* Body;
+			glm::vec2 HalfSize;
+			float Radius;
+			float Density;
+			uint16 Category;
+			uint16 Mask;
+			bool HasFixture;
+		};
+
+		// Keeps the closest fixture the ray hits that passes the mask
+		class ClosestRaycastCallback : public b2RayCastCallback
+		{
+		public:
+			ClosestRaycastCallback(uint16 mask, entt::entity ignore)
+				: m_Mask(mask), m_Ignore(ignore) {}
+
+			float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override;
+
+			uint16 m_Mask;
+			entt::entity m_Ignore;
+			RaycastHit2D m_Hit;
+		};
+
+		// Collects every fixture along the ray, box2d reports them in no particular order
+		class AllRaycastCallback : public b2RayCastCallback
+		{
+		public:
+			AllRaycastCallback(uint16 mask, entt::entity ignore, std::vector<RaycastHit2D>& hits)
+				: m_Mask(mask), m_Ignore(ignore), m_Hits(hits) {}
+
+			float ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction) override;
+
+			uint16 m_Mask;
+			entt::entity m_Ignore;
+			std::vector<RaycastHit2D>& m_Hits;
+		};
+
+		// Runs an exact shape test on everything whose fat AABB overlaps the query box. With no shape only the point
+		// is tested
+		class OverlapCallback : public b2QueryCallback
+		{
+		public:
+			OverlapCallback(uint16 mask, const b2Shape* shape, const b2Vec2& point, entt::entity* results, int maxResults)
+				: m_Mask(mask), m_Shape(shape), m_Point(point), m_Results(results), m_MaxResults(maxResults) {}
+
+			bool ReportFixture(b2Fixture* fixture) override;
+
+			uint16 m_Mask;
+			const b2Shape* m_Shape;
+			b2Vec2 m_Point;
+			entt::entity* m_Results;
+			int m_MaxResults;
+			int m_NumResults = 0;
+		};
+
+		// Runs on the step thread and only appends to the contact event buffer the step is writing
+		class ContactListener : public b2ContactListener
+		{
+		public:
+			void BeginContact(b2Contact* contact) override;
+			void EndContact(b2Contact* contact) override;
+			void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override;
+			void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override;
+		};
+
 		// Internal Variables
 		static b2Vec2 m_Gravity;
-		static b2World* m_World;
+		static b2World* m_World = nullptr;
 		static float m_PhysicsTime;
+		static float m_InterpolationAlpha = 1.0f;
+
+		static std::thread m_StepThread;
+		static std::mutex m_StepMutex;
+		static std::condition_variable m_StepRequested;
+		static std::condition_variable m_StepFinished;
+		static int m_NumStepsRequested = 0;
+		static bool m_StepThreadRunning = false;
+
+		// Only touched on the main thread
+		static bool m_StepInFlight = false;
+		static int m_NumPendingSteps = 0;
+		static bool m_PosesReady = false;
+		static StepBodies m_StepBuffers[2];
+		static int m_BackBuffer = 0;
+		static std::vector<PhysicsCommand> m_Commands;
+		static std::unordered_map<const b2Body*, entt::entity> m_BodyEntities;
+
+		// Bodies live as long as their Rigidbody2D does. Released bodies are parked in the pool without fixtures instead
+		// of being destroyed, and entities whose physics components were added or removed wait in m_DirtyEntities
+		// until the next step boundary
+		static std::unordered_map<entt::entity, BodyRecord> m_EntityBodies;
+		static std::vector<b2Body*> m_BodyPool;
+		static std::vector<entt::entity> m_DirtyEntities;
+		static std::vector<RaycastHit2D> m_RaycastAllHits;
 
-		void Init(const glm::vec2& gravity)
+		// The step thread writes contacts into m_ContactEvents[m_ContactWriteBuffer] while scripts read the other one.
+		// Fixtures destroyed on the main thread between steps report their end contacts into the write buffer too
+		static ContactListener m_ContactListener;
+		static std::vector<ContactEvent2D> m_ContactEvents[2];
+		static ContactEventStats2D m_ContactStats[2];
+		static int m_ContactWriteBuffer = 0;
+		static uint16 m_ContactEventMask = 0xFFFF;
+		static uint16 m_PreSolveEventMask = 0x0000;
+
+		// Begin events recorded by the running step that haven't been solved yet. Only touched on the step thread
+		static std::unordered_map<const b2Contact*, size_t> m_UnsolvedBeginEvents;
+
+		// Batched raycasts are split into chunks that the query workers and the main thread pull from until none are
+		// left. The batch parameters only change while no worker is busy
+		static const int s_RaycastChunkSize = 32;
+		static const int s_MinParallelRaycasts = 64;
+		static std::vector<std::thread> m_QueryWorkers;
+		static std::mutex m_QueryMutex;
+		static std::condition_variable m_QueryAvailable;
+		static std::condition_variable m_QueryFinished;
+		static const Ray2D* m_BatchRays = nullptr;
+		static RaycastHit2D* m_BatchHits = nullptr;
+		static int m_BatchSize = 0;
+		static uint16 m_BatchMask = 0;
+		static std::atomic<int> m_NextBatchRay{ 0 };
+		static std::atomic<int> m_NumBatchRaysDone{ 0 };
+		static uint32 m_BatchGeneration = 0;
+		static int m_NumBusyQueryWorkers = 0;
+		static bool m_QueryWorkersRunning = false;
+
+		// Forward Declarations
+		static void StepThreadLoop();
+		template<typename Component>
+		static void ConnectEvents(entt::registry& registry);
+		template<typename Component>
+		static void DisconnectEvents(entt::registry& registry);
+		static void MarkDirty(entt::registry& registry, entt::entity entity);
+		static void SyncDirty(SceneData& scene);
+		static void SyncEntity(SceneData& scene, entt::entity entity);
+		static void ConfigureBody(b2Body* body, const TransformData& transform, Rigidbody2D& rb);
+		static void BuildFixture(BodyRecord& record, SceneData& scene, entt::entity entity, const TransformData& transform, const Rigidbody2D& rb);
+		static void ReleaseBody(entt::entity entity);
+		static bool RecordContact(ContactEventType2D type, b2Contact* contact, uint16 mask);
+		static void ClearContactEvents();
+		static void Queue(const PhysicsCommand& command);
+		static void ApplyCommand(const PhysicsCommand& command);
+		static void PushTransforms(SceneData& scene);
+		static void PullTransforms(SceneData& scene, const StepBodies& front);
+		static void GatherBodies(SceneData& scene, StepBodies& back);
+		static void QueryWorkerLoop();
+		static void RunRaycastChunks();
+		static bool BuildRaycast(const Ray2D& ray, b2Vec2& point1, b2Vec2& point2);
+		static bool PassesFilter(const b2Fixture* fixture, uint16 mask);
+		static entt::entity GetBodyEntity(const b2Body* body);
+
+		void Init(SceneData& scene, const glm::vec2& gravity)
 		{
 			m_Gravity = { gravity.x, gravity.y };
 			m_World = new b2World{ m_Gravity };
+			m_World->SetContactListener(&m_ContactListener);
 			m_PhysicsTime = 0.0f;
+			m_InterpolationAlpha = 1.0f;
+
+			// The world outlives play sessions, bodies come and go with the components they're built from
+			ConnectEvents<TransformData>(scene.Registry);
+			ConnectEvents<Rigidbody2D>(scene.Registry);
+			ConnectEvents<Box2D>(scene.Registry);
+			ConnectEvents<Circle>(scene.Registry);
+			ConnectEvents<CollisionFilter2D>(scene.Registry);
+
+			m_StepThreadRunning = true;
+			m_StepThread = std::thread(StepThreadLoop);
+
+			// The step thread and the main thread are both busy most of the frame
+			int numQueryWorkers = CMath::Max((int)std::thread::hardware_concurrency() - 2, 1);
+			m_QueryWorkersRunning = true;
+			for (int i = 0; i < numQueryWorkers; i++)
+			{
+				m_QueryWorkers.emplace_back(QueryWorkerLoop);
+			}
 		}
 
 		void Destroy(SceneData& scene)
 		{
-			auto view = scene.Registry.view<Rigidbody2D>();
-			for (entt::entity rawEntity : view)
+			if (!m_World)
+			{
+				return;
+			}
+
+			WaitForStep();
+			{
+				std::lock_guard<std::mutex> lock(m_StepMutex);
+				m_StepThreadRunning = false;
+			}
+			m_StepRequested.notify_all();
+			m_StepThread.join();
+
+			{
+				std::lock_guard<std::mutex> lock(m_QueryMutex);
+				m_QueryWorkersRunning = false;
+			}
+			m_QueryAvailable.notify_all();
+			for (std::thread& worker : m_QueryWorkers)
 			{
-				Entity entity = { rawEntity, &scene };
-				Rigidbody2D& rb = NEntity::GetComponent<Rigidbody2D>(entity);
+				worker.join();
+			}
+			m_QueryWorkers.clear();
+
+			DisconnectEvents<TransformData>(scene.Registry);
+			DisconnectEvents<Rigidbody2D>(scene.Registry);
+			DisconnectEvents<Box2D>(scene.Registry);
+			DisconnectEvents<Circle>(scene.Registry);
+			DisconnectEvents<CollisionFilter2D>(scene.Registry);
+			m_DirtyEntities.clear();
 
-				// Manually destroy all bodies, in case the physics system would like
-				// to use this world again
-				m_World->DestroyBody(static_cast<b2Body*>(rb.m_RawRigidbody));
-				rb.m_RawRigidbody = nullptr;
+			m_Commands.clear();
+			m_PosesReady = false;
+			for (StepBodies& buffer : m_StepBuffers)
+			{
+				buffer.Entities.clear();
+				buffer.GroupIndices.clear();
+				buffer.Bodies.clear();
+				buffer.Poses.clear();
 			}
+
+			DestroyBodies(scene);
 			delete m_World;
+			m_World = nullptr;
+		}
+
+		void DestroyBodies(SceneData& scene)
+		{
+			// Queued commands and the last step's poses refer to bodies that are about to be destroyed
+			WaitForStep();
+			m_Commands.clear();
+			m_PosesReady = false;
+			m_NumPendingSteps = 0;
+
+			auto view = scene.Registry.view<Rigidbody2D>();
+			for (entt::entity entity : view)
+			{
+				scene.Registry.get<Rigidbody2D>(entity).m_RawRigidbody = nullptr;
+			}
+
+			// Manually destroy all bodies, in case the physics system would like
+			// to use this world again
+			for (const auto& [entity, record] : m_EntityBodies)
+			{
+				m_World->DestroyBody(record.Body);
+			}
+			for (b2Body* body : m_BodyPool)
+			{
+				m_World->DestroyBody(body);
+			}
+			m_EntityBodies.clear();
+			m_BodyEntities.clear();
+			m_BodyPool.clear();
+
+			// Destroying bodies ends their contacts
+			ClearContactEvents();
+		}
+
+		void ResetBodies(SceneData& scene)
+		{
+			WaitForStep();
+			m_PosesReady = false;
+			for (const PhysicsCommand& command : m_Commands)
+			{
+				ApplyCommand(command);
+			}
+			m_Commands.clear();
+
+			// Clearing the registry doesn't necessarily report every component, so anything whose entity lost its body
+			// components is released here as well
+			for (const auto& [entity, record] : m_EntityBodies)
+			{
+				if (!scene.Registry.valid(entity) || !scene.Registry.has<Rigidbody2D, TransformData>(entity))
+				{
+					m_DirtyEntities.push_back(entity);
+				}
+			}
+			SyncDirty(scene);
+
+			// Components can be edited in place without an event, so every body is brought back to what its components
+			// say. Nothing is allocated unless a rigidbody is still missing its body
+			auto group = scene.Registry.group<Rigidbody2D, TransformData>();
+			for (entt::entity entity : group)
+			{
+				SyncEntity(scene, entity);
+				Rigidbody2D& rb = group.get<Rigidbody2D>(entity);
+				ConfigureBody(static_cast<b2Body*>(rb.m_RawRigidbody), group.get<TransformData>(entity), rb);
+			}
+
+			m_World->ClearForces();
+			m_PhysicsTime = 0.0f;
+			m_InterpolationAlpha = 1.0f;
+			m_NumPendingSteps = 0;
+
+			// Whatever touched in the editor or the last play session shouldn't be reported to the next one
+			ClearContactEvents();
+		}
+
+		void EditorUpdate(SceneData& scene)
+		{
+			// A step may still be running if play was just stopped
+			WaitForStep();
+			SyncDirty(scene);
 		}
 
 		bool PointInBox(const glm::vec2& point, const glm::vec2& halfSize, const glm::vec2& position, float rotationDegrees)
@@ -44,76 +368,252 @@ namespace Cocoa
 			return shape.TestPoint(transform, b2Vec2(point.x, point.y));
 		}
 
-		void AddEntity(Entity entity)
+		bool Raycast(const Ray2D& ray, uint16 mask, RaycastHit2D& hit)
+		{
+			WaitForStep();
+			hit = RaycastHit2D();
+			b2Vec2 point1, point2;
+			if (!BuildRaycast(ray, point1, point2))
+			{
+				return false;
+			}
+
+			ClosestRaycastCallback callback(mask, ray.m_Ignore.Handle);
+			m_World->RayCast(&callback, point1, point2);
+			hit = callback.m_Hit;
+			return hit.m_Entity != entt::null;
+		}
+
+		int RaycastAll(const Ray2D& ray, uint16 mask, RaycastHit2D* hits, int maxHits)
 		{
-			if (NEntity::HasComponent<TransformData, Rigidbody2D>(entity))
+			WaitForStep();
+			b2Vec2 point1, point2;
+			if (maxHits <= 0 || !BuildRaycast(ray, point1, point2))
 			{
-				TransformData& transform = NEntity::GetComponent<TransformData>(entity);
-				Rigidbody2D& rb = NEntity::GetComponent<Rigidbody2D>(entity);
+				return 0;
+			}
 
-				b2BodyDef bodyDef;
-				bodyDef.position.Set(transform.Position.x, transform.Position.y);
-				bodyDef.angle = CMath::ToRadians(transform.EulerRotation.z);
-				bodyDef.angularDamping = rb.m_AngularDamping;
-				bodyDef.linearDamping = rb.m_LinearDamping;
-				bodyDef.fixedRotation = rb.m_FixedRotation;
-				bodyDef.bullet = rb.m_ContinuousCollision;
+			m_RaycastAllHits.clear();
+			AllRaycastCallback callback(mask, ray.m_Ignore.Handle, m_RaycastAllHits);
+			m_World->RayCast(&callback, point1, point2);
 
-				if (rb.m_BodyType == BodyType2D::Dynamic)
-				{
-					bodyDef.type = b2BodyType::b2_dynamicBody;
-				}
-				else if (rb.m_BodyType == BodyType2D::Static)
-				{
-					bodyDef.type = b2BodyType::b2_staticBody;
-				}
-				else
-				{
-					bodyDef.type = b2BodyType::b2_kinematicBody;
-				}
+			int numHits = CMath::Min((int)m_RaycastAllHits.size(), maxHits);
+			std::partial_sort(m_RaycastAllHits.begin(), m_RaycastAllHits.begin() + numHits, m_RaycastAllHits.end(), [](const RaycastHit2D& a, const RaycastHit2D& b)
+			{
+				return a.m_Fraction < b.m_Fraction;
+			});
+			std::copy(m_RaycastAllHits.begin(), m_RaycastAllHits.begin() + numHits, hits);
+			return numHits;
+		}
 
-				b2Body* body = m_World->CreateBody(&bodyDef);
-				rb.m_RawRigidbody = body;
+		int OverlapBox(const glm::vec2& center, const glm::vec2& halfSize, uint16 mask, entt::entity* results, int maxResults)
+		{
+			WaitForStep();
+			if (maxResults <= 0)
+			{
+				return 0;
+			}
 
-				b2PolygonShape shape;
-				if (NEntity::HasComponent<Box2D>(entity))
-				{
-					Box2D& box = NEntity::GetComponent<Box2D>(entity);
-					shape.SetAsBox(box.m_HalfSize.x * transform.Scale.x, box.m_HalfSize.y * transform.Scale.y);
-					b2Vec2 pos = bodyDef.position;
-					bodyDef.position.Set(pos.x - box.m_HalfSize.x * transform.Scale.x, pos.y - box.m_HalfSize.y * transform.Scale.y);
-				}
-				else if (NEntity::HasComponent<Circle>(entity))
+			b2PolygonShape shape;
+			shape.SetAsBox(halfSize.x, halfSize.y, b2Vec2(center.x, center.y), 0.0f);
+			OverlapCallback callback(mask, &shape, b2Vec2(center.x, center.y), results, maxResults);
+
+			b2AABB aabb;
+			aabb.lowerBound.Set(center.x - halfSize.x, center.y - halfSize.y);
+			aabb.upperBound.Set(center.x + halfSize.x, center.y + halfSize.y);
+			m_World->QueryAABB(&callback, aabb);
+			return callback.m_NumResults;
+		}
+
+		int OverlapPoint(const glm::vec2& point, uint16 mask, entt::entity* results, int maxResults)
+		{
+			WaitForStep();
+			if (maxResults <= 0)
+			{
+				return 0;
+			}
+
+			OverlapCallback callback(mask, nullptr, b2Vec2(point.x, point.y), results, maxResults);
+			b2AABB aabb;
+			aabb.lowerBound.Set(point.x, point.y);
+			aabb.upperBound.Set(point.x, point.y);
+			m_World->QueryAABB(&callback, aabb);
+			return callback.m_NumResults;
+		}
+
+		void RaycastBatch(const Ray2D* rays, int numRays, uint16 mask, RaycastHit2D* hits)
+		{
+			WaitForStep();
+			if (numRays <= 0)
+			{
+				return;
+			}
+
+			{
+				std::unique_lock<std::mutex> lock(m_QueryMutex);
+				// A worker that woke up late for the last batch may still be checking for chunks
+				m_QueryFinished.wait(lock, [] { return m_NumBusyQueryWorkers == 0; });
+				m_BatchRays = rays;
+				m_BatchHits = hits;
+				m_BatchSize = numRays;
+				m_BatchMask = mask;
+				m_NextBatchRay = 0;
+				m_NumBatchRaysDone = 0;
+				if (numRays >= s_MinParallelRaycasts)
 				{
-					// TODO: IMPLEMENT ME
-					Circle& circle = NEntity::GetComponent<Circle>(entity);
+					m_BatchGeneration++;
 				}
+			}
+
+			// Small batches aren't worth waking the workers for
+			if (numRays >= s_MinParallelRaycasts)
+			{
+				m_QueryAvailable.notify_all();
+			}
+
+			RunRaycastChunks();
+
+			std::unique_lock<std::mutex> lock(m_QueryMutex);
+			m_QueryFinished.wait(lock, [] { return m_NumBatchRaysDone == m_BatchSize; });
+		}
 
-				body->CreateFixture(&shape, rb.m_Mass);
+		ContactEventSpan2D GetContactEvents()
+		{
+			const std::vector<ContactEvent2D>& events = m_ContactEvents[1 - m_ContactWriteBuffer];
+			return { events.data(), (int)events.size() };
+		}
+
+		ContactEventStats2D GetContactEventStats()
+		{
+			return m_ContactStats[1 - m_ContactWriteBuffer];
+		}
+
+		void SetContactEventMasks(uint16 mask, uint16 preSolveMask)
+		{
+			// The listener reads the masks while the world steps
+			WaitForStep();
+			m_ContactEventMask = mask;
+			m_PreSolveEventMask = preSolveMask;
+		}
+
+		void AddEntity(Entity entity)
+		{
+			Queue({ PhysicsCommandType::AddBody, entity.Scene, entity.Handle, glm::vec2(), 0.0f });
+		}
+
+		void RemoveEntity(Entity entity)
+		{
+			// The component forgets its body straight away, the body goes back to the pool at the next step boundary
+			if (NEntity::HasComponent<Rigidbody2D>(entity))
+			{
+				NEntity::GetComponent<Rigidbody2D>(entity).m_RawRigidbody = nullptr;
 			}
+			Queue({ PhysicsCommandType::RemoveBody, entity.Scene, entity.Handle, glm::vec2(), 0.0f });
+		}
+
+		void ApplyForce(Entity entity, const glm::vec2& force)
+		{
+			Queue({ PhysicsCommandType::ApplyForce, entity.Scene, entity.Handle, force, 0.0f });
+		}
+
+		void ApplyImpulse(Entity entity, const glm::vec2& impulse)
+		{
+			Queue({ PhysicsCommandType::ApplyImpulse, entity.Scene, entity.Handle, impulse, 0.0f });
+		}
+
+		void SetVelocity(Entity entity, const glm::vec2& velocity)
+		{
+			Queue({ PhysicsCommandType::SetVelocity, entity.Scene, entity.Handle, velocity, 0.0f });
+		}
+
+		void Teleport(Entity entity, const glm::vec2& position, float rotationDegrees)
+		{
+			Queue({ PhysicsCommandType::Teleport, entity.Scene, entity.Handle, position, rotationDegrees });
 		}
 
 		void Update(SceneData& scene, float dt)
 		{
+			// The step started last frame ran while that frame rendered, its poses are read back before anything else
+			// touches the world
+			WaitForStep();
+			if (m_PosesReady)
+			{
+				const StepBodies& front = m_StepBuffers[m_BackBuffer];
+				m_BackBuffer = 1 - m_BackBuffer;
+				m_PosesReady = false;
+				PullTransforms(scene, front);
+			}
+
+			// The finished steps' contacts become readable, the next step records over the ones read last frame
+			m_ContactWriteBuffer = 1 - m_ContactWriteBuffer;
+			m_ContactEvents[m_ContactWriteBuffer].clear();
+			m_ContactStats[m_ContactWriteBuffer] = ContactEventStats2D();
+
+			for (const PhysicsCommand& command : m_Commands)
+			{
+				ApplyCommand(command);
+			}
+			m_Commands.clear();
+			SyncDirty(scene);
+
+			const float timestep = Settings::Physics2D::s_Timestep;
 			m_PhysicsTime += dt;
-			while (m_PhysicsTime > 0.0f)
+			int numSteps = CMath::Min((int)(m_PhysicsTime / timestep), Settings::Physics2D::s_MaxSubsteps);
+			m_PhysicsTime -= numSteps * timestep;
+			if (m_PhysicsTime >= timestep)
+			{
+				// A long frame would need more steps than we can afford, so the simulation falls behind instead of
+				// spending even longer catching up next frame
+				m_PhysicsTime = glm::mod(m_PhysicsTime, timestep);
+			}
+			m_InterpolationAlpha = m_PhysicsTime / timestep;
+			m_NumPendingSteps = numSteps;
+		}
+
+		void StartStep(SceneData& scene)
+		{
+			if (m_NumPendingSteps <= 0 || m_StepInFlight)
 			{
-				m_World->Step(Settings::Physics2D::s_Timestep, Settings::Physics2D::s_VelocityIterations, Settings::Physics2D::s_PositionIterations);
-				m_PhysicsTime -= Settings::Physics2D::s_Timestep;
+				return;
 			}
 
-			auto view = scene.Registry.view<TransformData, Rigidbody2D>();
-			for (entt::entity rawEntity : view)
+			// Scripts may have added or removed bodies since Update, the step should already see them
+			SyncDirty(scene);
+			PushTransforms(scene);
+			GatherBodies(scene, m_StepBuffers[m_BackBuffer]);
+			m_StepInFlight = true;
 			{
-				Entity entity = { rawEntity, &scene };
-				TransformData& transform = NEntity::GetComponent<TransformData>(entity);
-				Rigidbody2D& rb = NEntity::GetComponent<Rigidbody2D>(entity);
-				b2Body* body = static_cast<b2Body*>(rb.m_RawRigidbody);
-				b2Vec2 position = body->GetPosition();
-				transform.Position.x = position.x;
-				transform.Position.y = position.y;
-				transform.EulerRotation.z = CMath::ToDegrees(body->GetAngle());
+				std::lock_guard<std::mutex> lock(m_StepMutex);
+				m_NumStepsRequested = m_NumPendingSteps;
 			}
+			m_NumPendingSteps = 0;
+			m_StepRequested.notify_one();
+		}
+
+		void WaitForStep()
+		{
+			if (!m_StepInFlight)
+			{
+				return;
+			}
+
+			std::unique_lock<std::mutex> lock(m_StepMutex);
+			m_StepFinished.wait(lock, [] { return m_NumStepsRequested == 0; });
+			m_StepInFlight = false;
+			m_PosesReady = true;
+		}
+
+		float GetInterpolationAlpha()
+		{
+			return m_InterpolationAlpha;
+		}
+
+		void GetInterpolatedPose(const TransformData& transform, const Rigidbody2D& rb, glm::vec3& position, float& rotationDegrees)
+		{
+			glm::vec2 current = glm::vec2(transform.Position.x, transform.Position.y);
+			glm::vec2 interpolated = glm::mix(rb.m_PreviousPosition, current, m_InterpolationAlpha);
+			position = glm::vec3(interpolated.x, interpolated.y, transform.Position.z);
+			rotationDegrees = glm::mix(rb.m_PreviousRotation, transform.EulerRotation.z, m_InterpolationAlpha);
 		}
 
 		void Serialize(json& j, Entity entity, const AABB& box)
@@ -167,6 +667,7 @@ namespace Cocoa
 			json velocity = CMath::Serialize("Velocity", rb.m_Velocity);
 			json continousCollision = { "ContinousCollision", rb.m_ContinuousCollision };
 			json fixedRotation = { "FixedRotation", rb.m_FixedRotation };
+			json bodyType = { "BodyType", (uint8)rb.m_BodyType };
 			int size = j["Components"].size();
 			j["Components"][size] = {
 				{"Rigidbody2D", {
@@ -176,11 +677,32 @@ namespace Cocoa
 					mass,
 					velocity,
 					continousCollision,
-					fixedRotation
+					fixedRotation,
+					bodyType
+				}}
+			};
+		}
+
+		void Serialize(json& j, Entity entity, const CollisionFilter2D& filter)
+		{
+			int size = j["Components"].size();
+			j["Components"][size] = {
+				{"CollisionFilter2D", {
+					{"Entity", NEntity::GetID(entity)},
+					{"Category", filter.m_Category},
+					{"Mask", filter.m_Mask}
 				}}
 			};
 		}
 
+		void DeserializeCollisionFilter2D(json& j, Entity entity)
+		{
+			CollisionFilter2D filter;
+			filter.m_Category = j["CollisionFilter2D"]["Category"];
+			filter.m_Mask = j["CollisionFilter2D"]["Mask"];
+			NEntity::AddComponent<CollisionFilter2D>(entity, filter);
+		}
+
 		void DeserializeRigidbody2D(json& j, Entity entity)
 		{
 			Rigidbody2D rb;
@@ -190,7 +712,658 @@ namespace Cocoa
 			rb.m_Velocity = CMath::DeserializeVec2(j["Rigidbody2D"]["Velocity"]);
 			rb.m_ContinuousCollision = j["Rigidbody2D"]["ContinousCollision"];
 			rb.m_FixedRotation = j["Rigidbody2D"]["FixedRotation"];
+
+			// Scenes saved before body types were serialized only had dynamic bodies
+			uint8 bodyType = (uint8)BodyType2D::Dynamic;
+			JsonExtended::AssignIfNotNull(j["Rigidbody2D"], "BodyType", bodyType);
+			rb.m_BodyType = (BodyType2D)bodyType;
 			NEntity::AddComponent<Rigidbody2D>(entity, rb);
 		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static void StepThreadLoop()
+		{
+			while (true)
+			{
+				int numSteps;
+				{
+					std::unique_lock<std::mutex> lock(m_StepMutex);
+					m_StepRequested.wait(lock, [] { return m_NumStepsRequested > 0 || !m_StepThreadRunning; });
+					if (!m_StepThreadRunning)
+					{
+						return;
+					}
+					numSteps = m_NumStepsRequested;
+				}
+
+				// The main thread leaves the world and the back buffer alone until the step is reported finished
+				StepBodies& back = m_StepBuffers[m_BackBuffer];
+				back.Poses.resize(back.Bodies.size());
+				for (int i = 0; i < numSteps; i++)
+				{
+					if (i == numSteps - 1)
+					{
+						// The interpolation alpha is a fraction of one step, so only the last step of a frame is blended
+						for (size_t j = 0; j < back.Bodies.size(); j++)
+						{
+							back.Poses[j].PreviousPosition = back.Bodies[j]->GetPosition();
+							back.Poses[j].PreviousAngle = back.Bodies[j]->GetAngle();
+						}
+					}
+					m_World->Step(Settings::Physics2D::s_Timestep, Settings::Physics2D::s_VelocityIterations, Settings::Physics2D::s_PositionIterations);
+
+					// Sensors and disabled contacts are never solved, their begin events keep an impulse of 0
+					m_UnsolvedBeginEvents.clear();
+				}
+
+				for (size_t i = 0; i < back.Bodies.size(); i++)
+				{
+					const b2Body* body = back.Bodies[i];
+					BodyPose& pose = back.Poses[i];
+					pose.Position = body->GetPosition();
+					pose.Angle = body->GetAngle();
+					pose.Awake = body->IsAwake();
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_StepMutex);
+					m_NumStepsRequested = 0;
+				}
+				m_StepFinished.notify_all();
+			}
+		}
+
+		template<typename Component>
+		static void ConnectEvents(entt::registry& registry)
+		{
+			registry.on_construct<Component>().template connect<&MarkDirty>();
+			registry.on_destroy<Component>().template connect<&MarkDirty>();
+		}
+
+		template<typename Component>
+		static void DisconnectEvents(entt::registry& registry)
+		{
+			registry.on_construct<Component>().template disconnect<&MarkDirty>();
+			registry.on_destroy<Component>().template disconnect<&MarkDirty>();
+		}
+
+		static void MarkDirty(entt::registry& registry, entt::entity entity)
+		{
+			// Components are still being added or removed, the entity is looked at once they're done
+			m_DirtyEntities.push_back(entity);
+		}
+
+		static void SyncDirty(SceneData& scene)
+		{
+			// Adding or removing several components queues the same entity more than once
+			std::sort(m_DirtyEntities.begin(), m_DirtyEntities.end());
+			m_DirtyEntities.erase(std::unique(m_DirtyEntities.begin(), m_DirtyEntities.end()), m_DirtyEntities.end());
+			for (entt::entity entity : m_DirtyEntities)
+			{
+				SyncEntity(scene, entity);
+			}
+			m_DirtyEntities.clear();
+		}
+
+		static void SyncEntity(SceneData& scene, entt::entity entity)
+		{
+			bool valid = scene.Registry.valid(entity);
+			Rigidbody2D* rb = valid ? scene.Registry.try_get<Rigidbody2D>(entity) : nullptr;
+			const TransformData* transform = valid ? scene.Registry.try_get<TransformData>(entity) : nullptr;
+			if (!rb || !transform)
+			{
+				if (rb)
+				{
+					rb->m_RawRigidbody = nullptr;
+				}
+				ReleaseBody(entity);
+				return;
+			}
+
+			auto iter = m_EntityBodies.find(entity);
+			if (iter == m_EntityBodies.end())
+			{
+				b2Body* body;
+				if (m_BodyPool.empty())
+				{
+					b2BodyDef bodyDef;
+					body = m_World->CreateBody(&bodyDef);
+				}
+				else
+				{
+					body = m_BodyPool.back();
+					m_BodyPool.pop_back();
+				}
+
+				ConfigureBody(body, *transform, *rb);
+				iter = m_EntityBodies.insert({ entity, { body, glm::vec2(), 0.0f, 0.0f, 0, 0, false } }).first;
+				m_BodyEntities[body] = entity;
+			}
+
+			// Also fixes up components restored from a snapshot, which may still point at an older body
+			BuildFixture(iter->second, scene, entity, *transform, *rb);
+			rb->m_RawRigidbody = iter->second.Body;
+		}
+
+		static void ConfigureBody(b2Body* body, const TransformData& transform, Rigidbody2D& rb)
+		{
+			if (rb.m_BodyType == BodyType2D::Dynamic)
+			{
+				body->SetType(b2BodyType::b2_dynamicBody);
+			}
+			else if (rb.m_BodyType == BodyType2D::Static)
+			{
+				body->SetType(b2BodyType::b2_staticBody);
+			}
+			else
+			{
+				body->SetType(b2BodyType::b2_kinematicBody);
+			}
+
+			body->SetTransform(b2Vec2(transform.Position.x, transform.Position.y), CMath::ToRadians(transform.EulerRotation.z));
+			body->SetLinearVelocity(b2Vec2(0.0f, 0.0f));
+			body->SetAngularVelocity(0.0f);
+			body->SetAngularDamping(rb.m_AngularDamping);
+			body->SetLinearDamping(rb.m_LinearDamping);
+			body->SetFixedRotation(rb.m_FixedRotation);
+			body->SetBullet(rb.m_ContinuousCollision);
+			if (rb.m_BodyType != BodyType2D::Static)
+			{
+				body->SetAwake(true);
+			}
+
+			rb.m_SyncedPosition = glm::vec2(transform.Position.x, transform.Position.y);
+			rb.m_SyncedRotation = transform.EulerRotation.z;
+			rb.m_PreviousPosition = rb.m_SyncedPosition;
+			rb.m_PreviousRotation = rb.m_SyncedRotation;
+		}
+
+		static void BuildFixture(BodyRecord& record, SceneData& scene, entt::entity entity, const TransformData& transform, const Rigidbody2D& rb)
+		{
+			// An entity with both shapes collides as its box
+			const Box2D* box = scene.Registry.try_get<Box2D>(entity);
+			const Circle* circle = box ? nullptr : scene.Registry.try_get<Circle>(entity);
+			const CollisionFilter2D* filter = scene.Registry.try_get<CollisionFilter2D>(entity);
+			glm::vec2 halfSize = box ? glm::abs(box->m_HalfSize * glm::vec2(transform.Scale.x, transform.Scale.y)) : glm::vec2();
+			float radius = circle ? circle->m_Radius * glm::max(glm::abs(transform.Scale.x), glm::abs(transform.Scale.y)) : 0.0f;
+			uint16 category = filter ? filter->m_Category : CollisionFilter2D().m_Category;
+			uint16 mask = filter ? filter->m_Mask : CollisionFilter2D().m_Mask;
+
+			// Shapes without any area can't be turned into a fixture
+			bool hasFixture = (halfSize.x > 0.0f && halfSize.y > 0.0f) || radius > 0.0f;
+			if (hasFixture == record.HasFixture && halfSize == record.HalfSize && radius == record.Radius &&
+				rb.m_Mass == record.Density && category == record.Category && mask == record.Mask)
+			{
+				return;
+			}
+
+			b2Body* body = record.Body;
+			while (body->GetFixtureList())
+			{
+				body->DestroyFixture(body->GetFixtureList());
+			}
+
+			if (hasFixture)
+			{
+				b2PolygonShape polygonShape;
+				b2CircleShape circleShape;
+				b2FixtureDef fixtureDef;
+				if (radius > 0.0f)
+				{
+					circleShape.m_radius = radius;
+					fixtureDef.shape = &circleShape;
+				}
+				else
+				{
+					polygonShape.SetAsBox(halfSize.x, halfSize.y);
+					fixtureDef.shape = &polygonShape;
+				}
+				fixtureDef.density = rb.m_Mass;
+				fixtureDef.filter.categoryBits = category;
+				fixtureDef.filter.maskBits = mask;
+				body->CreateFixture(&fixtureDef);
+			}
+			record = { body, halfSize, radius, rb.m_Mass, category, mask, hasFixture };
+		}
+
+		static void ReleaseBody(entt::entity entity)
+		{
+			auto iter = m_EntityBodies.find(entity);
+			if (iter == m_EntityBodies.end())
+			{
+				return;
+			}
+
+			// Parked bodies have no fixtures, so they're out of the broadphase and the solver never sees them
+			b2Body* body = iter->second.Body;
+			while (body->GetFixtureList())
+			{
+				body->DestroyFixture(body->GetFixtureList());
+			}
+			body->SetType(b2BodyType::b2_staticBody);
+			m_BodyEntities.erase(body);
+			m_EntityBodies.erase(iter);
+			m_BodyPool.push_back(body);
+		}
+
+		static void Queue(const PhysicsCommand& command)
+		{
+			// Outside of a running step the world can be changed right away
+			if (m_StepInFlight)
+			{
+				m_Commands.push_back(command);
+			}
+			else
+			{
+				ApplyCommand(command);
+			}
+		}
+
+		static void ApplyCommand(const PhysicsCommand& command)
+		{
+			if (command.Type == PhysicsCommandType::RemoveBody)
+			{
+				ReleaseBody(command.Entity);
+				return;
+			}
+
+			Entity entity = Entity{ command.Entity, command.Scene };
+			if (!command.Scene->Registry.valid(command.Entity))
+			{
+				return;
+			}
+
+			if (command.Type == PhysicsCommandType::AddBody)
+			{
+				SyncEntity(*command.Scene, command.Entity);
+				return;
+			}
+
+			// The body is looked up by entity, a component's raw pointer may have been copied from another entity's.
+			// Components added since the last step get their bodies first
+			SyncDirty(*command.Scene);
+			auto iter = m_EntityBodies.find(command.Entity);
+			Rigidbody2D* rb = command.Scene->Registry.try_get<Rigidbody2D>(command.Entity);
+			if (iter == m_EntityBodies.end() || !rb)
+			{
+				return;
+			}
+			b2Body* body = iter->second.Body;
+
+			b2Vec2 vector = b2Vec2(command.Vector.x, command.Vector.y);
+			switch (command.Type)
+			{
+			case PhysicsCommandType::ApplyForce:
+				body->ApplyForceToCenter(vector, true);
+				break;
+			case PhysicsCommandType::ApplyImpulse:
+				body->ApplyLinearImpulse(vector, body->GetWorldCenter(), true);
+				break;
+			case PhysicsCommandType::SetVelocity:
+				body->SetLinearVelocity(vector);
+				body->SetAwake(true);
+				break;
+			case PhysicsCommandType::Teleport:
+			{
+				body->SetTransform(vector, CMath::ToRadians(command.RotationDegrees));
+				body->SetAwake(true);
+				if (NEntity::HasComponent<TransformData>(entity))
+				{
+					TransformData& transform = NEntity::GetComponent<TransformData>(entity);
+					transform.Position.x = command.Vector.x;
+					transform.Position.y = command.Vector.y;
+					transform.EulerRotation.z = command.RotationDegrees;
+				}
+				rb->m_SyncedPosition = command.Vector;
+				rb->m_SyncedRotation = command.RotationDegrees;
+				rb->m_PreviousPosition = command.Vector;
+				rb->m_PreviousRotation = command.RotationDegrees;
+				break;
+			}
+			default:
+				break;
+			}
+		}
+
+		static void PushTransforms(SceneData& scene)
+		{
+			// The group owns both storages, so this walks two packed arrays in step instead of looking every entity up
+			auto group = scene.Registry.group<Rigidbody2D, TransformData>();
+			group.each([](Rigidbody2D& rb, TransformData& transform)
+			{
+				b2Body* body = static_cast<b2Body*>(rb.m_RawRigidbody);
+				if (!body || rb.m_BodyType == BodyType2D::Dynamic)
+				{
+					return;
+				}
+
+				// Kinematic and static bodies follow their transform, but only get moved when it changed
+				glm::vec2 position = glm::vec2(transform.Position.x, transform.Position.y);
+				if (position != rb.m_SyncedPosition || transform.EulerRotation.z != rb.m_SyncedRotation)
+				{
+					body->SetTransform(b2Vec2(position.x, position.y), CMath::ToRadians(transform.EulerRotation.z));
+					rb.m_SyncedPosition = position;
+					rb.m_SyncedRotation = transform.EulerRotation.z;
+
+					// Moved by hand, so it jumps instead of being interpolated
+					rb.m_PreviousPosition = position;
+					rb.m_PreviousRotation = transform.EulerRotation.z;
+				}
+			});
+		}
+
+		static void GatherBodies(SceneData& scene, StepBodies& back)
+		{
+			back.Entities.clear();
+			back.GroupIndices.clear();
+			back.Bodies.clear();
+
+			auto group = scene.Registry.group<Rigidbody2D, TransformData>();
+			const entt::entity* entities = group.data();
+			const Rigidbody2D* rigidbodies = group.raw<Rigidbody2D>();
+			for (uint32 i = 0; i < (uint32)group.size(); i++)
+			{
+				// Static bodies never move on their own
+				const Rigidbody2D& rb = rigidbodies[i];
+				if (rb.m_RawRigidbody && rb.m_BodyType != BodyType2D::Static)
+				{
+					back.Entities.push_back(entities[i]);
+					back.GroupIndices.push_back(i);
+					back.Bodies.push_back(static_cast<b2Body*>(rb.m_RawRigidbody));
+				}
+			}
+		}
+
+		static void PullTransforms(SceneData& scene, const StepBodies& front)
+		{
+			auto group = scene.Registry.group<Rigidbody2D, TransformData>();
+			const entt::entity* entities = group.data();
+			Rigidbody2D* rigidbodies = group.raw<Rigidbody2D>();
+			TransformData* transforms = group.raw<TransformData>();
+			const uint32 groupSize = (uint32)group.size();
+			for (size_t i = 0; i < front.Poses.size(); i++)
+			{
+				entt::entity entity = front.Entities[i];
+				uint32 index = front.GroupIndices[i];
+				Rigidbody2D* rb = nullptr;
+				TransformData* transform = nullptr;
+				if (index < groupSize && entities[index] == entity)
+				{
+					rb = &rigidbodies[index];
+					transform = &transforms[index];
+				}
+				else if (scene.Registry.valid(entity) && group.contains(entity))
+				{
+					// Something was added to or removed from the group since the step started
+					rb = &group.get<Rigidbody2D>(entity);
+					transform = &group.get<TransformData>(entity);
+				}
+
+				// Skip bodies that were removed or replaced while the step ran
+				if (!rb || rb->m_RawRigidbody != front.Bodies[i])
+				{
+					continue;
+				}
+
+				// Resting bodies haven't moved since they fell asleep, their last pose only has to stop interpolating
+				const BodyPose& pose = front.Poses[i];
+				if (!pose.Awake)
+				{
+					rb->m_PreviousPosition = rb->m_SyncedPosition;
+					rb->m_PreviousRotation = rb->m_SyncedRotation;
+					continue;
+				}
+
+				rb->m_PreviousPosition = glm::vec2(pose.PreviousPosition.x, pose.PreviousPosition.y);
+				rb->m_PreviousRotation = CMath::ToDegrees(pose.PreviousAngle);
+				transform->Position.x = pose.Position.x;
+				transform->Position.y = pose.Position.y;
+				transform->EulerRotation.z = CMath::ToDegrees(pose.Angle);
+				rb->m_SyncedPosition = glm::vec2(pose.Position.x, pose.Position.y);
+				rb->m_SyncedRotation = transform->EulerRotation.z;
+			}
+		}
+
+		static void QueryWorkerLoop()
+		{
+			uint32 lastGeneration = 0;
+			{
+				std::lock_guard<std::mutex> lock(m_QueryMutex);
+				lastGeneration = m_BatchGeneration;
+			}
+
+			while (true)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_QueryMutex);
+					m_QueryAvailable.wait(lock, [lastGeneration] { return m_BatchGeneration != lastGeneration || !m_QueryWorkersRunning; });
+					if (!m_QueryWorkersRunning)
+					{
+						return;
+					}
+					lastGeneration = m_BatchGeneration;
+					m_NumBusyQueryWorkers++;
+				}
+
+				RunRaycastChunks();
+
+				{
+					std::lock_guard<std::mutex> lock(m_QueryMutex);
+					m_NumBusyQueryWorkers--;
+				}
+				m_QueryFinished.notify_all();
+			}
+		}
+
+		static void RunRaycastChunks()
+		{
+			while (true)
+			{
+				int start = m_NextBatchRay.fetch_add(s_RaycastChunkSize);
+				if (start >= m_BatchSize)
+				{
+					return;
+				}
+
+				int end = CMath::Min(start + s_RaycastChunkSize, m_BatchSize);
+				for (int i = start; i < end; i++)
+				{
+					const Ray2D& ray = m_BatchRays[i];
+					m_BatchHits[i] = RaycastHit2D();
+					b2Vec2 point1, point2;
+					if (BuildRaycast(ray, point1, point2))
+					{
+						ClosestRaycastCallback callback(m_BatchMask, ray.m_Ignore.Handle);
+						m_World->RayCast(&callback, point1, point2);
+						m_BatchHits[i] = callback.m_Hit;
+					}
+				}
+
+				int numDone = end - start;
+				if (m_NumBatchRaysDone.fetch_add(numDone) + numDone == m_BatchSize)
+				{
+					// Taking the lock makes sure the main thread is either waiting or hasn't checked yet
+					std::lock_guard<std::mutex> lock(m_QueryMutex);
+					m_QueryFinished.notify_all();
+				}
+			}
+		}
+
+		static bool BuildRaycast(const Ray2D& ray, b2Vec2& point1, b2Vec2& point2)
+		{
+			// Box2D asserts on rays without any length
+			if (ray.m_MaxDistance <= 0.0f || glm::dot(ray.m_Direction, ray.m_Direction) <= 0.0f)
+			{
+				return false;
+			}
+
+			glm::vec2 end = ray.m_Origin + glm::normalize(ray.m_Direction) * ray.m_MaxDistance;
+			point1.Set(ray.m_Origin.x, ray.m_Origin.y);
+			point2.Set(end.x, end.y);
+			return true;
+		}
+
+		static bool RecordContact(ContactEventType2D type, b2Contact* contact, uint16 mask)
+		{
+			const b2Fixture* fixtureA = contact->GetFixtureA();
+			const b2Fixture* fixtureB = contact->GetFixtureB();
+			ContactEventStats2D& stats = m_ContactStats[m_ContactWriteBuffer];
+			if (!PassesFilter(fixtureA, mask) && !PassesFilter(fixtureB, mask))
+			{
+				stats.m_NumFilteredEvents++;
+				return false;
+			}
+
+			// Contacts that stopped touching have no points left, and then no normal either
+			b2WorldManifold worldManifold;
+			worldManifold.normal.SetZero();
+			contact->GetWorldManifold(&worldManifold);
+			// Only pre-solve has impulses in the manifold, begin events get theirs once the contact is solved
+			float normalImpulse = 0.0f;
+			if (type == ContactEventType2D::PreSolve)
+			{
+				const b2Manifold* manifold = contact->GetManifold();
+				for (int i = 0; i < manifold->pointCount; i++)
+				{
+					normalImpulse += manifold->points[i].normalImpulse;
+				}
+			}
+
+			ContactEvent2D event;
+			event.m_Type = type;
+			event.m_EntityA = GetBodyEntity(fixtureA->GetBody());
+			event.m_EntityB = GetBodyEntity(fixtureB->GetBody());
+			event.m_Normal = glm::vec2(worldManifold.normal.x, worldManifold.normal.y);
+			event.m_NormalImpulse = normalImpulse;
+			m_ContactEvents[m_ContactWriteBuffer].push_back(event);
+
+			if (type == ContactEventType2D::Begin)
+			{
+				stats.m_NumBeginEvents++;
+			}
+			else if (type == ContactEventType2D::End)
+			{
+				stats.m_NumEndEvents++;
+			}
+			else
+			{
+				stats.m_NumPreSolveEvents++;
+			}
+			return true;
+		}
+
+		static void ClearContactEvents()
+		{
+			for (int i = 0; i < 2; i++)
+			{
+				m_ContactEvents[i].clear();
+				m_ContactStats[i] = ContactEventStats2D();
+			}
+		}
+
+		void ContactListener::BeginContact(b2Contact* contact)
+		{
+			if (RecordContact(ContactEventType2D::Begin, contact, m_ContactEventMask))
+			{
+				m_UnsolvedBeginEvents[contact] = m_ContactEvents[m_ContactWriteBuffer].size() - 1;
+			}
+		}
+
+		void ContactListener::EndContact(b2Contact* contact)
+		{
+			RecordContact(ContactEventType2D::End, contact, m_ContactEventMask);
+		}
+
+		void ContactListener::PreSolve(b2Contact* contact, const b2Manifold* oldManifold)
+		{
+			// The manifold's impulses were carried over from the previous step to warm start the solver
+			if (m_PreSolveEventMask != 0)
+			{
+				RecordContact(ContactEventType2D::PreSolve, contact, m_PreSolveEventMask);
+			}
+		}
+
+		void ContactListener::PostSolve(b2Contact* contact, const b2ContactImpulse* impulse)
+		{
+			// Contacts are solved every step they touch, only the first solve after a begin event is reported
+			auto iter = m_UnsolvedBeginEvents.find(contact);
+			if (iter == m_UnsolvedBeginEvents.end())
+			{
+				return;
+			}
+
+			float normalImpulse = 0.0f;
+			for (int i = 0; i < impulse->count; i++)
+			{
+				normalImpulse += impulse->normalImpulses[i];
+			}
+			m_ContactEvents[m_ContactWriteBuffer][iter->second].m_NormalImpulse = normalImpulse;
+			m_UnsolvedBeginEvents.erase(iter);
+		}
+
+		static bool PassesFilter(const b2Fixture* fixture, uint16 mask)
+		{
+			return (fixture->GetFilterData().categoryBits & mask) != 0;
+		}
+
+		static entt::entity GetBodyEntity(const b2Body* body)
+		{
+			// Only read while the world isn't changing, so the query workers can share it
+			auto iter = m_BodyEntities.find(body);
+			return iter != m_BodyEntities.end() ? iter->second : entt::null;
+		}
+
+		float ClosestRaycastCallback::ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction)
+		{
+			entt::entity entity = GetBodyEntity(fixture->GetBody());
+			if (!PassesFilter(fixture, m_Mask) || entity == entt::null || entity == m_Ignore)
+			{
+				// Skip this fixture and keep the ray going
+				return -1.0f;
+			}
+
+			m_Hit = { entity, glm::vec2(point.x, point.y), glm::vec2(normal.x, normal.y), fraction };
+			return fraction;
+		}
+
+		float AllRaycastCallback::ReportFixture(b2Fixture* fixture, const b2Vec2& point, const b2Vec2& normal, float fraction)
+		{
+			entt::entity entity = GetBodyEntity(fixture->GetBody());
+			if (PassesFilter(fixture, m_Mask) && entity != entt::null && entity != m_Ignore)
+			{
+				m_Hits.push_back({ entity, glm::vec2(point.x, point.y), glm::vec2(normal.x, normal.y), fraction });
+			}
+			return 1.0f;
+		}
+
+		bool OverlapCallback::ReportFixture(b2Fixture* fixture)
+		{
+			entt::entity entity = GetBodyEntity(fixture->GetBody());
+			if (!PassesFilter(fixture, m_Mask) || entity == entt::null)
+			{
+				return true;
+			}
+
+			bool overlaps = false;
+			if (m_Shape)
+			{
+				b2Transform identity;
+				identity.SetIdentity();
+				overlaps = b2TestOverlap(m_Shape, 0, fixture->GetShape(), 0, identity, fixture->GetBody()->GetTransform());
+			}
+			else
+			{
+				overlaps = fixture->TestPoint(m_Point);
+			}
+
+			// Bodies only have a single fixture, so an entity is never reported twice
+			if (overlaps)
+			{
+				m_Results[m_NumResults++] = entity;
+			}
+			return m_NumResults < m_MaxResults;
+		}
 	}
-}
\ No newline at end of file
+}
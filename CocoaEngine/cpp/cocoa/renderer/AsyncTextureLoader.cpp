@@ -0,0 +1,319 @@
+#include "externalLibs.h"
+
+#include "cocoa/renderer/AsyncTextureLoader.h"
+#include "cocoa/core/AssetManager.h"
+#include "cocoa/renderer/TextureCooker.h"
+#include "cocoa/renderer/TextureStreamer.h"
+#include "cocoa/util/CMath.h"
+#include "cocoa/util/Log.h"
+
+#include <stb_image.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace Cocoa
+{
+	namespace AsyncTextureLoader
+	{
+		struct DecodeJob
+		{
+			Handle<Texture> TextureHandle;
+			std::string Path;
+			uint32 Generation;
+			CompressionQuality Compression;
+			bool GenerateMips;
+		};
+
+		struct DecodedTexture
+		{
+			Handle<Texture> TextureHandle;
+			std::string Path;
+			uint32 Generation;
+			uint8* Pixels;
+			int Width;
+			int Height;
+			int Channels;
+
+			// Set instead of Pixels when the texture was cooked into a compressed format or a mip chain
+			CookedTexture Cooked;
+			bool GenerateMips;
+		};
+
+		// Internal Variables
+		static const int NUM_PIXEL_BUFFERS = 4;
+
+		static std::vector<std::thread> m_Workers;
+		static std::mutex m_Mutex;
+		static std::condition_variable m_JobAvailable;
+		static std::condition_variable m_JobFinished;
+		static std::deque<DecodeJob> m_Jobs;
+		static std::deque<DecodedTexture> m_Decoded;
+		static std::vector<uint32> m_PendingHandles;
+		static uint32 m_Generation = 0;
+		static bool m_Running = false;
+
+		static uint32 m_PixelBuffers[NUM_PIXEL_BUFFERS];
+		static int m_NextPixelBuffer = 0;
+
+		// Forward Declarations
+		static void WorkerLoop();
+		static void UploadDecoded(DecodedTexture& decoded);
+		static void RemovePending(Handle<Texture> textureHandle);
+
+		void Init(int numThreads)
+		{
+			Log::Assert(!m_Running, "Tried to initialize the async texture loader twice.");
+			if (numThreads <= 0)
+			{
+				// Leave the main thread and one other core free
+				numThreads = CMath::Max((int)std::thread::hardware_concurrency() - 2, 1);
+			}
+
+			glGenBuffers(NUM_PIXEL_BUFFERS, m_PixelBuffers);
+			m_NextPixelBuffer = 0;
+
+			m_Running = true;
+			for (int i = 0; i < numThreads; i++)
+			{
+				m_Workers.push_back(std::thread(WorkerLoop));
+			}
+		}
+
+		void Destroy()
+		{
+			CancelAll();
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Running = false;
+			}
+			m_JobAvailable.notify_all();
+
+			for (auto& worker : m_Workers)
+			{
+				worker.join();
+			}
+			m_Workers.clear();
+
+			glDeleteBuffers(NUM_PIXEL_BUFFERS, m_PixelBuffers);
+		}
+
+		void Queue(Handle<Texture> textureHandle, const CPath& path, CompressionQuality compression, bool generateMips)
+		{
+			Log::Assert(m_Running, "Async texture loader must be initialized before queueing textures.");
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Jobs.push_back({ textureHandle, path.Path, m_Generation, compression, generateMips });
+				m_PendingHandles.push_back(textureHandle.m_AssetId);
+			}
+			m_JobAvailable.notify_one();
+		}
+
+		void Update(int maxUploads)
+		{
+			int numUploads = 0;
+			while (maxUploads <= 0 || numUploads < maxUploads)
+			{
+				DecodedTexture decoded;
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					if (m_Decoded.empty())
+					{
+						break;
+					}
+
+					decoded = m_Decoded.front();
+					m_Decoded.pop_front();
+				}
+
+				UploadDecoded(decoded);
+				numUploads++;
+			}
+		}
+
+		void WaitAll()
+		{
+			while (NumPending() > 0)
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					m_JobFinished.wait(lock, [] { return !m_Decoded.empty() || m_PendingHandles.empty(); });
+				}
+				Update(0);
+			}
+		}
+
+		void CancelAll()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Generation++;
+			m_Jobs.clear();
+			for (auto& decoded : m_Decoded)
+			{
+				stbi_image_free(decoded.Pixels);
+			}
+			m_Decoded.clear();
+			m_PendingHandles.clear();
+		}
+
+		bool IsLoading(Handle<Texture> textureHandle)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return std::find(m_PendingHandles.begin(), m_PendingHandles.end(), textureHandle.m_AssetId) != m_PendingHandles.end();
+		}
+
+		int NumPending()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return (int)m_PendingHandles.size();
+		}
+
+		static void WorkerLoop()
+		{
+			while (true)
+			{
+				DecodeJob job;
+				{
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					m_JobAvailable.wait(lock, [] { return !m_Jobs.empty() || !m_Running; });
+					if (!m_Running)
+					{
+						return;
+					}
+
+					job = m_Jobs.front();
+					m_Jobs.pop_front();
+				}
+
+				DecodedTexture decoded;
+				decoded.TextureHandle = job.TextureHandle;
+				decoded.Path = job.Path;
+				decoded.Generation = job.Generation;
+				decoded.Pixels = nullptr;
+				decoded.GenerateMips = job.GenerateMips;
+				bool shouldCook = job.Compression != CompressionQuality::None || job.GenerateMips;
+				if (shouldCook && !TextureCooker::Cook(NCPath::CreatePath(job.Path), job.Compression, decoded.Cooked, job.GenerateMips))
+				{
+					Log::Warning("Failed to cook texture '%s', loading it uncompressed instead.", job.Path.c_str());
+				}
+
+				if (decoded.Cooked.Data.empty())
+				{
+					decoded.Pixels = TextureUtil::LoadPixels(NCPath::CreatePath(job.Path), &decoded.Width, &decoded.Height, &decoded.Channels);
+					if (!decoded.Pixels)
+					{
+						Log::Warning("STB failed to load image: %s\n-> STB Failure Reason: %s", job.Path.c_str(), stbi_failure_reason());
+					}
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					if (decoded.Generation == m_Generation)
+					{
+						m_Decoded.push_back(decoded);
+					}
+					else if (decoded.Pixels)
+					{
+						// The assets were cleared while this texture was decoding
+						stbi_image_free(decoded.Pixels);
+					}
+				}
+				m_JobFinished.notify_all();
+			}
+		}
+
+		static void UploadDecoded(DecodedTexture& decoded)
+		{
+			RemovePending(decoded.TextureHandle);
+			bool isCooked = !decoded.Cooked.Data.empty();
+			if (!decoded.Pixels && !isCooked)
+			{
+				return;
+			}
+
+			// The texture may have been unloaded while it was decoding
+			bool canUpload = AssetManager::IsValid(decoded.TextureHandle);
+			Texture* texture = canUpload ? &AssetManager::s_Textures[decoded.TextureHandle.Index()] : nullptr;
+			if (canUpload && decoded.GenerateMips && isCooked)
+			{
+				// Mip chains are owned by the streamer, which uploads only the levels that are needed
+				TextureStreamer::Register(decoded.TextureHandle, decoded.Cooked);
+				return;
+			}
+			else if (canUpload && isCooked)
+			{
+				texture->InternalFormat = decoded.Cooked.Format;
+				texture->ExternalFormat = decoded.Cooked.Format;
+				texture->Width = decoded.Cooked.Width;
+				texture->Height = decoded.Cooked.Height;
+			}
+			else if (canUpload)
+			{
+				canUpload = TextureUtil::SetFormatFromChannels(*texture, decoded.Channels);
+				texture->Width = decoded.Width;
+				texture->Height = decoded.Height;
+			}
+
+			if (!canUpload)
+			{
+				if (decoded.Pixels)
+				{
+					stbi_image_free(decoded.Pixels);
+				}
+				return;
+			}
+
+			const uint8* data = isCooked ? decoded.Cooked.Data.data() : decoded.Pixels;
+			size_t numBytes = isCooked ?
+				decoded.Cooked.Data.size() :
+				(size_t)decoded.Width * (size_t)decoded.Height * (size_t)decoded.Channels;
+
+			// Orphan the buffer before mapping it so we never wait on the GPU to finish with a previous upload
+			uint32 pixelBuffer = m_PixelBuffers[m_NextPixelBuffer];
+			m_NextPixelBuffer = (m_NextPixelBuffer + 1) % NUM_PIXEL_BUFFERS;
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+			glBufferData(GL_PIXEL_UNPACK_BUFFER, numBytes, nullptr, GL_STREAM_DRAW);
+			void* mappedBuffer = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, numBytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+			if (mappedBuffer)
+			{
+				memcpy(mappedBuffer, data, numBytes);
+				glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+				// With an unpack buffer bound, the pixel pointer is an offset into the buffer
+				data = nullptr;
+			}
+			else
+			{
+				Log::Warning("Failed to map pixel buffer, uploading '%s' directly.", decoded.Path.c_str());
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			}
+
+			if (isCooked)
+			{
+				TextureUtil::UploadCompressed(*texture, data, (uint32)numBytes);
+			}
+			else
+			{
+				TextureUtil::Upload(*texture, data);
+			}
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+			if (decoded.Pixels)
+			{
+				stbi_image_free(decoded.Pixels);
+			}
+		}
+
+		static void RemovePending(Handle<Texture> textureHandle)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			auto iter = std::find(m_PendingHandles.begin(), m_PendingHandles.end(), textureHandle.m_AssetId);
+			if (iter != m_PendingHandles.end())
+			{
+				m_PendingHandles.erase(iter);
+			}
+		}
+	}
+}
@@ -48,7 +48,7 @@ namespace Cocoa
 
 		void BeginFrame()
 		{
-			if (m_Shader.IsNull())
+			if (!AssetManager::IsValid(m_Shader))
 			{
 				CPath shaderPath = Settings::General::s_EngineAssetsPath;
 				NCPath::Join(shaderPath, NCPath::CreatePath("shaders/SpriteRenderer.glsl"));
@@ -64,7 +64,7 @@ namespace Cocoa
 			AddLinesToBatches();
 			AddSpritesToBatches();
 
-			const Shader& shaderRef = AssetManager::GetShader(m_Shader.m_AssetId);
+			const Shader& shaderRef = AssetManager::GetShader(m_Shader);
 			NShader::Bind(shaderRef);
 			NShader::UploadMat4(shaderRef, "uProjection", camera.ProjectionMatrix);
 			NShader::UploadMat4(shaderRef, "uView", camera.ViewMatrix);
@@ -84,7 +84,7 @@ namespace Cocoa
 
 		void DrawTopBatches(const Camera& camera)
 		{
-			const Shader& shaderRef = AssetManager::GetShader(m_Shader.m_AssetId);
+			const Shader& shaderRef = AssetManager::GetShader(m_Shader);
 			NShader::Bind(shaderRef);
 			NShader::UploadMat4(shaderRef, "uProjection", camera.ProjectionMatrix);
 			NShader::UploadMat4(shaderRef, "uView", camera.ViewMatrix);
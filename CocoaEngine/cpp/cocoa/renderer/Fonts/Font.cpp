@@ -1,8 +1,10 @@
 #include "cocoa/renderer/fonts/Font.h"
 #include "cocoa/renderer/fonts/FontUtil.h"
+#include "cocoa/renderer/fonts/FontCooker.h"
 #include "cocoa/core/AssetManager.h"
 #include "cocoa/core/Memory.h"
 #include "cocoa/util/JsonExtended.h"
+#include "cocoa/util/Log.h"
 
 #include <stb/stb_image.h>
 #include <stb/stb_image_write.h>
@@ -41,13 +43,26 @@ namespace Cocoa
 		}
 	}
 
-	void Font::GenerateSdf(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution)
+	void Font::GenerateSdf(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution, FontSdfType sdfType)
 	{
+		m_SdfType = sdfType;
 		m_GlyphRangeStart = glyphRangeStart;
 		m_GlyphRangeEnd = glyphRangeEnd;
 		m_CharacterMap = (CharInfo*)AllocMem(sizeof(CharInfo) * (glyphRangeEnd - glyphRangeStart));
 		m_CharacterMapSize = glyphRangeEnd - glyphRangeStart;
-		FontUtil::CreateSdfFontTexture(fontFile, fontSize, m_CharacterMap, (glyphRangeEnd - glyphRangeStart), outputFile, padding, upscaleResolution, glyphRangeStart);
+
+		// Importing a font file with settings it was imported with before restores the cooked atlas instead
+		uint64 importHash = FontCooker::HashImport(fontFile, fontSize, glyphRangeStart, glyphRangeEnd, padding, upscaleResolution, sdfType);
+		if (importHash != 0 && FontCooker::ReadCache(importHash, m_CharacterMap, m_CharacterMapSize, outputFile))
+		{
+			return;
+		}
+
+		FontUtil::CreateSdfFontTexture(fontFile, fontSize, m_CharacterMap, (glyphRangeEnd - glyphRangeStart), outputFile, padding, upscaleResolution, glyphRangeStart, sdfType);
+		if (importHash != 0 && !FontCooker::WriteCache(importHash, m_CharacterMap, m_CharacterMapSize, outputFile))
+		{
+			Log::Warning("Failed to write cooked font for '%s'.", fontFile.Path.c_str());
+		}
 	}
 
 	json Font::Serialize() const
@@ -70,9 +85,10 @@ namespace Cocoa
 			};
 		}
 
-		res["FontTextureId"] = m_FontTexture.m_AssetId;
+		res["FontTextureId"] = AssetManager::GetResourceId(m_FontTexture);
 		res["GlyphRangeStart"] = m_GlyphRangeStart;
 		res["GlyphRangeEnd"] = m_GlyphRangeEnd;
+		res["SdfType"] = (int)m_SdfType;
 		res["Filepath"] = m_Path.Path.c_str();
 		return res;
 	}
@@ -107,9 +123,12 @@ namespace Cocoa
 			}
 		}
 
-		JsonExtended::AssignIfNotNull(j, "FontTextureId", m_FontTexture.m_AssetId);
+		uint32 fontTextureId = (uint32)-1;
+		JsonExtended::AssignIfNotNull(j, "FontTextureId", fontTextureId);
+		m_FontTexture = AssetManager::GetSceneTexture(fontTextureId);
 		JsonExtended::AssignIfNotNull(j, "GlyphRangeStart", m_GlyphRangeStart);
 		JsonExtended::AssignIfNotNull(j, "GlyphRangeEnd", m_GlyphRangeEnd);
+		JsonExtended::AssignEnumIfNotNull<FontSdfType>(j, "SdfType", m_SdfType);
 		JsonExtended::AssignIfNotNull(j, "Filepath", m_Path);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+#include "externalLibs.h"
+
+#include "cocoa/renderer/Fonts/FontCooker.h"
+#include "cocoa/renderer/TextureCooker.h"
+#include "cocoa/file/File.h"
+#include "cocoa/file/PackFile.h"
+#include "cocoa/util/Settings.h"
+#include "cocoa/util/Log.h"
+
+namespace Cocoa
+{
+	namespace FontCooker
+	{
+		struct FontImportKey
+		{
+			uint64 SourceHash;
+			int32 Version;
+			int32 FontSize;
+			int32 GlyphRangeStart;
+			int32 GlyphRangeEnd;
+			int32 Padding;
+			int32 UpscaleResolution;
+			int32 SdfType;
+		};
+
+		struct CookedFontHeader
+		{
+			uint32 Magic;
+			uint32 Version;
+			uint64 ImportHash;
+			int32 CharacterMapSize;
+			uint32 AtlasSize;
+		};
+
+		// Internal Variables
+		static const uint32 COOKED_FONT_MAGIC = 0x544E4643; // "CFNT"
+		static const uint32 COOKED_FONT_VERSION = 1;
+
+		// Forward Declarations
+		static FileHandle* OpenIfExists(const CPath& path);
+
+		uint64 HashImport(const CPath& fontFile, int fontSize, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution, FontSdfType sdfType)
+		{
+			FileHandle* file = OpenIfExists(fontFile);
+			if (!file)
+			{
+				return 0;
+			}
+
+			// Zeroed first so the struct padding can't change the hash
+			FontImportKey key;
+			memset(&key, 0, sizeof(FontImportKey));
+			key.SourceHash = TextureCooker::HashBytes((const uint8*)file->m_Data, file->m_Size);
+			key.Version = COOKED_FONT_VERSION;
+			key.FontSize = fontSize;
+			key.GlyphRangeStart = glyphRangeStart;
+			key.GlyphRangeEnd = glyphRangeEnd;
+			key.Padding = padding;
+			key.UpscaleResolution = upscaleResolution;
+			key.SdfType = (int32)sdfType;
+			File::CloseFile(file);
+
+			return TextureCooker::HashBytes((const uint8*)&key, sizeof(FontImportKey));
+		}
+
+		bool ReadCache(uint64 importHash, CharInfo* characterMap, int characterMapSize, const CPath& outputFile)
+		{
+			CPath cachePath = GetCachePath(importHash);
+			FileHandle* file = OpenIfExists(cachePath);
+			if (!file)
+			{
+				return false;
+			}
+
+			CookedFontHeader header;
+			size_t metricsSize = sizeof(CharInfo) * characterMapSize;
+			bool isValid = file->m_Size >= sizeof(CookedFontHeader);
+			if (isValid)
+			{
+				memcpy(&header, file->m_Data, sizeof(CookedFontHeader));
+				isValid = header.Magic == COOKED_FONT_MAGIC && header.Version == COOKED_FONT_VERSION && header.ImportHash == importHash &&
+					header.CharacterMapSize == characterMapSize && header.AtlasSize > 0 &&
+					file->m_Size == sizeof(CookedFontHeader) + metricsSize + header.AtlasSize;
+			}
+
+			if (!isValid)
+			{
+				Log::Warning("Ignoring stale or corrupt cooked font '%s'.", cachePath.Path.c_str());
+				File::CloseFile(file);
+				return false;
+			}
+
+			const uint8* metrics = (const uint8*)file->m_Data + sizeof(CookedFontHeader);
+			bool wroteAtlas = File::WriteFile(metrics + metricsSize, header.AtlasSize, outputFile);
+			if (wroteAtlas)
+			{
+				memcpy(characterMap, metrics, metricsSize);
+			}
+			File::CloseFile(file);
+
+			return wroteAtlas;
+		}
+
+		bool WriteCache(uint64 importHash, const CharInfo* characterMap, int characterMapSize, const CPath& atlasFile)
+		{
+			FileHandle* atlas = OpenIfExists(atlasFile);
+			if (!atlas)
+			{
+				return false;
+			}
+
+			CookedFontHeader header;
+			header.Magic = COOKED_FONT_MAGIC;
+			header.Version = COOKED_FONT_VERSION;
+			header.ImportHash = importHash;
+			header.CharacterMapSize = characterMapSize;
+			header.AtlasSize = atlas->m_Size;
+
+			size_t metricsSize = sizeof(CharInfo) * characterMapSize;
+			std::vector<uint8> cookedFile(sizeof(CookedFontHeader) + metricsSize + atlas->m_Size);
+			memcpy(cookedFile.data(), &header, sizeof(CookedFontHeader));
+			memcpy(cookedFile.data() + sizeof(CookedFontHeader), characterMap, metricsSize);
+			memcpy(cookedFile.data() + sizeof(CookedFontHeader) + metricsSize, atlas->m_Data, atlas->m_Size);
+			File::CloseFile(atlas);
+
+			return File::WriteFile(cookedFile.data(), (uint32)cookedFile.size(), GetCachePath(importHash));
+		}
+
+		CPath GetCacheDirectory()
+		{
+			CPath cacheDirectory = Settings::General::s_WorkingDirectory;
+			NCPath::Join(cacheDirectory, NCPath::CreatePath(".cache"));
+			File::CreateDirIfNotExists(cacheDirectory);
+			NCPath::Join(cacheDirectory, NCPath::CreatePath("fonts"));
+			File::CreateDirIfNotExists(cacheDirectory);
+			return cacheDirectory;
+		}
+
+		CPath GetCachePath(uint64 importHash)
+		{
+			char filename[64];
+			snprintf(filename, sizeof(filename), "%016llx.cfnt", (unsigned long long)importHash);
+
+			CPath cachePath = GetCacheDirectory();
+			NCPath::Join(cachePath, NCPath::CreatePath(filename));
+			return cachePath;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static FileHandle* OpenIfExists(const CPath& path)
+		{
+			if (!File::IsFile(path) && !PackFile::Find(path))
+			{
+				return nullptr;
+			}
+
+			FileHandle* file = File::OpenFile(path);
+			if (!file->m_Data)
+			{
+				File::CloseFile(file);
+				return nullptr;
+			}
+
+			return file;
+		}
+	}
+}
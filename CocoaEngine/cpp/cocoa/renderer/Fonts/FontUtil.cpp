@@ -2,9 +2,12 @@
 #include "cocoa/util/CMath.h"
 #include "cocoa/util/Log.h"
 #include "cocoa/core/Memory.h"
+#include "cocoa/file/PackFile.h"
 
 #include "stb/stb_image_write.h"
 
+#include FT_OUTLINE_H
+
 // TODO: CONSIDER WRITING MY OWN THREAD LIBRARY?
 #include <thread>
 
@@ -110,7 +113,440 @@ namespace Cocoa
 			};
 		}
 
-		static void fillSdfBitmaps(int begin, int end, SdfBitmapContainer* arr, const char* fontFile, int fontSize, int padding, int upscaleResolution, int glyphOffset)
+		// ---------------------------------------------------------------------
+		// Multi-channel sdf internals
+		// ---------------------------------------------------------------------
+		enum MsdfColor : uint8
+		{
+			MsdfBlack = 0,
+			MsdfRed = 1,
+			MsdfGreen = 2,
+			MsdfBlue = 4,
+			MsdfYellow = MsdfRed | MsdfGreen,
+			MsdfMagenta = MsdfRed | MsdfBlue,
+			MsdfCyan = MsdfGreen | MsdfBlue,
+			MsdfWhite = MsdfRed | MsdfGreen | MsdfBlue
+		};
+
+		struct MsdfEdge
+		{
+			glm::vec2 Points[4];
+			int Degree; // 1 = line, 2 = quadratic bezier, 3 = cubic bezier
+			uint8 Color;
+
+			// Sub-range of the curve this edge covers, edges get split when colouring teardrop contours
+			float T0;
+			float T1;
+		};
+
+		struct MsdfSegment
+		{
+			glm::vec2 Start;
+			glm::vec2 End;
+			uint8 Color;
+			bool ExtendStart;
+			bool ExtendEnd;
+		};
+
+		typedef std::vector<MsdfEdge> MsdfContour;
+
+		struct MsdfDecomposeContext
+		{
+			std::vector<MsdfContour>* Contours;
+			glm::vec2 Position;
+		};
+
+		static float Cross(const glm::vec2& a, const glm::vec2& b)
+		{
+			return a.x * b.y - a.y * b.x;
+		}
+
+		static glm::vec2 EdgePoint(const MsdfEdge& edge, float t)
+		{
+			t = edge.T0 + (edge.T1 - edge.T0) * t;
+			float s = 1.0f - t;
+			switch (edge.Degree)
+			{
+			case 1:
+				return edge.Points[0] * s + edge.Points[1] * t;
+			case 2:
+				return edge.Points[0] * (s * s) + edge.Points[1] * (2.0f * s * t) + edge.Points[2] * (t * t);
+			default:
+				return edge.Points[0] * (s * s * s) + edge.Points[1] * (3.0f * s * s * t) + edge.Points[2] * (3.0f * s * t * t) + edge.Points[3] * (t * t * t);
+			}
+		}
+
+		static glm::vec2 EdgeDirection(const MsdfEdge& edge, float t)
+		{
+			t = edge.T0 + (edge.T1 - edge.T0) * t;
+			float s = 1.0f - t;
+			glm::vec2 direction;
+			switch (edge.Degree)
+			{
+			case 1:
+				direction = edge.Points[1] - edge.Points[0];
+				break;
+			case 2:
+				direction = (edge.Points[1] - edge.Points[0]) * (2.0f * s) + (edge.Points[2] - edge.Points[1]) * (2.0f * t);
+				break;
+			default:
+				direction = (edge.Points[1] - edge.Points[0]) * (3.0f * s * s) + (edge.Points[2] - edge.Points[1]) * (6.0f * s * t) + (edge.Points[3] - edge.Points[2]) * (3.0f * t * t);
+				break;
+			}
+
+			// Control points that sit on an end point give a zero derivative, fall back to the chord
+			if (glm::length2(direction) < 1e-12f)
+			{
+				direction = edge.Points[edge.Degree] - edge.Points[0];
+			}
+			return direction;
+		}
+
+		static glm::vec2 FromFtVector(const FT_Vector* vector)
+		{
+			return glm::vec2((float)vector->x / 64.0f, (float)vector->y / 64.0f);
+		}
+
+		static void AddEdge(MsdfDecomposeContext* context, int degree, const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3)
+		{
+			if (context->Contours->empty())
+			{
+				context->Contours->emplace_back();
+			}
+
+			MsdfEdge edge = { { context->Position, p1, p2, p3 }, degree, MsdfWhite, 0.0f, 1.0f };
+			context->Contours->back().push_back(edge);
+			context->Position = edge.Points[degree];
+		}
+
+		static int MsdfMoveTo(const FT_Vector* to, void* user)
+		{
+			MsdfDecomposeContext* context = (MsdfDecomposeContext*)user;
+			context->Contours->emplace_back();
+			context->Position = FromFtVector(to);
+			return 0;
+		}
+
+		static int MsdfLineTo(const FT_Vector* to, void* user)
+		{
+			MsdfDecomposeContext* context = (MsdfDecomposeContext*)user;
+			glm::vec2 end = FromFtVector(to);
+			if (end != context->Position)
+			{
+				AddEdge(context, 1, end, glm::vec2(), glm::vec2());
+			}
+			return 0;
+		}
+
+		static int MsdfConicTo(const FT_Vector* control, const FT_Vector* to, void* user)
+		{
+			MsdfDecomposeContext* context = (MsdfDecomposeContext*)user;
+			AddEdge(context, 2, FromFtVector(control), FromFtVector(to), glm::vec2());
+			return 0;
+		}
+
+		static int MsdfCubicTo(const FT_Vector* control1, const FT_Vector* control2, const FT_Vector* to, void* user)
+		{
+			MsdfDecomposeContext* context = (MsdfDecomposeContext*)user;
+			AddEdge(context, 3, FromFtVector(control1), FromFtVector(control2), FromFtVector(to));
+			return 0;
+		}
+
+		static bool IsCorner(glm::vec2 a, glm::vec2 b, float crossThreshold)
+		{
+			a = glm::normalize(a);
+			b = glm::normalize(b);
+			return glm::dot(a, b) <= 0.0f || glm::abs(Cross(a, b)) > crossThreshold;
+		}
+
+		// Assigns a channel mask to every edge so that the two edges meeting at a corner never share more than one channel.
+		// This is the simple edge colouring scheme described by Chlumsky in "Shape Decomposition for Multi-channel Distance Fields".
+		static void ColorEdges(std::vector<MsdfContour>& contours, float angleThreshold)
+		{
+			const float crossThreshold = glm::sin(angleThreshold);
+			for (MsdfContour& contour : contours)
+			{
+				if (contour.empty()) continue;
+
+				std::vector<int> corners;
+				glm::vec2 previousDirection = EdgeDirection(contour.back(), 1.0f);
+				for (int i = 0; i < (int)contour.size(); i++)
+				{
+					if (IsCorner(previousDirection, EdgeDirection(contour[i], 0.0f), crossThreshold))
+					{
+						corners.push_back(i);
+					}
+					previousDirection = EdgeDirection(contour[i], 1.0f);
+				}
+
+				int numEdges = (int)contour.size();
+				if (corners.empty())
+				{
+					// Smooth contour, every channel can share the same edges
+					for (MsdfEdge& edge : contour)
+					{
+						edge.Color = MsdfWhite;
+					}
+				}
+				else if (corners.size() == 1)
+				{
+					// Teardrop, split the contour into three runs starting at the corner
+					static const uint8 colors[3] = { MsdfMagenta, MsdfWhite, MsdfYellow };
+					int corner = corners[0];
+					if (numEdges >= 3)
+					{
+						for (int i = 0; i < numEdges; i++)
+						{
+							int third = (int)(3.0f + 2.875f * i / (numEdges - 1) - 1.4375f + 0.5f) - 3;
+							contour[(corner + i) % numEdges].Color = colors[1 + third];
+						}
+					}
+					else
+					{
+						// Not enough edges to colour, so split each edge into thirds
+						MsdfContour parts;
+						for (int i = 0; i < numEdges; i++)
+						{
+							const MsdfEdge& edge = contour[(corner + i) % numEdges];
+							for (int part = 0; part < 3; part++)
+							{
+								MsdfEdge subEdge = edge;
+								subEdge.T0 = edge.T0 + (edge.T1 - edge.T0) * (part / 3.0f);
+								subEdge.T1 = edge.T0 + (edge.T1 - edge.T0) * ((part + 1) / 3.0f);
+								subEdge.Color = colors[(int)parts.size() / numEdges];
+								parts.push_back(subEdge);
+							}
+						}
+						contour = parts;
+					}
+				}
+				else
+				{
+					// Switch colour at every corner, making sure the last spline does not match the first
+					static const uint8 colors[3] = { MsdfCyan, MsdfMagenta, MsdfYellow };
+					int numSplines = (int)corners.size();
+					int start = corners[0];
+					int spline = 0;
+					for (int i = 0; i < numEdges; i++)
+					{
+						int index = (start + i) % numEdges;
+						if (spline + 1 < numSplines && corners[spline + 1] == index)
+						{
+							spline++;
+						}
+
+						uint8 color = colors[spline % 3];
+						if (spline == numSplines - 1 && numSplines % 3 == 1)
+						{
+							color = colors[1];
+						}
+						contour[index].Color = color;
+					}
+				}
+			}
+		}
+
+		// Distance queries are done against a flattened version of each edge. Only the first and last segment of an
+		// edge get extended into pseudo-distances, so the result matches the curve closely at glyph resolutions.
+		static void FlattenContours(const std::vector<MsdfContour>& contours, std::vector<MsdfSegment>& segments)
+		{
+			for (const MsdfContour& contour : contours)
+			{
+				for (const MsdfEdge& edge : contour)
+				{
+					int steps = edge.Degree == 1 ? 1 : edge.Degree == 2 ? 8 : 12;
+					glm::vec2 start = EdgePoint(edge, 0.0f);
+					for (int step = 1; step <= steps; step++)
+					{
+						glm::vec2 end = EdgePoint(edge, (float)step / (float)steps);
+						segments.push_back({ start, end, edge.Color, step == 1, step == steps });
+						start = end;
+					}
+				}
+			}
+		}
+
+		struct MsdfChannelDistance
+		{
+			float Distance;
+			float Dot;
+			int Segment;
+		};
+
+		// Returns the signed distance in the rgb channels and the true signed distance in alpha
+		static glm::vec4 MsdfPixelDistances(const std::vector<MsdfSegment>& segments, const glm::vec2& point, float orientation)
+		{
+			const float maxDistance = std::numeric_limits<float>::max();
+			MsdfChannelDistance channels[3] = {
+				{ -maxDistance, 1.0f, -1 },
+				{ -maxDistance, 1.0f, -1 },
+				{ -maxDistance, 1.0f, -1 }
+			};
+			float trueDistance = -maxDistance;
+
+			for (int i = 0; i < (int)segments.size(); i++)
+			{
+				const MsdfSegment& segment = segments[i];
+				glm::vec2 ab = segment.End - segment.Start;
+				glm::vec2 ap = point - segment.Start;
+				float lengthSquared = glm::dot(ab, ab);
+				if (lengthSquared <= 0.0f) continue;
+
+				float param = glm::clamp(glm::dot(ap, ab) / lengthSquared, 0.0f, 1.0f);
+				glm::vec2 toPoint = point - (segment.Start + ab * param);
+				float length = glm::length(toPoint);
+				float sign = Cross(ab, ap) * orientation >= 0.0f ? 1.0f : -1.0f;
+				float distance = sign * length;
+				float dot = length > 0.0f ? glm::abs(glm::dot(ab, toPoint)) / (glm::sqrt(lengthSquared) * length) : 0.0f;
+
+				if (glm::abs(distance) < glm::abs(trueDistance))
+				{
+					trueDistance = distance;
+				}
+
+				for (int channel = 0; channel < 3; channel++)
+				{
+					if (!(segment.Color & (1 << channel))) continue;
+
+					MsdfChannelDistance& best = channels[channel];
+					float absDistance = glm::abs(distance);
+					float absBest = glm::abs(best.Distance);
+					if (absDistance < absBest - 1e-5f || (absDistance <= absBest + 1e-5f && dot < best.Dot))
+					{
+						best = { distance, dot, i };
+					}
+				}
+			}
+
+			glm::vec4 result = glm::vec4(-maxDistance, -maxDistance, -maxDistance, trueDistance);
+			for (int channel = 0; channel < 3; channel++)
+			{
+				const MsdfChannelDistance& best = channels[channel];
+				if (best.Segment < 0) continue;
+
+				// Extend the closest edge past its end points to get the pseudo-distance
+				const MsdfSegment& segment = segments[best.Segment];
+				glm::vec2 direction = glm::normalize(segment.End - segment.Start);
+				float distance = best.Distance;
+				glm::vec2 fromStart = point - segment.Start;
+				glm::vec2 fromEnd = point - segment.End;
+				if (segment.ExtendStart && glm::dot(fromStart, direction) < 0.0f)
+				{
+					float pseudoDistance = Cross(direction, fromStart) * orientation;
+					if (glm::abs(pseudoDistance) <= glm::abs(distance))
+					{
+						distance = pseudoDistance;
+					}
+				}
+				else if (segment.ExtendEnd && glm::dot(fromEnd, direction) > 0.0f)
+				{
+					float pseudoDistance = Cross(direction, fromEnd) * orientation;
+					if (glm::abs(pseudoDistance) <= glm::abs(distance))
+					{
+						distance = pseudoDistance;
+					}
+				}
+				result[channel] = distance;
+			}
+
+			return result;
+		}
+
+		static uint8 MsdfDistanceToByte(float distance, float range)
+		{
+			float val = glm::clamp(0.5f + distance / (2.0f * range), 0.0f, 1.0f);
+			return (uint8)(val * 255.0f);
+		}
+
+		SdfBitmapContainer GenerateMsdfCodepointBitmap(int codepoint, FT_Face font, int fontSize, int padding)
+		{
+			FT_Set_Pixel_Sizes(font, 0, fontSize);
+			if (FT_Load_Char(font, codepoint, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING) || font->glyph->format != FT_GLYPH_FORMAT_OUTLINE)
+			{
+				Log::Warning("Could not generate '%c'.\n", codepoint);
+				return {
+					0, 0, 0, 0, 0, 0, 0, 0, 0, nullptr
+				};
+			}
+
+			std::vector<MsdfContour> contours;
+			MsdfDecomposeContext context = { &contours, glm::vec2() };
+			FT_Outline_Funcs outlineFuncs;
+			outlineFuncs.move_to = MsdfMoveTo;
+			outlineFuncs.line_to = MsdfLineTo;
+			outlineFuncs.conic_to = MsdfConicTo;
+			outlineFuncs.cubic_to = MsdfCubicTo;
+			outlineFuncs.shift = 0;
+			outlineFuncs.delta = 0;
+			FT_Outline_Decompose(&font->glyph->outline, &outlineFuncs, &context);
+
+			// 3 radians, anything sharper than this is treated as a corner
+			ColorEdges(contours, 3.0f);
+			std::vector<MsdfSegment> segments;
+			FlattenContours(contours, segments);
+
+			// TrueType outlines are filled to the right of the contour direction, PostScript outlines to the left
+			float orientation = FT_Outline_Get_Orientation(&font->glyph->outline) == FT_ORIENTATION_TRUETYPE ? -1.0f : 1.0f;
+
+			float glyphX = (float)font->glyph->metrics.horiBearingX / 64.0f;
+			float glyphY = (float)(font->glyph->metrics.horiBearingY - font->glyph->metrics.height) / 64.0f;
+			float glyphWidth = (float)font->glyph->metrics.width / 64.0f;
+			float glyphHeight = (float)font->glyph->metrics.height / 64.0f;
+			int characterWidth = (int)ceil(glyphWidth);
+			int characterHeight = (int)ceil(glyphHeight);
+			float scaleX = characterWidth > 0 ? glyphWidth / (float)characterWidth : 1.0f;
+			float scaleY = characterHeight > 0 ? glyphHeight / (float)characterHeight : 1.0f;
+			float range = (float)padding * (scaleX + scaleY) * 0.5f;
+			int bitmapWidth = characterWidth + padding * 2;
+			int bitmapHeight = characterHeight + padding * 2;
+			uint8* msdfBitmap = (uint8*)AllocMem(sizeof(uint8) * bitmapWidth * bitmapHeight * 4);
+			Log::Assert(msdfBitmap != nullptr, "Ran out of memory. Could not allocate memory to generate a font.");
+
+			// Rows are stored bottom up to match the single channel generator
+			for (int y = 0; y < bitmapHeight; y++)
+			{
+				for (int x = 0; x < bitmapWidth; x++)
+				{
+					glm::vec2 point = {
+						glyphX + ((float)(x - padding) + 0.5f) * scaleX,
+						glyphY + ((float)(y - padding) + 0.5f) * scaleY
+					};
+					glm::vec4 distances = MsdfPixelDistances(segments, point, orientation);
+
+					int index = (x + y * bitmapWidth) * 4;
+					msdfBitmap[index] = MsdfDistanceToByte(distances.r, range);
+					msdfBitmap[index + 1] = MsdfDistanceToByte(distances.g, range);
+					msdfBitmap[index + 2] = MsdfDistanceToByte(distances.b, range);
+					msdfBitmap[index + 3] = MsdfDistanceToByte(distances.a, range);
+				}
+			}
+
+			FT_Set_Pixel_Sizes(font, 0, 64);
+			FT_Load_Char(font, codepoint, FT_LOAD_RENDER);
+			return {
+				bitmapWidth, bitmapHeight,
+				padding, padding,
+				(float)(font->glyph->metrics.horiAdvance >> 6) / 64.0f,
+				(float)(font->glyph->metrics.horiBearingX >> 6) / (float)64.0f,
+				(float)(font->glyph->metrics.horiBearingY >> 6) / (float)64.0f,
+				(float)(font->glyph->metrics.width >> 6) / (float)64.0f,
+				(float)(font->glyph->metrics.height >> 6) / (float)64.0f,
+				msdfBitmap
+			};
+		}
+
+		// Packed fonts are read by freetype straight out of the pack's mapping, packedFont has to outlive the face
+		static FT_Error OpenFace(FT_Library ft, const char* fontFile, PackData& packedFont, FT_Face* face)
+		{
+			if (PackFile::Read(NCPath::CreatePath(fontFile), packedFont))
+			{
+				return FT_New_Memory_Face(ft, packedFont.Data, (FT_Long)packedFont.Size, 0, face);
+			}
+
+			return FT_New_Face(ft, fontFile, 0, face);
+		}
+
+		static void fillSdfBitmaps(int begin, int end, SdfBitmapContainer* arr, const char* fontFile, int fontSize, int padding, int upscaleResolution, int glyphOffset, FontSdfType sdfType)
 		{
 			FT_Library ft;
 			if (FT_Init_FreeType(&ft))
@@ -120,7 +556,8 @@ namespace Cocoa
 			}
 
 			FT_Face font;
-			if (FT_New_Face(ft, fontFile, 0, &font))
+			PackData packedFont;
+			if (OpenFace(ft, fontFile, packedFont, &font))
 			{
 				Log::Warning("Could not load font %s.\n", fontFile);
 				return;
@@ -128,14 +565,21 @@ namespace Cocoa
 
 			for (int i = begin; i < end; i++)
 			{
-				arr[i] = GenerateSdfCodepointBitmap(i + glyphOffset, font, fontSize, padding, upscaleResolution);
+				if (sdfType == FontSdfType::MultiChannel)
+				{
+					arr[i] = GenerateMsdfCodepointBitmap(i + glyphOffset, font, fontSize, padding);
+				}
+				else
+				{
+					arr[i] = GenerateSdfCodepointBitmap(i + glyphOffset, font, fontSize, padding, upscaleResolution);
+				}
 			}
 
 			FT_Done_Face(font);
 			FT_Done_FreeType(ft);
 		}
 
-		void CreateSdfFontTexture(const CPath& fontFile, int fontSize, CharInfo* characterMap, int characterMapSize, const CPath& outputFile, int padding, int upscaleResolution, int glyphOffset)
+		void CreateSdfFontTexture(const CPath& fontFile, int fontSize, CharInfo* characterMap, int characterMapSize, const CPath& outputFile, int padding, int upscaleResolution, int glyphOffset, FontSdfType sdfType)
 		{
 			FT_Library ft;
 			if (FT_Init_FreeType(&ft))
@@ -145,7 +589,8 @@ namespace Cocoa
 			}
 
 			FT_Face font;
-			if (FT_New_Face(ft, fontFile.Path.c_str(), 0, &font))
+			PackData packedFont;
+			if (OpenFace(ft, fontFile.Path.c_str(), packedFont, &font))
 			{
 				Log::Warning("Could not load font %s.\n", fontFile.Path.c_str());
 				return;
@@ -181,7 +626,7 @@ namespace Cocoa
 			for (int i = 0; i <= processorCount; i++)
 			{
 				int end = CMath::Min(segmentSize + count, characterMapSize - glyphOffset);
-				threads.push_back(std::thread(fillSdfBitmaps, count, end, sdfBitmaps, fontFile.Path.c_str(), lowResFontSize, padding, upscaleResolution, glyphOffset));
+				threads.push_back(std::thread(fillSdfBitmaps, count, end, sdfBitmaps, fontFile.Path.c_str(), lowResFontSize, padding, upscaleResolution, glyphOffset, sdfType));
 				count += segmentSize;
 			}
 
@@ -270,13 +715,21 @@ namespace Cocoa
 				{
 					for (int imgX = 0; imgX < width; imgX++)
 					{
-						unsigned char pixelData = sdf.bitmap[imgX + imgY * width];
 						int index = (x + imgX) * 4 + (y + imgY) * sdfWidth * 4;
 						Log::Assert(index + 3 < endBitmap, "Index overflow when generating SDF");
-						finalSdf[index] = pixelData;
-						finalSdf[index + 1] = pixelData;
-						finalSdf[index + 2] = pixelData;
-						finalSdf[index + 3] = pixelData;
+						if (sdfType == FontSdfType::MultiChannel)
+						{
+							// Msdf bitmaps are already RGBA
+							memcpy(&finalSdf[index], &sdf.bitmap[(imgX + imgY * width) * 4], sizeof(uint8) * 4);
+						}
+						else
+						{
+							unsigned char pixelData = sdf.bitmap[imgX + imgY * width];
+							finalSdf[index] = pixelData;
+							finalSdf[index + 1] = pixelData;
+							finalSdf[index + 2] = pixelData;
+							finalSdf[index + 3] = pixelData;
+						}
 					}
 				}
 
@@ -11,7 +11,7 @@ namespace Cocoa
 	namespace RenderBatch
 	{
 		// Forward declarations
-		static void LoadVertexProperties(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr);
+		static void LoadVertexProperties(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr, const glm::vec3& position, float rotationDegrees);
 		static void LoadVertexProperties(RenderBatchData& data, const glm::vec3& position,
 			const glm::vec3& scale, const glm::vec2& quadSize, const glm::vec2* texCoords,
 			float rotationDegrees, const glm::vec4& color, int texId, uint32 entityId = -1);
@@ -114,6 +114,11 @@ namespace Cocoa
 		}
 
 		void Add(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr)
+		{
+			Add(data, transform, spr, transform.Position, transform.EulerRotation.z);
+		}
+
+		void Add(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr, const glm::vec3& position, float rotationDegrees)
 		{
 			data.NumSprites++;
 
@@ -128,14 +133,14 @@ namespace Cocoa
 				}
 			}
 
-			LoadVertexProperties(data, transform, spr);
+			LoadVertexProperties(data, transform, spr, position, rotationDegrees);
 		}
 
 		void Add(RenderBatchData& data, const TransformData& transform, const FontRenderer& fontRenderer)
 		{
-			const Font& font = AssetManager::GetFont(fontRenderer.m_Font.m_AssetId);
+			const Font& font = AssetManager::GetFont(fontRenderer.m_Font);
 			Handle<Texture> tex = font.m_FontTexture;
-			const Texture& texture = AssetManager::GetTexture(tex.m_AssetId);
+			const Texture& texture = AssetManager::GetTexture(tex);
 
 			if (!tex.IsNull())
 			{
@@ -196,6 +201,52 @@ namespace Cocoa
 			}
 		}
 
+		void Add(RenderBatchData& data, const TransformData& transform, const FontRenderer& fontRenderer, const CachedText& cachedText)
+		{
+			data.NumSprites++;
+
+			Handle<Texture> tex = cachedText.TextureHandle;
+			if (!HasTexture(data, tex))
+			{
+				data.Textures[data.NumTextures] = tex;
+				data.NumTextures++;
+			}
+
+			int texId = 0;
+			for (int i = 0; i < data.NumTextures; i++)
+			{
+				if (data.Textures[i] == tex)
+				{
+					texId = i + 1;
+					break;
+				}
+			}
+
+			Entity res = NEntity::FromComponent<TransformData>(transform);
+			uint32 entityId = NEntity::GetID(res);
+
+			float x0 = transform.Position.x + cachedText.Min.x;
+			float y0 = transform.Position.y + cachedText.Max.y;
+			float x1 = transform.Position.x + cachedText.Max.x;
+			float y1 = transform.Position.y + cachedText.Min.y;
+			glm::vec2 vertices[4] = {
+				{x1, y0},
+				{x1, y1},
+				{x0, y1},
+				{x0, y0}
+			};
+
+			const glm::vec2& uvMax = cachedText.TexCoordMax;
+			glm::vec2 texCoords[4] = {
+				{uvMax.x, uvMax.y},
+				{uvMax.x, 0.0f},
+				{0.0f, 0.0f},
+				{0.0f, uvMax.y}
+			};
+
+			LoadVertexProperties(data, vertices, texCoords, fontRenderer.m_Color, texId, entityId);
+		}
+
 		void Add(RenderBatchData& data, const glm::vec2& min, const glm::vec2& max, const glm::vec3& color)
 		{
 			data.NumSprites++;
@@ -264,13 +315,12 @@ namespace Cocoa
 			LoadVertexProperties(data, vec3Pos, scale, size, &texCoords[0], rotation, vec4Color, texId);
 		}
 
-		void LoadVertexProperties(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr)
+		void LoadVertexProperties(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr, const glm::vec3& position, float rotationDegrees)
 		{
 			glm::vec4 color = spr.m_Color;
 			const Sprite& sprite = spr.m_Sprite;
 			const glm::vec2* texCoords = spr.m_Sprite.m_TexCoords;
 			glm::vec2 quadSize{ sprite.m_Width, sprite.m_Height };
-			float rotation = transform.EulerRotation.z;
 
 			int texId = 0;
 			if (!sprite.m_Texture.IsNull())
@@ -286,7 +336,7 @@ namespace Cocoa
 			}
 
 			Entity res = NEntity::FromComponent<TransformData>(transform);
-			LoadVertexProperties(data, transform.Position, transform.Scale, quadSize, texCoords, rotation, color, texId, NEntity::GetID(res));
+			LoadVertexProperties(data, position, transform.Scale, quadSize, texCoords, rotationDegrees, color, texId, NEntity::GetID(res));
 		}
 
 		void LoadVertexProperties(RenderBatchData& data, const glm::vec3& position, const glm::vec3& scale, const glm::vec2& quadSize, const glm::vec2* texCoords,
@@ -368,7 +418,7 @@ namespace Cocoa
 			for (int i = 0; i < data.NumTextures; i++)
 			{
 				glActiveTexture(GL_TEXTURE0 + i + 1);
-				TextureUtil::Bind(AssetManager::GetTexture(data.Textures[i].m_AssetId));
+				TextureUtil::Bind(AssetManager::GetTexture(data.Textures[i]));
 			}
 
 			glBindVertexArray(data.VAO);
@@ -379,7 +429,7 @@ namespace Cocoa
 
 			for (int i = 0; i < data.NumTextures; i++)
 			{
-				TextureUtil::Unbind(AssetManager::GetTexture(data.Textures[i].m_AssetId));
+				TextureUtil::Unbind(AssetManager::GetTexture(data.Textures[i]));
 			}
 		}
 
@@ -1,6 +1,7 @@
 #include "externalLibs.h"
 
 #include "cocoa/renderer/Shader.h"
+#include "cocoa/file/PackFile.h"
 #include "cocoa/util/Log.h"
 #include "cocoa/util/CMath.h"
 #include "cocoa/core/Core.h"
@@ -45,24 +46,33 @@ namespace Cocoa
 
 		Shader Compile(const CPath& filepath, bool isDefault)
 		{
-			std::string fileSource = ReadFile(filepath.Path.c_str());
+			// Packed shaders are parsed and handed to GL straight out of the pack's mapping
+			PackData packedSource;
+			std::string looseSource;
+			if (!PackFile::Read(filepath, packedSource))
+			{
+				looseSource = ReadFile(filepath.Path.c_str());
+			}
+			std::string_view fileSource = packedSource.Data ?
+				std::string_view((const char*)packedSource.Data, packedSource.Size) :
+				std::string_view(looseSource);
 
-			std::unordered_map<GLenum, std::string> shaderSources;
+			std::unordered_map<GLenum, std::string_view> shaderSources;
 
 			const char* typeToken = "#type";
 			size_t typeTokenLength = strlen(typeToken);
 			size_t pos = fileSource.find(typeToken, 0);
-			while (pos != std::string::npos)
+			while (pos != std::string_view::npos)
 			{
 				size_t eol = fileSource.find_first_of("\r\n", pos);
-				Log::Assert(eol != std::string::npos, "Syntax error");
+				Log::Assert(eol != std::string_view::npos, "Syntax error");
 				size_t begin = pos + typeTokenLength + 1;
-				std::string type = fileSource.substr(begin, eol - begin);
+				std::string type = std::string(fileSource.substr(begin, eol - begin));
 				Log::Assert(ShaderTypeFromString(type), "Invalid shader type specified.");
 
 				size_t nextLinePos = fileSource.find_first_not_of("\r\n", eol);
 				pos = fileSource.find(typeToken, nextLinePos);
-				shaderSources[ShaderTypeFromString(type)] = fileSource.substr(nextLinePos, pos - (nextLinePos == std::string::npos ? fileSource.size() - 1 : nextLinePos));
+				shaderSources[ShaderTypeFromString(type)] = fileSource.substr(nextLinePos, pos - (nextLinePos == std::string_view::npos ? fileSource.size() - 1 : nextLinePos));
 			}
 
 			GLuint program = glCreateProgram();
@@ -73,15 +83,16 @@ namespace Cocoa
 			for (auto& kv : shaderSources)
 			{
 				GLenum shaderType = kv.first;
-				const std::string& source = kv.second;
+				std::string_view source = kv.second;
 
 				// Create an empty vertex shader handle
 				GLuint shader = glCreateShader(shaderType);
 
 				// Send the vertex shader source code to GL
-				// Note that std::string's .c_str is NULL character terminated.
-				const GLchar* sourceCStr = source.c_str();
-				glShaderSource(shader, 1, &sourceCStr, 0);
+				// Note that the sources are views into the whole file, so the length has to be passed along
+				const GLchar* sourceCStr = source.data();
+				GLint sourceLength = (GLint)source.size();
+				glShaderSource(shader, 1, &sourceCStr, &sourceLength);
 
 				// Compile the vertex shader
 				glCompileShader(shader);
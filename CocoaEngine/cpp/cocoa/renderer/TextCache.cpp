@@ -0,0 +1,262 @@
+#include "externalLibs.h"
+
+#include "cocoa/renderer/TextCache.h"
+#include "cocoa/renderer/RenderBatch.h"
+#include "cocoa/renderer/Framebuffer.h"
+#include "cocoa/core/AssetManager.h"
+#include "cocoa/util/CMath.h"
+
+namespace Cocoa
+{
+	namespace TextCache
+	{
+		struct PooledTexture
+		{
+			Framebuffer Target;
+			Handle<Texture> TextureHandle;
+			bool InUse;
+		};
+
+		// Internal Variables
+		// The main framebuffer renders 1920 world units into 3840 pixels
+		static const float TEXELS_PER_UNIT = 2.0f;
+		static const int MIN_TEXTURE_SIZE = 32;
+		static const int MAX_TEXTURE_SIZE = 4096;
+
+		static int m_TexSlots[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+		static Handle<Shader> m_FontShader = Handle<Shader>();
+		static std::vector<PooledTexture> m_Pool;
+		static std::unordered_map<entt::entity, CachedText> m_Cache;
+		static uint32 m_Frame = 0;
+
+		// Forward Declarations
+		static int AcquireTexture(int width, int height);
+		static void ReleaseTexture(int poolIndex);
+		static void RenderToTexture(CachedText& cachedText, const TransformData& transform, const FontRenderer& fontRenderer);
+		static int NextPowerOfTwo(int value);
+
+		void Init(Handle<Shader> fontShader)
+		{
+			m_FontShader = fontShader;
+			m_Frame = 0;
+		}
+
+		void Destroy()
+		{
+			for (auto& pooled : m_Pool)
+			{
+				// The color texture is owned by the AssetManager, which keeps its assets loaded across scenes now, so it
+				// has to be handed back explicitly
+				if (AssetManager::IsValid(pooled.TextureHandle))
+				{
+					AssetManager::UnloadTexture(pooled.TextureHandle);
+				}
+				pooled.Target.ColorAttachments.clear();
+				NFramebuffer::Delete(pooled.Target);
+			}
+			m_Pool.clear();
+			m_Cache.clear();
+		}
+
+		const CachedText& Get(entt::entity entity, const TransformData& transform, const FontRenderer& fontRenderer)
+		{
+			auto iter = m_Cache.find(entity);
+			if (iter == m_Cache.end())
+			{
+				CachedText newText;
+				newText.PoolIndex = -1;
+				iter = m_Cache.emplace(entity, newText).first;
+			}
+
+			CachedText& cachedText = iter->second;
+			glm::vec2 scale = glm::vec2(transform.Scale.x, transform.Scale.y);
+			bool isDirty = cachedText.PoolIndex == -1 ||
+				cachedText.Text != fontRenderer.text ||
+				cachedText.FontHandle != fontRenderer.m_Font ||
+				cachedText.FontSize != fontRenderer.fontSize ||
+				cachedText.Scale != scale;
+			if (isDirty)
+			{
+				cachedText.Text = fontRenderer.text;
+				cachedText.FontHandle = fontRenderer.m_Font;
+				cachedText.FontSize = fontRenderer.fontSize;
+				cachedText.Scale = scale;
+				RenderToTexture(cachedText, transform, fontRenderer);
+			}
+
+			cachedText.LastUsedFrame = m_Frame;
+			return cachedText;
+		}
+
+		void EndFrame()
+		{
+			for (auto iter = m_Cache.begin(); iter != m_Cache.end();)
+			{
+				if (iter->second.LastUsedFrame != m_Frame)
+				{
+					ReleaseTexture(iter->second.PoolIndex);
+					iter = m_Cache.erase(iter);
+				}
+				else
+				{
+					iter++;
+				}
+			}
+			m_Frame++;
+		}
+
+		static void RenderToTexture(CachedText& cachedText, const TransformData& transform, const FontRenderer& fontRenderer)
+		{
+			// Measure the text the same way RenderBatch lays it out
+			const Font& font = AssetManager::GetFont(fontRenderer.m_Font);
+			float scaleX = transform.Scale.x * fontRenderer.fontSize;
+			float scaleY = transform.Scale.y * fontRenderer.fontSize;
+			glm::vec2 min = glm::vec2(std::numeric_limits<float>::max());
+			glm::vec2 max = glm::vec2(-std::numeric_limits<float>::max());
+			float x = 0.0f;
+			for (int i = 0; i < fontRenderer.text.size(); i++)
+			{
+				const CharInfo& charInfo = font.GetCharacterInfo(fontRenderer.text[i]);
+				float x0 = x + charInfo.bearingX * scaleX;
+				float y0 = charInfo.bearingY * scaleY;
+				float x1 = x0 + charInfo.chScaleX * scaleX;
+				float y1 = -(charInfo.chScaleY - charInfo.bearingY) * scaleY;
+				min = glm::min(min, glm::vec2(x0, y1));
+				max = glm::max(max, glm::vec2(x1, y0));
+				x += charInfo.advance * fontRenderer.fontSize * transform.Scale.x;
+			}
+
+			if (fontRenderer.text.empty())
+			{
+				min = glm::vec2(0.0f);
+				max = glm::vec2(1.0f);
+			}
+
+			glm::vec2 size = max - min;
+			float texelsPerUnit = TEXELS_PER_UNIT;
+			float largestSide = glm::max(size.x, size.y);
+			if (largestSide * texelsPerUnit > MAX_TEXTURE_SIZE)
+			{
+				texelsPerUnit = MAX_TEXTURE_SIZE / largestSide;
+			}
+
+			int textureWidth = NextPowerOfTwo((int)ceil(size.x * texelsPerUnit));
+			int textureHeight = NextPowerOfTwo((int)ceil(size.y * texelsPerUnit));
+			if (cachedText.PoolIndex == -1 ||
+				m_Pool[cachedText.PoolIndex].Target.Width != textureWidth ||
+				m_Pool[cachedText.PoolIndex].Target.Height != textureHeight)
+			{
+				ReleaseTexture(cachedText.PoolIndex);
+				cachedText.PoolIndex = AcquireTexture(textureWidth, textureHeight);
+			}
+
+			PooledTexture& pooled = m_Pool[cachedText.PoolIndex];
+			cachedText.TextureHandle = pooled.TextureHandle;
+			cachedText.Min = min;
+			cachedText.Max = max;
+			cachedText.TexCoordMax = glm::vec2(size.x * texelsPerUnit / (float)textureWidth, size.y * texelsPerUnit / (float)textureHeight);
+
+			// The cache is filled in the middle of rendering the scene, so restore whatever was bound
+			GLint previousFramebuffer;
+			GLint previousViewport[4];
+			GLint previousBlend[4];
+			GLboolean previousColorMask[4];
+			GLfloat previousClearColor[4];
+			glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFramebuffer);
+			glGetIntegerv(GL_VIEWPORT, previousViewport);
+			glGetIntegerv(GL_BLEND_SRC_RGB, &previousBlend[0]);
+			glGetIntegerv(GL_BLEND_DST_RGB, &previousBlend[1]);
+			glGetIntegerv(GL_BLEND_SRC_ALPHA, &previousBlend[2]);
+			glGetIntegerv(GL_BLEND_DST_ALPHA, &previousBlend[3]);
+			glGetBooleanv(GL_COLOR_WRITEMASK, previousColorMask);
+			glGetFloatv(GL_COLOR_CLEAR_VALUE, previousClearColor);
+
+			NFramebuffer::Bind(pooled.Target);
+			glViewport(0, 0, textureWidth, textureHeight);
+			glClearColor(1.0f, 1.0f, 1.0f, 0.0f);
+			glClear(GL_COLOR_BUFFER_BIT);
+
+			// The cached quad is drawn with the regular alpha blend like any sprite, so the texture has to hold
+			// straight alpha. The text is white, so only coverage is accumulated and the color stays white, blending
+			// the color as well would darken it towards the transparent background at the glyph edges
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_TRUE);
+			glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+			// Text is baked in white and tinted by the vertex color when drawn, so color changes don't invalidate the cache
+			FontRenderer whiteText = fontRenderer;
+			whiteText.m_Color = glm::vec4(1.0f);
+
+			glm::vec2 origin = glm::vec2(transform.Position.x, transform.Position.y) + min;
+			glm::mat4 projection = glm::ortho(origin.x, origin.x + textureWidth / texelsPerUnit, origin.y, origin.y + textureHeight / texelsPerUnit, -1.0f, 1.0f);
+
+			RenderBatchData batch = RenderBatch::CreateRenderBatch(CMath::Max((int)whiteText.text.size(), 1), 0, m_FontShader);
+			RenderBatch::Start(batch);
+			RenderBatch::Add(batch, transform, whiteText);
+
+			const Shader& shader = AssetManager::GetShader(m_FontShader);
+			NShader::Bind(shader);
+			NShader::UploadMat4(shader, "uProjection", projection);
+			NShader::UploadMat4(shader, "uView", glm::mat4(1.0f));
+			NShader::UploadIntArray(shader, "uTextures[0]", 16, m_TexSlots);
+			RenderBatch::Render(batch);
+			RenderBatch::Free(batch);
+
+			glBlendFuncSeparate(previousBlend[0], previousBlend[1], previousBlend[2], previousBlend[3]);
+			glColorMask(previousColorMask[0], previousColorMask[1], previousColorMask[2], previousColorMask[3]);
+			glClearColor(previousClearColor[0], previousClearColor[1], previousClearColor[2], previousClearColor[3]);
+			glBindFramebuffer(GL_FRAMEBUFFER, previousFramebuffer);
+			glViewport(previousViewport[0], previousViewport[1], previousViewport[2], previousViewport[3]);
+		}
+
+		static int AcquireTexture(int width, int height)
+		{
+			for (int i = 0; i < m_Pool.size(); i++)
+			{
+				PooledTexture& pooled = m_Pool[i];
+				if (!pooled.InUse && pooled.Target.Width == width && pooled.Target.Height == height)
+				{
+					pooled.InUse = true;
+					return i;
+				}
+			}
+
+			PooledTexture pooled;
+			pooled.Target.Width = width;
+			pooled.Target.Height = height;
+			pooled.Target.IncludeDepthStencil = false;
+			Texture color0;
+			color0.InternalFormat = ByteFormat::RGBA8;
+			color0.ExternalFormat = ByteFormat::RGBA;
+			color0.MagFilter = FilterMode::Linear;
+			color0.MinFilter = FilterMode::Linear;
+			color0.WrapS = WrapMode::Repeat;
+			color0.WrapT = WrapMode::Repeat;
+			color0.IsDefault = true;
+			NFramebuffer::AddColorAttachment(pooled.Target, color0);
+			NFramebuffer::Generate(pooled.Target);
+
+			pooled.TextureHandle = AssetManager::AddGeneratedTexture(NFramebuffer::GetColorAttachment(pooled.Target, 0));
+			pooled.InUse = true;
+			m_Pool.push_back(pooled);
+			return (int)m_Pool.size() - 1;
+		}
+
+		static void ReleaseTexture(int poolIndex)
+		{
+			if (poolIndex >= 0 && poolIndex < m_Pool.size())
+			{
+				m_Pool[poolIndex].InUse = false;
+			}
+		}
+
+		static int NextPowerOfTwo(int value)
+		{
+			int result = MIN_TEXTURE_SIZE;
+			while (result < value && result < MAX_TEXTURE_SIZE)
+			{
+				result *= 2;
+			}
+			return result;
+		}
+	}
+}
@@ -4,9 +4,23 @@
 #include "cocoa/util/Log.h"
 #include "cocoa/util/JsonExtended.h"
 #include "cocoa/core/AssetManager.h"
+#include "cocoa/renderer/TextureCooker.h"
+#include "cocoa/file/PackFile.h"
 
 #include <stb_image.h>
 
+// S3TC is an extension, so these may not be part of the generated GL loader
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+// BPTC is only core from GL 4.2
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
 namespace Cocoa
 {
 	namespace TextureUtil
@@ -63,6 +77,12 @@ namespace Cocoa
 				return GL_RED_INTEGER;
 			case ByteFormat::DEPTH24_STENCIL8:
 				return GL_DEPTH24_STENCIL8;
+			case ByteFormat::BC1_RGB:
+				return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+			case ByteFormat::BC3_RGBA:
+				return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+			case ByteFormat::BC7_RGBA:
+				return GL_COMPRESSED_RGBA_BPTC_UNORM;
 			case ByteFormat::None:
 				return GL_NONE;
 			default:
@@ -113,6 +133,12 @@ namespace Cocoa
 				return true;
 			case ByteFormat::RED_INTEGER:
 				return true;
+			case ByteFormat::BC1_RGB:
+				return false;
+			case ByteFormat::BC3_RGBA:
+				return false;
+			case ByteFormat::BC7_RGBA:
+				return false;
 			case ByteFormat::None:
 				return GL_NONE;
 			default:
@@ -122,6 +148,44 @@ namespace Cocoa
 			return false;
 		}
 
+		bool ByteFormatIsCompressed(ByteFormat format)
+		{
+			return format == ByteFormat::BC1_RGB || format == ByteFormat::BC3_RGBA || format == ByteFormat::BC7_RGBA;
+		}
+
+		bool SupportsCompressedFormat(ByteFormat format)
+		{
+			GLint numFormats = 0;
+			glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &numFormats);
+			std::vector<GLint> formats(glm::max(numFormats, 0));
+			if (numFormats > 0)
+			{
+				glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+			}
+
+			uint32 glFormat = ToGl(format);
+			return std::find(formats.begin(), formats.end(), (GLint)glFormat) != formats.end();
+		}
+
+		static uint32 ToGlMinFilter(const Texture& texture)
+		{
+			if (texture.NumMips <= 1)
+			{
+				return ToGl(texture.MinFilter);
+			}
+
+			switch (texture.MinFilter)
+			{
+			case FilterMode::Linear:
+				return GL_LINEAR_MIPMAP_LINEAR;
+			case FilterMode::Nearest:
+				// Keep pixel art crisp within a level, but blend between levels so zooming does not pop
+				return GL_NEAREST_MIPMAP_LINEAR;
+			default:
+				return ToGl(texture.MinFilter);
+			}
+		}
+
 		static void BindTextureParameters(const Texture& texture)
 		{
 			if (texture.WrapS != WrapMode::None)
@@ -134,7 +198,7 @@ namespace Cocoa
 			}
 			if (texture.MinFilter != FilterMode::None)
 			{
-				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, ToGl(texture.MinFilter));
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, ToGlMinFilter(texture));
 			}
 			if (texture.MagFilter != FilterMode::None)
 			{
@@ -142,13 +206,8 @@ namespace Cocoa
 			}
 		}
 
-		void Generate(Texture& texture, const CPath& path)
+		bool SetFormatFromChannels(Texture& texture, int channels)
 		{
-			int channels;
-
-			unsigned char* pixels = stbi_load(path.Path.c_str(), &texture.Width, &texture.Height, &channels, 0);
-			Log::Assert((pixels != nullptr), "STB failed to load image: %s\n-> STB Failure Reason: %s", path.Path.c_str(), stbi_failure_reason());
-
 			int bytesPerPixel = channels;
 			if (bytesPerPixel == 4)
 			{
@@ -162,11 +221,58 @@ namespace Cocoa
 			}
 			else
 			{
-				Log::Warning("Unknown number of channels '%d' in image '%s'.", path.Path.c_str(), channels);
+				Log::Warning("Unknown number of channels '%d' in image '%s'.", channels, texture.Path.Path.c_str());
+				return false;
+			}
+
+			return true;
+		}
+
+		void Generate(Texture& texture, const CPath& path)
+		{
+			if (texture.Compression != CompressionQuality::None || texture.GenerateMips)
+			{
+				CookedTexture cookedTexture;
+				if (TextureCooker::Cook(path, texture.Compression, cookedTexture, texture.GenerateMips))
+				{
+					UploadMips(texture, cookedTexture);
+					return;
+				}
+
+				Log::Warning("Failed to cook texture '%s', loading it uncompressed instead.", path.Path.c_str());
+			}
+
+			int channels;
+
+			unsigned char* pixels = LoadPixels(path, &texture.Width, &texture.Height, &channels);
+			Log::Assert((pixels != nullptr), "STB failed to load image: %s\n-> STB Failure Reason: %s", path.Path.c_str(), stbi_failure_reason());
+
+			if (!SetFormatFromChannels(texture, channels))
+			{
+				stbi_image_free(pixels);
 				return;
 			}
 
 			glGenTextures(1, &texture.GraphicsId);
+			Upload(texture, pixels);
+
+			stbi_image_free(pixels);
+		}
+
+		void GeneratePlaceholder(Texture& texture)
+		{
+			static const uint8 whitePixel[4] = { 255, 255, 255, 255 };
+			texture.Width = 1;
+			texture.Height = 1;
+			texture.InternalFormat = ByteFormat::RGBA8;
+			texture.ExternalFormat = ByteFormat::RGBA;
+
+			glGenTextures(1, &texture.GraphicsId);
+			Upload(texture, whitePixel);
+		}
+
+		void Upload(Texture& texture, const void* pixels)
+		{
 			glBindTexture(GL_TEXTURE_2D, texture.GraphicsId);
 
 			BindTextureParameters(texture);
@@ -174,9 +280,64 @@ namespace Cocoa
 			uint32 internalFormat = ToGl(texture.InternalFormat);
 			uint32 externalFormat = ToGl(texture.ExternalFormat);
 			Log::Assert(internalFormat != GL_NONE && externalFormat != GL_NONE, "Tried to load image from file, but failed to identify internal format for image '%s'", texture.Path.Path.c_str());
+
+			// Rows of RGB images are not always 4 byte aligned
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 			glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, texture.Width, texture.Height, 0, externalFormat, GL_UNSIGNED_BYTE, pixels);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
 
-			stbi_image_free(pixels);
+		void UploadCompressed(Texture& texture, const void* data, uint32 dataSize)
+		{
+			Log::Assert(ByteFormatIsCompressed(texture.InternalFormat), "Tried to upload compressed data to uncompressed texture '%s'", texture.Path.Path.c_str());
+			glBindTexture(GL_TEXTURE_2D, texture.GraphicsId);
+
+			BindTextureParameters(texture);
+			glCompressedTexImage2D(GL_TEXTURE_2D, 0, ToGl(texture.InternalFormat), texture.Width, texture.Height, 0, dataSize, data);
+		}
+
+		void UploadMips(Texture& texture, const CookedTexture& cookedTexture, int firstLevel)
+		{
+			Log::Assert(firstLevel >= 0 && firstLevel < cookedTexture.NumMips, "Mip level %d is out of range for texture '%s'", firstLevel, texture.Path.Path.c_str());
+			texture.Width = cookedTexture.Width;
+			texture.Height = cookedTexture.Height;
+			texture.InternalFormat = cookedTexture.Format;
+			texture.ExternalFormat = ByteFormatIsCompressed(cookedTexture.Format) ? cookedTexture.Format : ByteFormat::RGBA;
+			texture.NumMips = cookedTexture.NumMips - firstLevel;
+
+			// Mip levels can't be removed from an existing texture, so build a new one and swap it in
+			uint32 graphicsId;
+			glGenTextures(1, &graphicsId);
+			glBindTexture(GL_TEXTURE_2D, graphicsId);
+			BindTextureParameters(texture);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.NumMips - 1);
+
+			uint32 internalFormat = ToGl(texture.InternalFormat);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			for (int level = firstLevel; level < cookedTexture.NumMips; level++)
+			{
+				int width = glm::max(cookedTexture.Width >> level, 1);
+				int height = glm::max(cookedTexture.Height >> level, 1);
+				uint32 offset = TextureCooker::MipOffset(cookedTexture.Format, cookedTexture.Width, cookedTexture.Height, level);
+				uint32 size = TextureCooker::LevelSize(cookedTexture.Format, width, height);
+				const uint8* data = cookedTexture.Data.data() + offset;
+				if (ByteFormatIsCompressed(cookedTexture.Format))
+				{
+					glCompressedTexImage2D(GL_TEXTURE_2D, level - firstLevel, internalFormat, width, height, 0, size, data);
+				}
+				else
+				{
+					glTexImage2D(GL_TEXTURE_2D, level - firstLevel, internalFormat, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+				}
+			}
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+			if (!IsNull(texture))
+			{
+				glDeleteTextures(1, &texture.GraphicsId);
+			}
+			texture.GraphicsId = graphicsId;
 		}
 
 		void Generate(Texture& texture)
@@ -200,6 +361,42 @@ namespace Cocoa
 			return texture.GraphicsId == NullTexture.GraphicsId;
 		}
 
+		uint8* LoadPixels(const CPath& path, int* width, int* height, int* channels, int desiredChannels)
+		{
+			PackData packed;
+			if (PackFile::Read(path, packed))
+			{
+				return stbi_load_from_memory(packed.Data, (int)packed.Size, width, height, channels, desiredChannels);
+			}
+
+			return stbi_load(path.Path.c_str(), width, height, channels, desiredChannels);
+		}
+
+		uint64 GetMemorySize(const Texture& texture)
+		{
+			if (IsNull(texture))
+			{
+				return 0;
+			}
+
+			uint64 bytesPerPixel = 4;
+			if (texture.InternalFormat == ByteFormat::RGB || texture.InternalFormat == ByteFormat::RGB8)
+			{
+				bytesPerPixel = 3;
+			}
+
+			uint64 size = 0;
+			for (int level = 0; level < glm::max(texture.NumMips, 1); level++)
+			{
+				int width = glm::max(texture.Width >> level, 1);
+				int height = glm::max(texture.Height >> level, 1);
+				size += ByteFormatIsCompressed(texture.InternalFormat) ?
+					(uint64)TextureCooker::LevelSize(texture.InternalFormat, width, height) :
+					(uint64)width * (uint64)height * bytesPerPixel;
+			}
+			return size;
+		}
+
 		void Bind(const Texture& texture)
 		{
 			glBindTexture(GL_TEXTURE_2D, texture.GraphicsId);
@@ -223,7 +420,9 @@ namespace Cocoa
 				{"MagFilter", (int)texture.MagFilter },
 				{"MinFilter", (int)texture.MinFilter },
 				{"WrapS", (int)texture.WrapS},
-				{"WrapT", (int)texture.WrapT}
+				{"WrapT", (int)texture.WrapT},
+				{"Compression", (int)texture.Compression},
+				{"GenerateMips", texture.GenerateMips}
 			};
 		}
 
@@ -235,6 +434,11 @@ namespace Cocoa
 			JsonExtended::AssignEnumIfNotNull<FilterMode>(j, "MinFilter", texture.MinFilter);
 			JsonExtended::AssignEnumIfNotNull<WrapMode>(j, "WrapS", texture.WrapS);
 			JsonExtended::AssignEnumIfNotNull<WrapMode>(j, "WrapT", texture.WrapT);
+			JsonExtended::AssignEnumIfNotNull<CompressionQuality>(j, "Compression", texture.Compression);
+			if (j.contains("GenerateMips") && j["GenerateMips"].is_boolean())
+			{
+				texture.GenerateMips = j["GenerateMips"];
+			}
 			return texture;
 		}
 	}
@@ -0,0 +1,335 @@
+#include "externalLibs.h"
+
+#include "cocoa/renderer/TextureAtlas.h"
+#include "cocoa/core/AssetManager.h"
+#include "cocoa/renderer/AsyncTextureLoader.h"
+#include "cocoa/file/File.h"
+#include "cocoa/util/Settings.h"
+#include "cocoa/util/JsonExtended.h"
+#include "cocoa/util/Log.h"
+
+#include <stb_image.h>
+#include "stb/stb_image_write.h"
+
+namespace Cocoa
+{
+	namespace TextureAtlas
+	{
+		struct PackedTexture
+		{
+			Handle<Texture> TextureHandle;
+			uint8* Pixels;
+			int Width;
+			int Height;
+			int Page;
+			int X;
+			int Y;
+		};
+
+		struct AtlasPage
+		{
+			std::vector<uint8> Pixels;
+			FilterMode MagFilter;
+			FilterMode MinFilter;
+		};
+
+		// Internal Variables
+		static const char* MANIFEST_FILENAME = "atlas.json";
+
+		// Indexed by texture slot, a null page means the texture is not in the atlas
+		static std::vector<AtlasRegion> m_Regions;
+		static std::vector<Handle<Texture>> m_Pages;
+
+		// Forward Declarations
+		static void BlitWithBorder(const PackedTexture& packedTexture, int padding, int pageSize, uint8* pagePixels);
+		static CPath GetManifestPath(const CPath& directory);
+
+		int Build(const CPath& outputDirectory, int pageSize, int maxTextureSize, int padding)
+		{
+			std::vector<PackedTexture> packedTextures;
+			for (uint32 i = 0; i < AssetManager::s_Textures.size(); i++)
+			{
+				Handle<Texture> textureHandle = AssetManager::GetTextureHandle(i);
+				const Texture& texture = AssetManager::GetTexture(textureHandle);
+				// Compressed and streamed textures have their own upload paths, and pages never pack themselves
+				bool canPack = !textureHandle.IsNull() && !texture.IsDefault && !TextureUtil::IsNull(texture) && texture.Path.Path.size() > 0 &&
+					texture.Compression == CompressionQuality::None && !texture.GenerateMips &&
+					!AsyncTextureLoader::IsLoading(textureHandle) &&
+					texture.Width <= maxTextureSize && texture.Height <= maxTextureSize &&
+					texture.Width + padding * 2 <= pageSize && texture.Height + padding * 2 <= pageSize;
+				if (!canPack)
+				{
+					continue;
+				}
+
+				PackedTexture packedTexture;
+				packedTexture.TextureHandle = textureHandle;
+				int channels;
+				packedTexture.Pixels = stbi_load(texture.Path.Path.c_str(), &packedTexture.Width, &packedTexture.Height, &channels, 4);
+				if (!packedTexture.Pixels)
+				{
+					Log::Warning("STB failed to load image: %s\n-> STB Failure Reason: %s", texture.Path.Path.c_str(), stbi_failure_reason());
+					continue;
+				}
+
+				// The file may have changed on disk since it was loaded
+				if (packedTexture.Width != texture.Width || packedTexture.Height != texture.Height)
+				{
+					stbi_image_free(packedTexture.Pixels);
+					continue;
+				}
+				packedTextures.push_back(packedTexture);
+			}
+
+			// Tallest first keeps the shelves tight
+			std::sort(packedTextures.begin(), packedTextures.end(), [](const PackedTexture& a, const PackedTexture& b)
+				{
+					return a.Height != b.Height ? a.Height > b.Height : a.Width > b.Width;
+				});
+
+			// Textures only share a page with textures that are sampled the same way
+			std::vector<AtlasPage> pages;
+			std::unordered_map<int, int> openPages;
+			std::unordered_map<int, glm::ivec3> shelves;
+			for (auto& packedTexture : packedTextures)
+			{
+				const Texture& texture = AssetManager::GetTexture(packedTexture.TextureHandle);
+				int filterKey = (int)texture.MagFilter * 16 + (int)texture.MinFilter;
+				int paddedWidth = packedTexture.Width + padding * 2;
+				int paddedHeight = packedTexture.Height + padding * 2;
+
+				// Shelf is { cursorX, cursorY, shelfHeight }
+				auto pageIter = openPages.find(filterKey);
+				glm::ivec3& shelf = shelves[filterKey];
+				if (pageIter != openPages.end() && shelf.x + paddedWidth > pageSize)
+				{
+					shelf = glm::ivec3(0, shelf.y + shelf.z, 0);
+				}
+
+				if (pageIter == openPages.end() || shelf.y + paddedHeight > pageSize)
+				{
+					AtlasPage page;
+					page.Pixels.resize((size_t)pageSize * (size_t)pageSize * 4, 0);
+					page.MagFilter = texture.MagFilter;
+					page.MinFilter = texture.MinFilter;
+					pages.push_back(page);
+					openPages[filterKey] = (int)pages.size() - 1;
+					shelf = glm::ivec3(0, 0, 0);
+				}
+
+				packedTexture.Page = openPages[filterKey];
+				packedTexture.X = shelf.x + padding;
+				packedTexture.Y = shelf.y + padding;
+				shelf.x += paddedWidth;
+				shelf.z = glm::max(shelf.z, paddedHeight);
+
+				BlitWithBorder(packedTexture, padding, pageSize, pages[packedTexture.Page].Pixels.data());
+				stbi_image_free(packedTexture.Pixels);
+				packedTexture.Pixels = nullptr;
+			}
+
+			File::CreateDirIfNotExists(outputDirectory);
+			json manifest;
+			manifest["PageSize"] = pageSize;
+			manifest["Pages"] = json::array();
+			manifest["Regions"] = json::array();
+			for (int i = 0; i < (int)pages.size(); i++)
+			{
+				CPath pagePath = outputDirectory;
+				NCPath::Join(pagePath, NCPath::CreatePath("atlas_" + std::to_string(i) + ".png"));
+				stbi_write_png(pagePath.Path.c_str(), pageSize, pageSize, 4, pages[i].Pixels.data(), pageSize * 4);
+				manifest["Pages"].push_back({
+					{"Filepath", pagePath.Path.c_str()},
+					{"MagFilter", (int)pages[i].MagFilter},
+					{"MinFilter", (int)pages[i].MinFilter}
+				});
+			}
+
+			for (const auto& packedTexture : packedTextures)
+			{
+				const Texture& texture = AssetManager::GetTexture(packedTexture.TextureHandle);
+				manifest["Regions"].push_back({
+					{"Filepath", texture.Path.Path.c_str()},
+					{"Page", packedTexture.Page},
+					{"X", packedTexture.X},
+					{"Y", packedTexture.Y},
+					{"Width", packedTexture.Width},
+					{"Height", packedTexture.Height}
+				});
+			}
+			File::WriteFile(manifest.dump(4).c_str(), GetManifestPath(outputDirectory));
+
+			Log::Info("Packed %d textures into %d atlas pages.", (int)packedTextures.size(), (int)pages.size());
+			Load(outputDirectory);
+			return (int)packedTextures.size();
+		}
+
+		bool Load(const CPath& outputDirectory)
+		{
+			Clear();
+
+			CPath manifestPath = GetManifestPath(outputDirectory);
+			if (!File::IsFile(manifestPath))
+			{
+				return false;
+			}
+
+			FileHandle* file = File::OpenFile(manifestPath);
+			if (file->m_Size <= 0)
+			{
+				File::CloseFile(file);
+				return false;
+			}
+
+			json manifest = json::parse(file->m_Data, nullptr, false);
+			File::CloseFile(file);
+			if (manifest.is_discarded() || !manifest.contains("Pages") || !manifest.contains("Regions"))
+			{
+				Log::Warning("Invalid atlas manifest '%s'", manifestPath.Path.c_str());
+				return false;
+			}
+
+			int pageSize = 0;
+			JsonExtended::AssignIfNotNull(manifest, "PageSize", pageSize);
+			for (auto& pageJson : manifest["Pages"])
+			{
+				Texture page;
+				JsonExtended::AssignIfNotNull(pageJson, "Filepath", page.Path);
+				JsonExtended::AssignEnumIfNotNull<FilterMode>(pageJson, "MagFilter", page.MagFilter);
+				JsonExtended::AssignEnumIfNotNull<FilterMode>(pageJson, "MinFilter", page.MinFilter);
+				page.WrapS = WrapMode::None;
+				page.WrapT = WrapMode::None;
+				TextureUtil::Generate(page, page.Path);
+				m_Pages.push_back(AssetManager::AddGeneratedTexture(page));
+			}
+
+			m_Regions.resize(AssetManager::s_Textures.size());
+			for (auto& regionJson : manifest["Regions"])
+			{
+				CPath path;
+				int pageIndex = -1, x = 0, y = 0, width = 0, height = 0;
+				JsonExtended::AssignIfNotNull(regionJson, "Filepath", path);
+				JsonExtended::AssignIfNotNull(regionJson, "Page", pageIndex);
+				JsonExtended::AssignIfNotNull(regionJson, "X", x);
+				JsonExtended::AssignIfNotNull(regionJson, "Y", y);
+				JsonExtended::AssignIfNotNull(regionJson, "Width", width);
+				JsonExtended::AssignIfNotNull(regionJson, "Height", height);
+
+				// The source may have been edited since the atlas was built, those keep drawing from their own texture
+				Handle<Texture> textureHandle = AssetManager::GetTexture(path);
+				if (textureHandle.IsNull() || pageIndex < 0 || pageIndex >= (int)m_Pages.size() || pageSize <= 0)
+				{
+					continue;
+				}
+
+				const Texture& texture = AssetManager::GetTexture(textureHandle);
+				if (texture.Width != width || texture.Height != height)
+				{
+					continue;
+				}
+
+				AtlasRegion& region = m_Regions[textureHandle.Index()];
+				region.Source = textureHandle;
+				region.Page = m_Pages[pageIndex];
+				region.UvMin = glm::vec2((float)x, (float)y) / (float)pageSize;
+				region.UvSize = glm::vec2((float)width, (float)height) / (float)pageSize;
+			}
+
+			return true;
+		}
+
+		void Clear()
+		{
+			// Free the old pages so AssetManager::AddGeneratedTexture can reuse their slots
+			for (auto& page : m_Pages)
+			{
+				if (AssetManager::IsValid(page))
+				{
+					AssetManager::UnloadTexture(page);
+				}
+			}
+			m_Pages.clear();
+			m_Regions.clear();
+		}
+
+		Handle<Texture> Resolve(Handle<Texture> textureHandle, glm::vec2* texCoords, int numTexCoords)
+		{
+			if (textureHandle.IsNull() || textureHandle.Index() >= m_Regions.size())
+			{
+				return textureHandle;
+			}
+
+			// The region may belong to a texture that was unloaded since, and its slot reused
+			const AtlasRegion& region = m_Regions[textureHandle.Index()];
+			if (region.Page.IsNull() || region.Source != textureHandle)
+			{
+				return textureHandle;
+			}
+
+			// Repeating textures would sample their neighbours in the page
+			for (int i = 0; i < numTexCoords; i++)
+			{
+				if (texCoords[i].x < 0.0f || texCoords[i].x > 1.0f || texCoords[i].y < 0.0f || texCoords[i].y > 1.0f)
+				{
+					return textureHandle;
+				}
+			}
+
+			for (int i = 0; i < numTexCoords; i++)
+			{
+				texCoords[i] = region.UvMin + texCoords[i] * region.UvSize;
+			}
+			return region.Page;
+		}
+
+		const AtlasRegion* GetRegion(Handle<Texture> textureHandle)
+		{
+			if (textureHandle.IsNull() || textureHandle.Index() >= m_Regions.size() ||
+				m_Regions[textureHandle.Index()].Page.IsNull() || m_Regions[textureHandle.Index()].Source != textureHandle)
+			{
+				return nullptr;
+			}
+
+			return &m_Regions[textureHandle.Index()];
+		}
+
+		int NumPages()
+		{
+			return (int)m_Pages.size();
+		}
+
+		CPath GetDefaultDirectory()
+		{
+			CPath atlasDirectory = Settings::General::s_WorkingDirectory;
+			NCPath::Join(atlasDirectory, NCPath::CreatePath("assets"));
+			NCPath::Join(atlasDirectory, NCPath::CreatePath("atlas"));
+			return atlasDirectory;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static void BlitWithBorder(const PackedTexture& packedTexture, int padding, int pageSize, uint8* pagePixels)
+		{
+			// The padding repeats the edge pixels so filtering at the border never picks up a neighbouring texture
+			for (int y = -padding; y < packedTexture.Height + padding; y++)
+			{
+				int sourceY = glm::clamp(y, 0, packedTexture.Height - 1);
+				for (int x = -padding; x < packedTexture.Width + padding; x++)
+				{
+					int sourceX = glm::clamp(x, 0, packedTexture.Width - 1);
+					const uint8* source = packedTexture.Pixels + (sourceY * packedTexture.Width + sourceX) * 4;
+					uint8* destination = pagePixels + ((packedTexture.Y + y) * pageSize + (packedTexture.X + x)) * 4;
+					memcpy(destination, source, 4);
+				}
+			}
+		}
+
+		static CPath GetManifestPath(const CPath& directory)
+		{
+			CPath manifestPath = directory;
+			NCPath::Join(manifestPath, NCPath::CreatePath(MANIFEST_FILENAME));
+			return manifestPath;
+		}
+	}
+}
@@ -0,0 +1,1106 @@
+#include "externalLibs.h"
+
+#include "cocoa/renderer/TextureCooker.h"
+#include "cocoa/file/File.h"
+#include "cocoa/file/PackFile.h"
+#include "cocoa/util/Settings.h"
+#include "cocoa/util/Log.h"
+
+#include <stb_image.h>
+#include <atomic>
+
+namespace Cocoa
+{
+	namespace TextureCooker
+	{
+		struct CookedTextureHeader
+		{
+			uint32 Magic;
+			uint32 Version;
+			uint64 SourceHash;
+			int32 Width;
+			int32 Height;
+			uint32 Format;
+			uint32 NumMips;
+			uint32 DataSize;
+		};
+
+		// Internal Variables
+		static const uint32 COOKED_TEXTURE_MAGIC = 0x58455443; // "CTEX"
+		static const uint32 COOKED_TEXTURE_VERSION = 2;
+
+		// How much of endpoint1 each of BC7's 4 bit indices blends in, out of 64
+		static const int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// Set once the GL context exists, workers only read it
+		static std::atomic<bool> m_BC7Supported{ false };
+
+		// Forward Declarations
+		static bool ReadBinaryFile(const CPath& path, std::vector<uint8>& result);
+		static void EncodeLevel(const uint8* pixels, int width, int height, int channels, ByteFormat format, CompressionQuality quality, uint8* output);
+		static bool IsOpaque(const uint8* pixels, int width, int height, int channels);
+		static float SrgbToLinear(uint8 value);
+		static uint8 LinearToSrgb(float value);
+		static int MipTaps(int size, int mipSize, int mipPixel, int* pixels, float* weights);
+		static void ExtractBlock(const uint8* pixels, int width, int height, int channels, int blockX, int blockY, uint8* rgbaBlock);
+		static void EncodeColorBlock(const uint8* rgbaBlock, CompressionQuality quality, uint8* output);
+		static void EncodeAlphaBlock(const uint8* rgbaBlock, CompressionQuality quality, uint8* output);
+		static void FindEndpointsBoundingBox(const uint8* rgbaBlock, glm::vec3& endpoint0, glm::vec3& endpoint1);
+		static void FindEndpointsPrincipalAxis(const uint8* rgbaBlock, glm::vec3& endpoint0, glm::vec3& endpoint1);
+		static bool RefineEndpoints(const uint8* rgbaBlock, uint32 indices, glm::vec3& endpoint0, glm::vec3& endpoint1);
+		static uint32 FitColorIndices(const uint8* rgbaBlock, uint16& color0, uint16& color1, uint32& indices);
+		static uint32 FitAlphaIndices(const uint8* rgbaBlock, const uint8* palette, uint64& indices);
+		static uint16 PackColor565(const glm::vec3& color);
+		static glm::vec3 UnpackColor565(uint16 color);
+		static ByteFormat ChooseFormat(bool isOpaque, CompressionQuality quality);
+		static void FindEndpointsRgba(const uint8* rgbaBlock, CompressionQuality quality, glm::vec4& endpoint0, glm::vec4& endpoint1);
+		static uint32 FitBC7Endpoints(const uint8* rgbaBlock, const glm::vec4& endpoint0, const glm::vec4& endpoint1, glm::ivec4& quantized0, glm::ivec4& quantized1,
+			int& pBit0, int& pBit1, uint64& indices);
+		static uint32 FitBC7Indices(const uint8* rgbaBlock, const glm::ivec4& color0, const glm::ivec4& color1, uint64& indices);
+		static bool RefineBC7Endpoints(const uint8* rgbaBlock, uint64 indices, glm::vec4& endpoint0, glm::vec4& endpoint1);
+		static void WriteBits(uint8* output, uint32& bitOffset, uint32 value, int numBits);
+
+		bool Encode(const uint8* pixels, int width, int height, int channels, CompressionQuality quality, CookedTexture& result)
+		{
+			if (!pixels || width <= 0 || height <= 0 || channels < 1 || channels > 4)
+			{
+				Log::Warning("Cannot encode image with size %dx%d and %d channels.", width, height, channels);
+				return false;
+			}
+
+			if (quality == CompressionQuality::None)
+			{
+				quality = CompressionQuality::Normal;
+			}
+
+			// Only images with an alpha channel that is actually used need the bigger BC3 or BC7 blocks
+			result.Format = ChooseFormat(IsOpaque(pixels, width, height, channels), quality);
+			result.Width = width;
+			result.Height = height;
+			result.NumMips = 1;
+			result.Data.resize(LevelSize(result.Format, width, height));
+			EncodeLevel(pixels, width, height, channels, result.Format, quality, result.Data.data());
+			return true;
+		}
+
+		void EncodeBC1Block(const uint8* rgbaBlock, CompressionQuality quality, uint8* output)
+		{
+			EncodeColorBlock(rgbaBlock, quality, output);
+		}
+
+		void EncodeBC3Block(const uint8* rgbaBlock, CompressionQuality quality, uint8* output)
+		{
+			EncodeAlphaBlock(rgbaBlock, quality, output);
+			EncodeColorBlock(rgbaBlock, quality, output + 8);
+		}
+
+		void EncodeBC7Block(const uint8* rgbaBlock, CompressionQuality quality, uint8* output)
+		{
+			// Only mode 6 is used: one subset with RGBA endpoints of 7 bits plus a shared low bit each, and 4 bit
+			// indices. Color and alpha are interpolated together, which suits sprites whose edges fade out
+			glm::vec4 endpoint0, endpoint1;
+			FindEndpointsRgba(rgbaBlock, quality, endpoint0, endpoint1);
+
+			glm::ivec4 quantized0, quantized1;
+			int pBit0, pBit1;
+			uint64 indices;
+			uint32 error = FitBC7Endpoints(rgbaBlock, endpoint0, endpoint1, quantized0, quantized1, pBit0, pBit1, indices);
+
+			if (quality == CompressionQuality::High)
+			{
+				for (int iteration = 0; iteration < 2 && error > 0; iteration++)
+				{
+					glm::vec4 refined0, refined1;
+					if (!RefineBC7Endpoints(rgbaBlock, indices, refined0, refined1))
+					{
+						break;
+					}
+
+					glm::ivec4 refinedQuantized0, refinedQuantized1;
+					int refinedPBit0, refinedPBit1;
+					uint64 refinedIndices;
+					uint32 refinedError = FitBC7Endpoints(rgbaBlock, refined0, refined1, refinedQuantized0, refinedQuantized1, refinedPBit0, refinedPBit1, refinedIndices);
+					if (refinedError >= error)
+					{
+						break;
+					}
+
+					quantized0 = refinedQuantized0;
+					quantized1 = refinedQuantized1;
+					pBit0 = refinedPBit0;
+					pBit1 = refinedPBit1;
+					indices = refinedIndices;
+					error = refinedError;
+				}
+			}
+
+			// The first pixel's index only stores 3 bits, its top bit is always 0. If it needs the top bit the
+			// endpoints are swapped, which mirrors every index
+			if ((indices & 0xF) >= 8)
+			{
+				std::swap(quantized0, quantized1);
+				std::swap(pBit0, pBit1);
+				indices = ~indices;
+			}
+
+			memset(output, 0, 16);
+			uint32 bitOffset = 0;
+			WriteBits(output, bitOffset, 1 << 6, 7);
+			for (int channel = 0; channel < 4; channel++)
+			{
+				WriteBits(output, bitOffset, (uint32)quantized0[channel], 7);
+				WriteBits(output, bitOffset, (uint32)quantized1[channel], 7);
+			}
+			WriteBits(output, bitOffset, (uint32)pBit0, 1);
+			WriteBits(output, bitOffset, (uint32)pBit1, 1);
+			WriteBits(output, bitOffset, (uint32)(indices & 0x7), 3);
+			for (int i = 1; i < 16; i++)
+			{
+				WriteBits(output, bitOffset, (uint32)((indices >> (i * 4)) & 0xF), 4);
+			}
+		}
+
+		void SetBC7Supported(bool supported)
+		{
+			m_BC7Supported = supported;
+		}
+
+		bool IsBC7Supported()
+		{
+			return m_BC7Supported;
+		}
+
+		bool EncodeMipChain(const uint8* rgbaPixels, int width, int height, CompressionQuality quality, CookedTexture& result)
+		{
+			if (!rgbaPixels || width <= 0 || height <= 0)
+			{
+				Log::Warning("Cannot generate mips for image with size %dx%d.", width, height);
+				return false;
+			}
+
+			if (quality == CompressionQuality::None)
+			{
+				result.Format = ByteFormat::RGBA8;
+			}
+			else
+			{
+				// Every level shares the format of the full resolution image
+				result.Format = ChooseFormat(IsOpaque(rgbaPixels, width, height, 4), quality);
+			}
+			result.Width = width;
+			result.Height = height;
+			result.NumMips = NumMipLevels(width, height);
+			result.Data.resize(MipOffset(result.Format, width, height, result.NumMips));
+
+			std::vector<uint8> level(rgbaPixels, rgbaPixels + (size_t)width * (size_t)height * 4);
+			std::vector<uint8> nextLevel;
+			int levelWidth = width;
+			int levelHeight = height;
+			for (int i = 0; i < result.NumMips; i++)
+			{
+				uint8* output = result.Data.data() + MipOffset(result.Format, width, height, i);
+				if (result.Format == ByteFormat::RGBA8)
+				{
+					memcpy(output, level.data(), level.size());
+				}
+				else
+				{
+					EncodeLevel(level.data(), levelWidth, levelHeight, 4, result.Format, quality, output);
+				}
+
+				if (i + 1 < result.NumMips)
+				{
+					// Each level is filtered from the one above it, never from an already compressed level
+					int nextWidth = glm::max(levelWidth / 2, 1);
+					int nextHeight = glm::max(levelHeight / 2, 1);
+					nextLevel.resize((size_t)nextWidth * (size_t)nextHeight * 4);
+					GenerateMip(level.data(), levelWidth, levelHeight, nextLevel.data());
+					level.swap(nextLevel);
+					levelWidth = nextWidth;
+					levelHeight = nextHeight;
+				}
+			}
+
+			return true;
+		}
+
+		void GenerateMip(const uint8* rgbaPixels, int width, int height, uint8* output)
+		{
+			// Mip sizes round down like OpenGL's, so odd dimensions are filtered with three taps to cover every pixel
+			int mipWidth = glm::max(width / 2, 1);
+			int mipHeight = glm::max(height / 2, 1);
+			int pixelsX[3], pixelsY[3];
+			float weightsX[3], weightsY[3];
+			for (int y = 0; y < mipHeight; y++)
+			{
+				int numTapsY = MipTaps(height, mipHeight, y, pixelsY, weightsY);
+				for (int x = 0; x < mipWidth; x++)
+				{
+					int numTapsX = MipTaps(width, mipWidth, x, pixelsX, weightsX);
+					glm::vec3 weightedColor{ 0.0f, 0.0f, 0.0f };
+					glm::vec3 color{ 0.0f, 0.0f, 0.0f };
+					float alpha = 0.0f;
+					for (int sampleY = 0; sampleY < numTapsY; sampleY++)
+					{
+						for (int sampleX = 0; sampleX < numTapsX; sampleX++)
+						{
+							const uint8* pixel = rgbaPixels + (pixelsY[sampleY] * width + pixelsX[sampleX]) * 4;
+							glm::vec3 linearColor = glm::vec3(SrgbToLinear(pixel[0]), SrgbToLinear(pixel[1]), SrgbToLinear(pixel[2]));
+							float weight = weightsX[sampleX] * weightsY[sampleY];
+							float pixelAlpha = pixel[3] / 255.0f * weight;
+
+							weightedColor += linearColor * pixelAlpha;
+							color += linearColor * weight;
+							alpha += pixelAlpha;
+						}
+					}
+
+					// Fully transparent areas fall back to the plain average so their color stays stable
+					glm::vec3 result = alpha > 0.0f ? weightedColor / alpha : color;
+					uint8* mipPixel = output + (y * mipWidth + x) * 4;
+					mipPixel[0] = LinearToSrgb(result.r);
+					mipPixel[1] = LinearToSrgb(result.g);
+					mipPixel[2] = LinearToSrgb(result.b);
+					mipPixel[3] = (uint8)glm::clamp((int)(alpha * 255.0f + 0.5f), 0, 255);
+				}
+			}
+		}
+
+		bool Cook(const CPath& sourcePath, CompressionQuality quality, CookedTexture& result, bool generateMips)
+		{
+			if (quality == CompressionQuality::None && !generateMips)
+			{
+				Log::Warning("Tried to cook texture '%s' without compression or mips.", sourcePath.Path.c_str());
+				return false;
+			}
+
+			// Packed sources are hashed and decoded straight out of the pack's mapping
+			PackData packedSource;
+			std::vector<uint8> looseSource;
+			const uint8* sourceData = nullptr;
+			size_t sourceSize = 0;
+			if (PackFile::Read(sourcePath, packedSource))
+			{
+				sourceData = packedSource.Data;
+				sourceSize = packedSource.Size;
+			}
+			else if (ReadBinaryFile(sourcePath, looseSource))
+			{
+				sourceData = looseSource.data();
+				sourceSize = looseSource.size();
+			}
+			else
+			{
+				Log::Warning("Could not read texture source '%s'.", sourcePath.Path.c_str());
+				return false;
+			}
+
+			uint64 sourceHash = HashBytes(sourceData, sourceSize);
+			CPath cachePath = GetCachePath(sourceHash, quality, generateMips);
+			if (ReadCache(cachePath, sourceHash, result))
+			{
+				return true;
+			}
+
+			int width, height, channels;
+			uint8* pixels = stbi_load_from_memory(sourceData, (int)sourceSize, &width, &height, &channels, generateMips ? 4 : 0);
+			if (!pixels)
+			{
+				Log::Warning("STB failed to load image: %s\n-> STB Failure Reason: %s", sourcePath.Path.c_str(), stbi_failure_reason());
+				return false;
+			}
+
+			bool encoded = generateMips ?
+				EncodeMipChain(pixels, width, height, quality, result) :
+				Encode(pixels, width, height, channels, quality, result);
+			stbi_image_free(pixels);
+			if (!encoded)
+			{
+				return false;
+			}
+
+			// A failed cache write only costs us the encode next time, the cooked texture is still valid
+			if (!WriteCache(cachePath, sourceHash, result))
+			{
+				Log::Warning("Failed to write cooked texture '%s'.", cachePath.Path.c_str());
+			}
+
+			return true;
+		}
+
+		bool ReadCache(const CPath& cachePath, uint64 sourceHash, CookedTexture& result)
+		{
+			// Shipping builds carry the cache in their pack
+			PackData packedFile;
+			std::vector<uint8> looseFile;
+			const uint8* cookedData = nullptr;
+			size_t cookedSize = 0;
+			if (PackFile::Read(cachePath, packedFile))
+			{
+				cookedData = packedFile.Data;
+				cookedSize = packedFile.Size;
+			}
+			else if (File::IsFile(cachePath) && ReadBinaryFile(cachePath, looseFile))
+			{
+				cookedData = looseFile.data();
+				cookedSize = looseFile.size();
+			}
+
+			if (cookedSize < sizeof(CookedTextureHeader))
+			{
+				return false;
+			}
+
+			CookedTextureHeader header;
+			memcpy(&header, cookedData, sizeof(CookedTextureHeader));
+			ByteFormat format = (ByteFormat)header.Format;
+			bool validFormat = TextureUtil::ByteFormatIsCompressed(format) || format == ByteFormat::RGBA8;
+			if (header.Magic != COOKED_TEXTURE_MAGIC || header.Version != COOKED_TEXTURE_VERSION || header.SourceHash != sourceHash || !validFormat ||
+				header.NumMips < 1 || (int)header.NumMips > NumMipLevels(header.Width, header.Height) ||
+				header.DataSize != MipOffset(format, header.Width, header.Height, header.NumMips) ||
+				cookedSize != sizeof(CookedTextureHeader) + header.DataSize)
+			{
+				Log::Warning("Ignoring stale or corrupt cooked texture '%s'.", cachePath.Path.c_str());
+				return false;
+			}
+
+			result.Format = format;
+			result.Width = header.Width;
+			result.Height = header.Height;
+			result.NumMips = header.NumMips;
+			result.Data.assign(cookedData + sizeof(CookedTextureHeader), cookedData + cookedSize);
+			return true;
+		}
+
+		bool WriteCache(const CPath& cachePath, uint64 sourceHash, const CookedTexture& cookedTexture)
+		{
+			CookedTextureHeader header;
+			header.Magic = COOKED_TEXTURE_MAGIC;
+			header.Version = COOKED_TEXTURE_VERSION;
+			header.SourceHash = sourceHash;
+			header.Width = cookedTexture.Width;
+			header.Height = cookedTexture.Height;
+			header.Format = (uint32)cookedTexture.Format;
+			header.NumMips = (uint32)cookedTexture.NumMips;
+			header.DataSize = (uint32)cookedTexture.Data.size();
+
+			std::vector<uint8> cookedFile(sizeof(CookedTextureHeader) + cookedTexture.Data.size());
+			memcpy(cookedFile.data(), &header, sizeof(CookedTextureHeader));
+			memcpy(cookedFile.data() + sizeof(CookedTextureHeader), cookedTexture.Data.data(), cookedTexture.Data.size());
+			return File::WriteFile(cookedFile.data(), (uint32)cookedFile.size(), cachePath);
+		}
+
+		CPath GetCacheDirectory()
+		{
+			CPath cacheDirectory = Settings::General::s_WorkingDirectory;
+			NCPath::Join(cacheDirectory, NCPath::CreatePath(".cache"));
+			File::CreateDirIfNotExists(cacheDirectory);
+			NCPath::Join(cacheDirectory, NCPath::CreatePath("textures"));
+			File::CreateDirIfNotExists(cacheDirectory);
+			return cacheDirectory;
+		}
+
+		CPath GetCachePath(uint64 sourceHash, CompressionQuality quality, bool generateMips)
+		{
+			char filename[64];
+			// High quality images with alpha cook differently depending on BC7 support, so those get their own entries
+			const char* formatSuffix = quality == CompressionQuality::High && m_BC7Supported ? "_bc7" : "";
+			snprintf(filename, sizeof(filename), "%016llx_q%d%s%s.ctex", (unsigned long long)sourceHash, (int)quality, formatSuffix, generateMips ? "_mips" : "");
+
+			CPath cachePath = GetCacheDirectory();
+			NCPath::Join(cachePath, NCPath::CreatePath(filename));
+			return cachePath;
+		}
+
+		uint64 HashBytes(const uint8* data, size_t size)
+		{
+			// 64 bit FNV-1a
+			uint64 hash = 14695981039346656037ull;
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= data[i];
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		int NumMipLevels(int width, int height)
+		{
+			int numLevels = 1;
+			int size = glm::max(width, height);
+			while (size > 1)
+			{
+				size /= 2;
+				numLevels++;
+			}
+			return numLevels;
+		}
+
+		uint32 LevelSize(ByteFormat format, int width, int height)
+		{
+			uint32 numBlocks = (uint32)((width + 3) / 4) * (uint32)((height + 3) / 4);
+			switch (format)
+			{
+			case ByteFormat::BC1_RGB:
+				return numBlocks * 8;
+			case ByteFormat::BC3_RGBA:
+			case ByteFormat::BC7_RGBA:
+				return numBlocks * 16;
+			case ByteFormat::RGBA8:
+				return (uint32)width * (uint32)height * 4;
+			default:
+				Log::Warning("Unknown cooked texture format '%d'", format);
+			}
+
+			return 0;
+		}
+
+		uint32 MipOffset(ByteFormat format, int width, int height, int level)
+		{
+			uint32 offset = 0;
+			for (int i = 0; i < level; i++)
+			{
+				offset += LevelSize(format, glm::max(width >> i, 1), glm::max(height >> i, 1));
+			}
+			return offset;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static bool ReadBinaryFile(const CPath& path, std::vector<uint8>& result)
+		{
+			// This runs on the texture loader threads, so stay away from the tracked allocator File::OpenFile uses
+			std::ifstream inStream(path.Path, std::ios::in | std::ios::binary);
+			if (!inStream)
+			{
+				return false;
+			}
+
+			inStream.seekg(0, std::ios::end);
+			std::streamoff size = inStream.tellg();
+			if (size <= 0)
+			{
+				return false;
+			}
+
+			result.resize((size_t)size);
+			inStream.seekg(0, std::ios::beg);
+			inStream.read((char*)result.data(), size);
+			return !inStream.fail();
+		}
+
+		static void EncodeLevel(const uint8* pixels, int width, int height, int channels, ByteFormat format, CompressionQuality quality, uint8* output)
+		{
+			int blockSize = format == ByteFormat::BC1_RGB ? 8 : 16;
+			int blocksWide = (width + 3) / 4;
+			int blocksHigh = (height + 3) / 4;
+			uint8 rgbaBlock[16 * 4];
+			for (int blockY = 0; blockY < blocksHigh; blockY++)
+			{
+				for (int blockX = 0; blockX < blocksWide; blockX++)
+				{
+					ExtractBlock(pixels, width, height, channels, blockX, blockY, rgbaBlock);
+					uint8* blockOutput = output + (blockY * blocksWide + blockX) * blockSize;
+					if (format == ByteFormat::BC1_RGB)
+					{
+						EncodeBC1Block(rgbaBlock, quality, blockOutput);
+					}
+					else if (format == ByteFormat::BC7_RGBA)
+					{
+						EncodeBC7Block(rgbaBlock, quality, blockOutput);
+					}
+					else
+					{
+						EncodeBC3Block(rgbaBlock, quality, blockOutput);
+					}
+				}
+			}
+		}
+
+		static bool IsOpaque(const uint8* pixels, int width, int height, int channels)
+		{
+			if (channels == 1 || channels == 3)
+			{
+				return true;
+			}
+
+			int numPixels = width * height;
+			for (int i = 0; i < numPixels; i++)
+			{
+				if (pixels[i * channels + channels - 1] != 255)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		static float SrgbToLinear(uint8 value)
+		{
+			static const std::array<float, 256> lookupTable = []()
+			{
+				std::array<float, 256> table;
+				for (int i = 0; i < 256; i++)
+				{
+					float srgb = i / 255.0f;
+					table[i] = srgb <= 0.04045f ? srgb / 12.92f : glm::pow((srgb + 0.055f) / 1.055f, 2.4f);
+				}
+				return table;
+			}();
+
+			return lookupTable[value];
+		}
+
+		static uint8 LinearToSrgb(float value)
+		{
+			value = glm::clamp(value, 0.0f, 1.0f);
+			float srgb = value <= 0.0031308f ? value * 12.92f : 1.055f * glm::pow(value, 1.0f / 2.4f) - 0.055f;
+			return (uint8)glm::clamp((int)(srgb * 255.0f + 0.5f), 0, 255);
+		}
+
+		static int MipTaps(int size, int mipSize, int mipPixel, int* pixels, float* weights)
+		{
+			if (size == 1)
+			{
+				pixels[0] = 0;
+				weights[0] = 1.0f;
+				return 1;
+			}
+
+			pixels[0] = mipPixel * 2;
+			pixels[1] = mipPixel * 2 + 1;
+			if (size % 2 == 0)
+			{
+				weights[0] = 0.5f;
+				weights[1] = 0.5f;
+				return 2;
+			}
+
+			// Each mip pixel covers size / mipSize source pixels, so the taps overlap their neighbours by a fraction that
+			// shifts across the row
+			pixels[2] = mipPixel * 2 + 2;
+			weights[0] = (float)(mipSize - mipPixel) / (float)size;
+			weights[1] = (float)mipSize / (float)size;
+			weights[2] = (float)(mipPixel + 1) / (float)size;
+			return 3;
+		}
+
+		static void ExtractBlock(const uint8* pixels, int width, int height, int channels, int blockX, int blockY, uint8* rgbaBlock)
+		{
+			for (int y = 0; y < 4; y++)
+			{
+				// Blocks that hang off the edge of the image repeat the edge pixels so they do not skew the endpoints
+				int pixelY = glm::min(blockY * 4 + y, height - 1);
+				for (int x = 0; x < 4; x++)
+				{
+					int pixelX = glm::min(blockX * 4 + x, width - 1);
+					const uint8* pixel = pixels + (pixelY * width + pixelX) * channels;
+					uint8* blockPixel = rgbaBlock + (y * 4 + x) * 4;
+					switch (channels)
+					{
+					case 1:
+						blockPixel[0] = blockPixel[1] = blockPixel[2] = pixel[0];
+						blockPixel[3] = 255;
+						break;
+					case 2:
+						blockPixel[0] = blockPixel[1] = blockPixel[2] = pixel[0];
+						blockPixel[3] = pixel[1];
+						break;
+					case 3:
+						blockPixel[0] = pixel[0];
+						blockPixel[1] = pixel[1];
+						blockPixel[2] = pixel[2];
+						blockPixel[3] = 255;
+						break;
+					default:
+						blockPixel[0] = pixel[0];
+						blockPixel[1] = pixel[1];
+						blockPixel[2] = pixel[2];
+						blockPixel[3] = pixel[3];
+						break;
+					}
+				}
+			}
+		}
+
+		static void EncodeColorBlock(const uint8* rgbaBlock, CompressionQuality quality, uint8* output)
+		{
+			glm::vec3 endpoint0, endpoint1;
+			if (quality == CompressionQuality::Fast)
+			{
+				FindEndpointsBoundingBox(rgbaBlock, endpoint0, endpoint1);
+			}
+			else
+			{
+				FindEndpointsPrincipalAxis(rgbaBlock, endpoint0, endpoint1);
+			}
+
+			uint16 color0 = PackColor565(endpoint0);
+			uint16 color1 = PackColor565(endpoint1);
+			uint32 indices;
+			uint32 error = FitColorIndices(rgbaBlock, color0, color1, indices);
+
+			if (quality == CompressionQuality::High)
+			{
+				// Least squares fit the endpoints to the chosen indices, then pick new indices for those endpoints
+				for (int iteration = 0; iteration < 2 && error > 0; iteration++)
+				{
+					glm::vec3 refined0, refined1;
+					if (!RefineEndpoints(rgbaBlock, indices, refined0, refined1))
+					{
+						break;
+					}
+
+					uint16 refinedColor0 = PackColor565(refined0);
+					uint16 refinedColor1 = PackColor565(refined1);
+					uint32 refinedIndices;
+					uint32 refinedError = FitColorIndices(rgbaBlock, refinedColor0, refinedColor1, refinedIndices);
+					if (refinedError >= error)
+					{
+						break;
+					}
+
+					color0 = refinedColor0;
+					color1 = refinedColor1;
+					indices = refinedIndices;
+					error = refinedError;
+				}
+			}
+
+			output[0] = (uint8)(color0 & 0xFF);
+			output[1] = (uint8)(color0 >> 8);
+			output[2] = (uint8)(color1 & 0xFF);
+			output[3] = (uint8)(color1 >> 8);
+			output[4] = (uint8)(indices & 0xFF);
+			output[5] = (uint8)((indices >> 8) & 0xFF);
+			output[6] = (uint8)((indices >> 16) & 0xFF);
+			output[7] = (uint8)(indices >> 24);
+		}
+
+		static void EncodeAlphaBlock(const uint8* rgbaBlock, CompressionQuality quality, uint8* output)
+		{
+			uint8 minAlpha = 255;
+			uint8 maxAlpha = 0;
+			uint8 minInnerAlpha = 255;
+			uint8 maxInnerAlpha = 0;
+			for (int i = 0; i < 16; i++)
+			{
+				uint8 alpha = rgbaBlock[i * 4 + 3];
+				minAlpha = glm::min(minAlpha, alpha);
+				maxAlpha = glm::max(maxAlpha, alpha);
+				if (alpha != 0 && alpha != 255)
+				{
+					minInnerAlpha = glm::min(minInnerAlpha, alpha);
+					maxInnerAlpha = glm::max(maxInnerAlpha, alpha);
+				}
+			}
+
+			// Alpha0 > alpha1 selects 8 interpolated values
+			uint8 palette[8];
+			palette[0] = maxAlpha;
+			palette[1] = minAlpha;
+			for (int i = 2; i < 8; i++)
+			{
+				palette[i] = (uint8)(((8 - i) * maxAlpha + (i - 1) * minAlpha) / 7);
+			}
+
+			uint64 indices;
+			uint32 error = FitAlphaIndices(rgbaBlock, palette, indices);
+
+			// Alpha0 <= alpha1 selects 6 interpolated values plus exact 0 and 255, which is better for cutout sprites with soft edges
+			if (quality == CompressionQuality::High && error > 0 && minInnerAlpha <= maxInnerAlpha)
+			{
+				uint8 innerPalette[8];
+				innerPalette[0] = minInnerAlpha;
+				innerPalette[1] = maxInnerAlpha;
+				for (int i = 2; i < 6; i++)
+				{
+					innerPalette[i] = (uint8)(((6 - i) * minInnerAlpha + (i - 1) * maxInnerAlpha) / 5);
+				}
+				innerPalette[6] = 0;
+				innerPalette[7] = 255;
+
+				uint64 innerIndices;
+				uint32 innerError = FitAlphaIndices(rgbaBlock, innerPalette, innerIndices);
+				if (innerError < error)
+				{
+					memcpy(palette, innerPalette, sizeof(palette));
+					indices = innerIndices;
+				}
+			}
+
+			output[0] = palette[0];
+			output[1] = palette[1];
+			for (int i = 0; i < 6; i++)
+			{
+				output[2 + i] = (uint8)((indices >> (i * 8)) & 0xFF);
+			}
+		}
+
+		static void FindEndpointsBoundingBox(const uint8* rgbaBlock, glm::vec3& endpoint0, glm::vec3& endpoint1)
+		{
+			glm::vec3 minColor{ 255.0f, 255.0f, 255.0f };
+			glm::vec3 maxColor{ 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				glm::vec3 color = glm::vec3(rgbaBlock[i * 4], rgbaBlock[i * 4 + 1], rgbaBlock[i * 4 + 2]);
+				minColor = glm::min(minColor, color);
+				maxColor = glm::max(maxColor, color);
+			}
+
+			// Pull the endpoints in slightly, the extremes are usually only hit by one or two pixels
+			glm::vec3 inset = (maxColor - minColor) / 16.0f;
+			endpoint0 = maxColor - inset;
+			endpoint1 = minColor + inset;
+		}
+
+		static void FindEndpointsPrincipalAxis(const uint8* rgbaBlock, glm::vec3& endpoint0, glm::vec3& endpoint1)
+		{
+			glm::vec3 colors[16];
+			glm::vec3 mean{ 0.0f, 0.0f, 0.0f };
+			glm::vec3 minColor{ 255.0f, 255.0f, 255.0f };
+			glm::vec3 maxColor{ 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				colors[i] = glm::vec3(rgbaBlock[i * 4], rgbaBlock[i * 4 + 1], rgbaBlock[i * 4 + 2]);
+				mean += colors[i];
+				minColor = glm::min(minColor, colors[i]);
+				maxColor = glm::max(maxColor, colors[i]);
+			}
+			mean /= 16.0f;
+
+			glm::mat3 covariance{ 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				glm::vec3 offset = colors[i] - mean;
+				covariance += glm::outerProduct(offset, offset);
+			}
+
+			// Power iteration converges on the direction the colors are spread along the most, starting from the bounding box diagonal
+			glm::vec3 axis = maxColor - minColor;
+			for (int iteration = 0; iteration < 8; iteration++)
+			{
+				axis = covariance * axis;
+				float length = glm::length(axis);
+				if (length < 0.0001f)
+				{
+					// Every pixel in the block is the same color, or the spread cancelled out
+					FindEndpointsBoundingBox(rgbaBlock, endpoint0, endpoint1);
+					return;
+				}
+				axis /= length;
+			}
+
+			float minProjection = FLT_MAX;
+			float maxProjection = -FLT_MAX;
+			for (int i = 0; i < 16; i++)
+			{
+				float projection = glm::dot(colors[i] - mean, axis);
+				minProjection = glm::min(minProjection, projection);
+				maxProjection = glm::max(maxProjection, projection);
+			}
+
+			glm::vec3 inset = axis * ((maxProjection - minProjection) / 16.0f);
+			endpoint0 = glm::clamp(mean + axis * maxProjection - inset, 0.0f, 255.0f);
+			endpoint1 = glm::clamp(mean + axis * minProjection + inset, 0.0f, 255.0f);
+		}
+
+		static bool RefineEndpoints(const uint8* rgbaBlock, uint32 indices, glm::vec3& endpoint0, glm::vec3& endpoint1)
+		{
+			// How much of endpoint0 each index blends in
+			static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+			float alpha2 = 0.0f;
+			float beta2 = 0.0f;
+			float alphaBeta = 0.0f;
+			glm::vec3 alphaColor{ 0.0f, 0.0f, 0.0f };
+			glm::vec3 betaColor{ 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				float alpha = weights[(indices >> (i * 2)) & 0x3];
+				float beta = 1.0f - alpha;
+				glm::vec3 color = glm::vec3(rgbaBlock[i * 4], rgbaBlock[i * 4 + 1], rgbaBlock[i * 4 + 2]);
+
+				alpha2 += alpha * alpha;
+				beta2 += beta * beta;
+				alphaBeta += alpha * beta;
+				alphaColor += alpha * color;
+				betaColor += beta * color;
+			}
+
+			float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+			if (glm::abs(determinant) < 0.0001f)
+			{
+				return false;
+			}
+
+			endpoint0 = glm::clamp((alphaColor * beta2 - betaColor * alphaBeta) / determinant, 0.0f, 255.0f);
+			endpoint1 = glm::clamp((betaColor * alpha2 - alphaColor * alphaBeta) / determinant, 0.0f, 255.0f);
+			return true;
+		}
+
+		static uint32 FitColorIndices(const uint8* rgbaBlock, uint16& color0, uint16& color1, uint32& indices)
+		{
+			// Color0 > color1 selects the 4 color mode, equal colors fall back to the 3 color mode where index 0 is still color0.
+			// The colors are swapped in place so the caller writes them in the order the indices expect
+			if (color0 < color1)
+			{
+				std::swap(color0, color1);
+			}
+
+			glm::vec3 palette[4];
+			palette[0] = UnpackColor565(color0);
+			palette[1] = UnpackColor565(color1);
+			palette[2] = (2.0f * palette[0] + palette[1]) / 3.0f;
+			palette[3] = (palette[0] + 2.0f * palette[1]) / 3.0f;
+			int numColors = color0 == color1 ? 1 : 4;
+
+			indices = 0;
+			uint32 error = 0;
+			for (int i = 0; i < 16; i++)
+			{
+				glm::vec3 color = glm::vec3(rgbaBlock[i * 4], rgbaBlock[i * 4 + 1], rgbaBlock[i * 4 + 2]);
+				uint32 bestIndex = 0;
+				float bestDistance = FLT_MAX;
+				for (int j = 0; j < numColors; j++)
+				{
+					glm::vec3 difference = color - palette[j];
+					float distance = glm::dot(difference, difference);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = j;
+					}
+				}
+
+				indices |= bestIndex << (i * 2);
+				error += (uint32)bestDistance;
+			}
+
+			return error;
+		}
+
+		static uint32 FitAlphaIndices(const uint8* rgbaBlock, const uint8* palette, uint64& indices)
+		{
+			indices = 0;
+			uint32 error = 0;
+			for (int i = 0; i < 16; i++)
+			{
+				int alpha = rgbaBlock[i * 4 + 3];
+				uint64 bestIndex = 0;
+				int bestDistance = INT_MAX;
+				for (int j = 0; j < 8; j++)
+				{
+					int distance = (alpha - palette[j]) * (alpha - palette[j]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = j;
+					}
+				}
+
+				indices |= bestIndex << (i * 3);
+				error += bestDistance;
+			}
+
+			return error;
+		}
+
+		static uint16 PackColor565(const glm::vec3& color)
+		{
+			uint16 r = (uint16)glm::clamp((int)(color.r * 31.0f / 255.0f + 0.5f), 0, 31);
+			uint16 g = (uint16)glm::clamp((int)(color.g * 63.0f / 255.0f + 0.5f), 0, 63);
+			uint16 b = (uint16)glm::clamp((int)(color.b * 31.0f / 255.0f + 0.5f), 0, 31);
+			return (r << 11) | (g << 5) | b;
+		}
+
+		static glm::vec3 UnpackColor565(uint16 color)
+		{
+			uint8 r = (color >> 11) & 0x1F;
+			uint8 g = (color >> 5) & 0x3F;
+			uint8 b = color & 0x1F;
+			return glm::vec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+		}
+
+		static ByteFormat ChooseFormat(bool isOpaque, CompressionQuality quality)
+		{
+			if (isOpaque)
+			{
+				return ByteFormat::BC1_RGB;
+			}
+
+			// BC7 is the same size as BC3 but keeps far more detail in soft alpha edges, it's worth its encode time at High
+			return quality == CompressionQuality::High && m_BC7Supported ? ByteFormat::BC7_RGBA : ByteFormat::BC3_RGBA;
+		}
+
+		static void FindEndpointsRgba(const uint8* rgbaBlock, CompressionQuality quality, glm::vec4& endpoint0, glm::vec4& endpoint1)
+		{
+			glm::vec4 colors[16];
+			glm::vec4 mean{ 0.0f, 0.0f, 0.0f, 0.0f };
+			glm::vec4 minColor{ 255.0f, 255.0f, 255.0f, 255.0f };
+			glm::vec4 maxColor{ 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				colors[i] = glm::vec4(rgbaBlock[i * 4], rgbaBlock[i * 4 + 1], rgbaBlock[i * 4 + 2], rgbaBlock[i * 4 + 3]);
+				mean += colors[i];
+				minColor = glm::min(minColor, colors[i]);
+				maxColor = glm::max(maxColor, colors[i]);
+			}
+			mean /= 16.0f;
+
+			glm::vec4 axis = maxColor - minColor;
+			if (quality != CompressionQuality::Fast)
+			{
+				glm::mat4 covariance{ 0.0f };
+				for (int i = 0; i < 16; i++)
+				{
+					glm::vec4 offset = colors[i] - mean;
+					covariance += glm::outerProduct(offset, offset);
+				}
+
+				for (int iteration = 0; iteration < 8; iteration++)
+				{
+					glm::vec4 nextAxis = covariance * axis;
+					if (glm::length(nextAxis) < 0.0001f)
+					{
+						break;
+					}
+					axis = glm::normalize(nextAxis);
+				}
+			}
+
+			float length = glm::length(axis);
+			if (length < 0.0001f)
+			{
+				// Every pixel in the block is the same
+				endpoint0 = mean;
+				endpoint1 = mean;
+				return;
+			}
+			axis /= length;
+
+			float minProjection = FLT_MAX;
+			float maxProjection = -FLT_MAX;
+			for (int i = 0; i < 16; i++)
+			{
+				float projection = glm::dot(colors[i] - mean, axis);
+				minProjection = glm::min(minProjection, projection);
+				maxProjection = glm::max(maxProjection, projection);
+			}
+
+			endpoint0 = glm::clamp(mean + axis * minProjection, 0.0f, 255.0f);
+			endpoint1 = glm::clamp(mean + axis * maxProjection, 0.0f, 255.0f);
+		}
+
+		static uint32 FitBC7Endpoints(const uint8* rgbaBlock, const glm::vec4& endpoint0, const glm::vec4& endpoint1, glm::ivec4& quantized0, glm::ivec4& quantized1,
+			int& pBit0, int& pBit1, uint64& indices)
+		{
+			// The shared low bit of each endpoint is picked by trying all four combinations
+			uint32 bestError = UINT_MAX;
+			for (int pBits = 0; pBits < 4; pBits++)
+			{
+				int p0 = pBits & 1;
+				int p1 = pBits >> 1;
+				glm::ivec4 q0, q1;
+				for (int channel = 0; channel < 4; channel++)
+				{
+					q0[channel] = glm::clamp((int)((endpoint0[channel] - p0) / 2.0f + 0.5f), 0, 127);
+					q1[channel] = glm::clamp((int)((endpoint1[channel] - p1) / 2.0f + 0.5f), 0, 127);
+				}
+
+				uint64 candidateIndices;
+				uint32 error = FitBC7Indices(rgbaBlock, (q0 << 1) | p0, (q1 << 1) | p1, candidateIndices);
+				if (error < bestError)
+				{
+					bestError = error;
+					quantized0 = q0;
+					quantized1 = q1;
+					pBit0 = p0;
+					pBit1 = p1;
+					indices = candidateIndices;
+				}
+			}
+
+			return bestError;
+		}
+
+		static uint32 FitBC7Indices(const uint8* rgbaBlock, const glm::ivec4& color0, const glm::ivec4& color1, uint64& indices)
+		{
+			glm::ivec4 palette[16];
+			for (int i = 0; i < 16; i++)
+			{
+				palette[i] = ((64 - BC7_WEIGHTS[i]) * color0 + BC7_WEIGHTS[i] * color1 + 32) >> 6;
+			}
+
+			indices = 0;
+			uint32 error = 0;
+			for (int i = 0; i < 16; i++)
+			{
+				glm::ivec4 color = glm::ivec4(rgbaBlock[i * 4], rgbaBlock[i * 4 + 1], rgbaBlock[i * 4 + 2], rgbaBlock[i * 4 + 3]);
+				uint64 bestIndex = 0;
+				int bestDistance = INT_MAX;
+				for (int j = 0; j < 16; j++)
+				{
+					glm::ivec4 difference = color - palette[j];
+					int distance = difference.r * difference.r + difference.g * difference.g + difference.b * difference.b + difference.a * difference.a;
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = j;
+					}
+				}
+
+				indices |= bestIndex << (i * 4);
+				error += bestDistance;
+			}
+
+			return error;
+		}
+
+		static bool RefineBC7Endpoints(const uint8* rgbaBlock, uint64 indices, glm::vec4& endpoint0, glm::vec4& endpoint1)
+		{
+			float alpha2 = 0.0f;
+			float beta2 = 0.0f;
+			float alphaBeta = 0.0f;
+			glm::vec4 alphaColor{ 0.0f, 0.0f, 0.0f, 0.0f };
+			glm::vec4 betaColor{ 0.0f, 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 16; i++)
+			{
+				float beta = BC7_WEIGHTS[(indices >> (i * 4)) & 0xF] / 64.0f;
+				float alpha = 1.0f - beta;
+				glm::vec4 color = glm::vec4(rgbaBlock[i * 4], rgbaBlock[i * 4 + 1], rgbaBlock[i * 4 + 2], rgbaBlock[i * 4 + 3]);
+
+				alpha2 += alpha * alpha;
+				beta2 += beta * beta;
+				alphaBeta += alpha * beta;
+				alphaColor += alpha * color;
+				betaColor += beta * color;
+			}
+
+			float determinant = alpha2 * beta2 - alphaBeta * alphaBeta;
+			if (glm::abs(determinant) < 0.0001f)
+			{
+				return false;
+			}
+
+			endpoint0 = glm::clamp((alphaColor * beta2 - betaColor * alphaBeta) / determinant, 0.0f, 255.0f);
+			endpoint1 = glm::clamp((betaColor * alpha2 - alphaColor * alphaBeta) / determinant, 0.0f, 255.0f);
+			return true;
+		}
+
+		static void WriteBits(uint8* output, uint32& bitOffset, uint32 value, int numBits)
+		{
+			// Fields are packed from the lowest bit of the first byte up
+			for (int i = 0; i < numBits; i++)
+			{
+				if (value & (1u << i))
+				{
+					output[bitOffset >> 3] |= (uint8)(1u << (bitOffset & 7));
+				}
+				bitOffset++;
+			}
+		}
+	}
+}
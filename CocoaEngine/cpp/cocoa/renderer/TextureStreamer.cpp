@@ -0,0 +1,291 @@
+#include "externalLibs.h"
+
+#include "cocoa/renderer/TextureStreamer.h"
+#include "cocoa/core/AssetManager.h"
+#include "cocoa/util/Settings.h"
+#include "cocoa/util/Log.h"
+
+namespace Cocoa
+{
+	namespace TextureStreamer
+	{
+		struct StreamedTexture
+		{
+			Handle<Texture> TextureHandle;
+			CookedTexture Mips;
+
+			// Finest level currently on the GPU, the level the streamer is moving towards, and the coarsest level that
+			// always stays resident
+			int ResidentLevel;
+			int WantedLevel;
+			int TailLevel;
+
+			// Finest level the renderer asked for the last time this texture was drawn
+			int NeededLevel;
+			glm::vec2 MaxScreenSize;
+			uint32 LastUsedFrame;
+		};
+
+		// Internal Variables
+		// Mips at or below this size are uploaded on registration and never dropped
+		static const int TAIL_SIZE = 64;
+		// Textures that have not been drawn for this many frames give their fine mips back
+		static const uint32 UNUSED_FRAMES = 300;
+
+		static std::unordered_map<uint32, StreamedTexture> m_Textures;
+		static uint64 m_ResidentBytes = 0;
+		static uint32 m_Frame = 0;
+
+		// Forward Declarations
+		static uint64 ResidentBytes(const StreamedTexture& streamedTexture, int firstLevel);
+		static int LevelForScreenSize(const StreamedTexture& streamedTexture);
+		static void MakeResident(StreamedTexture& streamedTexture, int level);
+		static StreamedTexture* FindEvictionCandidate();
+
+		void Init()
+		{
+			m_Textures.clear();
+			m_ResidentBytes = 0;
+			m_Frame = 0;
+		}
+
+		void Destroy()
+		{
+			// The GL textures belong to the AssetManager, we only drop the cpu side mip chains
+			Clear();
+		}
+
+		void Register(Handle<Texture> textureHandle, CookedTexture& cookedTexture)
+		{
+			Log::Assert(cookedTexture.NumMips > 0, "Cannot stream a texture without any mip levels.");
+			Unregister(textureHandle);
+			if (!AssetManager::IsValid(textureHandle))
+			{
+				Log::Warning("Tried to stream texture with invalid handle '%d'", textureHandle.m_AssetId);
+				return;
+			}
+
+			StreamedTexture streamedTexture;
+			streamedTexture.TextureHandle = textureHandle;
+			streamedTexture.Mips = std::move(cookedTexture);
+			streamedTexture.TailLevel = streamedTexture.Mips.NumMips - 1;
+			for (int level = 0; level < streamedTexture.Mips.NumMips; level++)
+			{
+				if (glm::max(streamedTexture.Mips.Width >> level, streamedTexture.Mips.Height >> level) <= TAIL_SIZE)
+				{
+					streamedTexture.TailLevel = level;
+					break;
+				}
+			}
+			streamedTexture.ResidentLevel = streamedTexture.TailLevel;
+			streamedTexture.WantedLevel = streamedTexture.TailLevel;
+			streamedTexture.NeededLevel = streamedTexture.TailLevel;
+			streamedTexture.MaxScreenSize = glm::vec2(0.0f);
+			streamedTexture.LastUsedFrame = m_Frame;
+
+			TextureUtil::UploadMips(AssetManager::s_Textures[textureHandle.Index()], streamedTexture.Mips, streamedTexture.TailLevel);
+			m_ResidentBytes += ResidentBytes(streamedTexture, streamedTexture.ResidentLevel);
+			m_Textures[textureHandle.m_AssetId] = std::move(streamedTexture);
+		}
+
+		void Unregister(Handle<Texture> textureHandle)
+		{
+			auto iter = m_Textures.find(textureHandle.m_AssetId);
+			if (iter != m_Textures.end())
+			{
+				m_ResidentBytes -= ResidentBytes(iter->second, iter->second.ResidentLevel);
+				m_Textures.erase(iter);
+			}
+		}
+
+		void Clear()
+		{
+			m_Textures.clear();
+			m_ResidentBytes = 0;
+		}
+
+		void ReportUsage(Handle<Texture> textureHandle, const glm::vec2& screenSize)
+		{
+			auto iter = m_Textures.find(textureHandle.m_AssetId);
+			if (iter != m_Textures.end())
+			{
+				StreamedTexture& streamedTexture = iter->second;
+				streamedTexture.MaxScreenSize = glm::max(streamedTexture.MaxScreenSize, glm::abs(screenSize));
+				streamedTexture.LastUsedFrame = m_Frame;
+			}
+		}
+
+		void Update(int maxUploads)
+		{
+			uint64 budget = (uint64)glm::max(Settings::Graphics::s_TextureMemoryBudgetMb, 0) * 1024 * 1024;
+
+			// Decide which level every texture would like to have if memory were free
+			uint64 wantedBytes = 0;
+			for (auto& [id, streamedTexture] : m_Textures)
+			{
+				if (streamedTexture.LastUsedFrame == m_Frame)
+				{
+					streamedTexture.NeededLevel = LevelForScreenSize(streamedTexture);
+
+					// Zooming out does not drop levels right away, that only happens when memory runs low or the texture goes unused
+					streamedTexture.WantedLevel = glm::min(streamedTexture.NeededLevel, streamedTexture.ResidentLevel);
+				}
+				else if (m_Frame - streamedTexture.LastUsedFrame > UNUSED_FRAMES)
+				{
+					streamedTexture.NeededLevel = streamedTexture.TailLevel;
+					streamedTexture.WantedLevel = streamedTexture.TailLevel;
+				}
+				else
+				{
+					streamedTexture.WantedLevel = streamedTexture.ResidentLevel;
+				}
+
+				streamedTexture.MaxScreenSize = glm::vec2(0.0f);
+				wantedBytes += ResidentBytes(streamedTexture, streamedTexture.WantedLevel);
+			}
+
+			// Give up fine mips until everything fits inside the budget
+			while (wantedBytes > budget)
+			{
+				StreamedTexture* candidate = FindEvictionCandidate();
+				if (!candidate)
+				{
+					break;
+				}
+
+				wantedBytes -= ResidentBytes(*candidate, candidate->WantedLevel);
+				candidate->WantedLevel++;
+				wantedBytes += ResidentBytes(*candidate, candidate->WantedLevel);
+			}
+
+			// Dropping levels frees memory so it always happens, uploading finer levels is spread across frames
+			std::vector<StreamedTexture*> uploads;
+			for (auto& [id, streamedTexture] : m_Textures)
+			{
+				if (streamedTexture.WantedLevel > streamedTexture.ResidentLevel)
+				{
+					MakeResident(streamedTexture, streamedTexture.WantedLevel);
+				}
+				else if (streamedTexture.WantedLevel < streamedTexture.ResidentLevel)
+				{
+					uploads.push_back(&streamedTexture);
+				}
+			}
+
+			std::sort(uploads.begin(), uploads.end(), [](const StreamedTexture* a, const StreamedTexture* b)
+				{
+					return (a->ResidentLevel - a->WantedLevel) > (b->ResidentLevel - b->WantedLevel);
+				});
+			for (int i = 0; i < (int)uploads.size() && i < maxUploads; i++)
+			{
+				MakeResident(*uploads[i], uploads[i]->WantedLevel);
+			}
+
+			m_Frame++;
+		}
+
+		bool IsStreamed(Handle<Texture> textureHandle)
+		{
+			return m_Textures.find(textureHandle.m_AssetId) != m_Textures.end();
+		}
+
+		uint64 GetResidentBytes()
+		{
+			return m_ResidentBytes;
+		}
+
+		uint64 GetBudgetBytes()
+		{
+			return (uint64)glm::max(Settings::Graphics::s_TextureMemoryBudgetMb, 0) * 1024 * 1024;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static uint64 ResidentBytes(const StreamedTexture& streamedTexture, int firstLevel)
+		{
+			const CookedTexture& mips = streamedTexture.Mips;
+			return (uint64)TextureCooker::MipOffset(mips.Format, mips.Width, mips.Height, mips.NumMips) -
+				(uint64)TextureCooker::MipOffset(mips.Format, mips.Width, mips.Height, firstLevel);
+		}
+
+		static int LevelForScreenSize(const StreamedTexture& streamedTexture)
+		{
+			const glm::vec2& screenSize = streamedTexture.MaxScreenSize;
+			if (screenSize.x <= 0.0f || screenSize.y <= 0.0f)
+			{
+				return streamedTexture.TailLevel;
+			}
+
+			// The coarsest level that still has at least one texel per pixel in both directions
+			float texelsPerPixel = glm::min(streamedTexture.Mips.Width / screenSize.x, streamedTexture.Mips.Height / screenSize.y);
+			if (texelsPerPixel <= 1.0f)
+			{
+				return 0;
+			}
+
+			int level = (int)glm::floor(glm::log2(texelsPerPixel));
+			return glm::clamp(level, 0, streamedTexture.TailLevel);
+		}
+
+		static void MakeResident(StreamedTexture& streamedTexture, int level)
+		{
+			if (!AssetManager::IsValid(streamedTexture.TextureHandle))
+			{
+				return;
+			}
+			uint32 id = streamedTexture.TextureHandle.Index();
+
+			m_ResidentBytes -= ResidentBytes(streamedTexture, streamedTexture.ResidentLevel);
+			TextureUtil::UploadMips(AssetManager::s_Textures[id], streamedTexture.Mips, level);
+			streamedTexture.ResidentLevel = level;
+			m_ResidentBytes += ResidentBytes(streamedTexture, streamedTexture.ResidentLevel);
+		}
+
+		static StreamedTexture* FindEvictionCandidate()
+		{
+			// Levels finer than what was needed go first, then the least recently drawn texture, then the biggest one
+			StreamedTexture* best = nullptr;
+			for (auto& [id, streamedTexture] : m_Textures)
+			{
+				if (streamedTexture.WantedLevel >= streamedTexture.TailLevel)
+				{
+					continue;
+				}
+
+				if (!best)
+				{
+					best = &streamedTexture;
+					continue;
+				}
+
+				bool isSurplus = streamedTexture.WantedLevel < streamedTexture.NeededLevel;
+				bool bestIsSurplus = best->WantedLevel < best->NeededLevel;
+				if (isSurplus != bestIsSurplus)
+				{
+					if (isSurplus)
+					{
+						best = &streamedTexture;
+					}
+					continue;
+				}
+
+				if (streamedTexture.LastUsedFrame != best->LastUsedFrame)
+				{
+					if (streamedTexture.LastUsedFrame < best->LastUsedFrame)
+					{
+						best = &streamedTexture;
+					}
+					continue;
+				}
+
+				if (ResidentBytes(streamedTexture, streamedTexture.WantedLevel) > ResidentBytes(*best, best->WantedLevel))
+				{
+					best = &streamedTexture;
+				}
+			}
+
+			return best;
+		}
+	}
+}
@@ -0,0 +1,112 @@
+#include "cocoa/scenes/AssetTable.h"
+#include "cocoa/core/AssetManager.h"
+#include "cocoa/components/SpriteRenderer.h"
+#include "cocoa/components/FontRenderer.h"
+#include "cocoa/util/JsonExtended.h"
+
+namespace Cocoa
+{
+	namespace AssetTable
+	{
+		// Forward Declarations
+		static void AddTexture(json& textures, std::unordered_set<uint32>& added, Handle<Texture> textureHandle);
+
+		json Serialize(const Entity* entities, int numEntities)
+		{
+			json textures = json::array();
+			json fonts = json::array();
+			std::unordered_set<uint32> addedTextures;
+			std::unordered_set<uint32> addedFonts;
+			for (int i = 0; i < numEntities; i++)
+			{
+				Entity entity = entities[i];
+				if (NEntity::HasComponent<SpriteRenderer>(entity))
+				{
+					AddTexture(textures, addedTextures, NEntity::GetComponent<SpriteRenderer>(entity).m_Sprite.m_Texture);
+				}
+
+				if (NEntity::HasComponent<FontRenderer>(entity))
+				{
+					Handle<Font> fontHandle = NEntity::GetComponent<FontRenderer>(entity).m_Font;
+					if (AssetManager::IsValid(fontHandle) && !AssetManager::GetFont(fontHandle).IsDefault() &&
+						addedFonts.insert(fontHandle.m_AssetId).second)
+					{
+						const Font& font = AssetManager::GetFont(fontHandle);
+						AddTexture(textures, addedTextures, font.m_FontTexture);
+						json fontJson = font.Serialize();
+						fontJson["ResourceId"] = AssetManager::GetResourceId(fontHandle);
+						fonts.push_back(fontJson);
+					}
+				}
+			}
+
+			return { {"Textures", textures}, {"Fonts", fonts} };
+		}
+
+		void Resolve(const json& table, AssetRemap& remap)
+		{
+			if (table.contains("Textures"))
+			{
+				for (const json& textureJson : table["Textures"])
+				{
+					uint32 resourceId = (uint32)-1;
+					JsonExtended::AssignIfNotNull(textureJson, "ResourceId", resourceId);
+					remap.Textures[resourceId] = AssetManager::ResolveTexture(textureJson);
+				}
+			}
+
+			if (table.contains("Fonts"))
+			{
+				for (const json& fontJson : table["Fonts"])
+				{
+					uint32 resourceId = (uint32)-1;
+					uint32 fontTextureId = (uint32)-1;
+					JsonExtended::AssignIfNotNull(fontJson, "ResourceId", resourceId);
+					JsonExtended::AssignIfNotNull(fontJson, "FontTextureId", fontTextureId);
+					auto textureIter = remap.Textures.find(fontTextureId);
+					Handle<Texture> fontTexture = textureIter != remap.Textures.end() ? textureIter->second : AssetManager::GetTextureHandle(fontTextureId);
+					remap.Fonts[resourceId] = AssetManager::ResolveFont(fontJson, fontTexture);
+				}
+			}
+		}
+
+		void Remap(const json& component, Entity entity, const AssetRemap& remap)
+		{
+			uint32 assetId = (uint32)-1;
+			if (component.contains("SpriteRenderer"))
+			{
+				JsonExtended::AssignIfNotNull(component["SpriteRenderer"], "AssetId", assetId);
+				auto iter = remap.Textures.find(assetId);
+				if (iter != remap.Textures.end())
+				{
+					NEntity::GetComponent<SpriteRenderer>(entity).m_Sprite.m_Texture = iter->second;
+				}
+			}
+			else if (component.contains("FontRenderer"))
+			{
+				JsonExtended::AssignIfNotNull(component["FontRenderer"], "AssetId", assetId);
+				auto iter = remap.Fonts.find(assetId);
+				if (iter != remap.Fonts.end())
+				{
+					NEntity::GetComponent<FontRenderer>(entity).m_Font = iter->second;
+				}
+			}
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static void AddTexture(json& textures, std::unordered_set<uint32>& added, Handle<Texture> textureHandle)
+		{
+			if (!AssetManager::IsValid(textureHandle) || AssetManager::GetTexture(textureHandle).IsDefault ||
+				!added.insert(textureHandle.m_AssetId).second)
+			{
+				return;
+			}
+
+			json textureJson = TextureUtil::Serialize(AssetManager::GetTexture(textureHandle));
+			textureJson["ResourceId"] = AssetManager::GetResourceId(textureHandle);
+			textures.push_back(textureJson);
+		}
+	}
+}
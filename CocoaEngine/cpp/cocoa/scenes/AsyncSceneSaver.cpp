@@ -0,0 +1,180 @@
+#include "externalLibs.h"
+
+#include "cocoa/scenes/AsyncSceneSaver.h"
+#include "cocoa/scenes/BinaryScene.h"
+#include "cocoa/scenes/WorldStreamer.h"
+#include "cocoa/file/File.h"
+#include "cocoa/util/Log.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace Cocoa
+{
+	namespace AsyncSceneSaver
+	{
+		struct SaveJob
+		{
+			SceneSnapshot Snapshot;
+			CPath Filename;
+			SceneSavedFn OnSaved;
+		};
+
+		struct FinishedSave
+		{
+			CPath Filename;
+			SceneSavedFn OnSaved;
+			uint32 Size;
+			bool Success;
+		};
+
+		// Internal Variables
+		static std::thread m_Worker;
+		static std::mutex m_Mutex;
+		static std::condition_variable m_JobAvailable;
+		static std::condition_variable m_JobFinished;
+		static std::deque<SaveJob> m_Jobs;
+		static std::deque<FinishedSave> m_Finished;
+		static int m_NumPending = 0;
+		static bool m_Running = false;
+
+		// Forward Declarations
+		static void WorkerLoop();
+
+		void Init()
+		{
+			Log::Assert(!m_Running, "Tried to initialize the async scene saver twice.");
+			m_Running = true;
+			m_Worker = std::thread(WorkerLoop);
+		}
+
+		void Destroy()
+		{
+			// Unlike texture loads, pending saves are never dropped
+			WaitAll();
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Running = false;
+			}
+			m_JobAvailable.notify_all();
+			m_Worker.join();
+		}
+
+		void Save(SceneData& data, const CPath& filename, SceneSavedFn onSaved)
+		{
+			Log::Assert(m_Running, "Async scene saver must be initialized before saving scenes.");
+			SaveJob job;
+
+			// Cells are written right away, the snapshot only records which index they were written with
+			WorldStreamer::SaveCells(data, filename);
+			BinaryScene::TakeSnapshot(data, job.Snapshot);
+			job.Filename = filename;
+			job.OnSaved = onSaved;
+
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				auto queued = std::find_if(m_Jobs.begin(), m_Jobs.end(), [&filename](const SaveJob& other)
+				{
+					return other.Filename == filename;
+				});
+
+				if (queued != m_Jobs.end())
+				{
+					// The older snapshot would be overwritten straight away, so only the newest one is written
+					*queued = std::move(job);
+				}
+				else
+				{
+					m_Jobs.push_back(std::move(job));
+					m_NumPending++;
+				}
+			}
+			m_JobAvailable.notify_one();
+		}
+
+		void Update()
+		{
+			while (true)
+			{
+				FinishedSave finished;
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					if (m_Finished.empty())
+					{
+						break;
+					}
+
+					finished = m_Finished.front();
+					m_Finished.pop_front();
+					m_NumPending--;
+				}
+
+				if (finished.Success)
+				{
+					Log::Info("Saved scene %s (%d bytes)", finished.Filename.Path.c_str(), finished.Size);
+				}
+				else
+				{
+					Log::Warning("Failed to save scene %s", finished.Filename.Path.c_str());
+				}
+
+				if (finished.OnSaved)
+				{
+					finished.OnSaved(finished.Filename, finished.Success);
+				}
+			}
+		}
+
+		void WaitAll()
+		{
+			while (IsSaving())
+			{
+				{
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					m_JobFinished.wait(lock, [] { return !m_Finished.empty() || m_NumPending == 0; });
+				}
+				Update();
+			}
+		}
+
+		bool IsSaving()
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			return m_NumPending > 0;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static void WorkerLoop()
+		{
+			std::vector<uint8> output;
+			while (true)
+			{
+				SaveJob job;
+				{
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					m_JobAvailable.wait(lock, [] { return !m_Jobs.empty() || !m_Running; });
+					if (!m_Running && m_Jobs.empty())
+					{
+						return;
+					}
+
+					job = std::move(m_Jobs.front());
+					m_Jobs.pop_front();
+				}
+
+				BinaryScene::Encode(job.Snapshot, output);
+				bool success = File::WriteFileAtomic(output.data(), (uint32)output.size(), job.Filename);
+
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					m_Finished.push_back({ job.Filename, job.OnSaved, (uint32)output.size(), success });
+				}
+				m_JobFinished.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,613 @@
+#include "cocoa/scenes/BinaryScene.h"
+#include "cocoa/core/Entity.h"
+#include "cocoa/core/AssetManager.h"
+#include "cocoa/scenes/WorldStreamer.h"
+#include "cocoa/components/Transform.h"
+#include "cocoa/components/SpriteRenderer.h"
+#include "cocoa/components/FontRenderer.h"
+#include "cocoa/physics2d/PhysicsComponents.h"
+#include "cocoa/systems/ScriptSystem.h"
+#include "cocoa/util/Settings.h"
+#include "cocoa/util/Log.h"
+
+namespace Cocoa
+{
+	namespace BinaryScene
+	{
+		enum class ChunkType : uint32
+		{
+			Project = 1,
+			Assets = 2,
+			Entities = 3,
+			Transform = 4,
+			SpriteRenderer = 5,
+			FontRenderer = 6,
+			Rigidbody2D = 7,
+			Box2D = 8,
+			AABB = 9,
+			Scripts = 10,
+			CollisionFilter2D = 11,
+			WorldCells = 12
+		};
+
+		struct SceneFileHeader
+		{
+			uint32 Magic;
+			uint32 Version;
+			uint32 NumChunks;
+			uint32 Reserved;
+		};
+
+		// A chunk's payload is Count entity ids, then Count records of RecordSize bytes, then any variable sized data the
+		// records point into
+		struct ChunkHeader
+		{
+			ChunkType Type;
+			uint32 Version;
+			uint32 Count;
+			uint32 RecordSize;
+			uint64 Size;
+		};
+
+		struct Chunk
+		{
+			ChunkHeader Header;
+			const uint8* Payload;
+		};
+
+		// Records only hold 4 byte fields so their layout is the same for every compiler
+		struct TransformRecord
+		{
+			glm::vec3 Position;
+			glm::vec3 Scale;
+			glm::vec3 EulerRotation;
+		};
+
+		struct SpriteRendererRecord
+		{
+			glm::vec4 Color;
+			int32 ZIndex;
+			uint32 TextureId;
+		};
+
+		struct FontRendererRecord
+		{
+			glm::vec4 Color;
+			int32 ZIndex;
+			uint32 FontId;
+			int32 FontSize;
+			uint32 Cached;
+			uint32 TextOffset;
+			uint32 TextLength;
+		};
+
+		struct Rigidbody2DRecord
+		{
+			glm::vec2 Velocity;
+			float AngularDamping;
+			float LinearDamping;
+			float Mass;
+			uint32 BodyType;
+			uint32 FixedRotation;
+			uint32 ContinuousCollision;
+		};
+
+		struct BoxRecord
+		{
+			glm::vec2 HalfSize;
+			glm::vec2 Offset;
+		};
+
+		struct CollisionFilterRecord
+		{
+			uint32 Category;
+			uint32 Mask;
+		};
+
+		// Internal Variables
+		static const uint32 SCENE_MAGIC = 0x4E435343; // "CSCN"
+		static const uint32 SCENE_VERSION = 1;
+		static const uint32 CHUNK_VERSION = 1;
+
+		// Forward Declarations
+		static void Append(std::vector<uint8>& output, const void* data, size_t size);
+		static size_t BeginChunk(std::vector<uint8>& output, ChunkType type, uint32 count, uint32 recordSize);
+		static void EndChunk(std::vector<uint8>& output, size_t chunkStart, uint32& numChunks);
+		static void WriteCborChunk(std::vector<uint8>& output, uint32& numChunks, ChunkType type, const json& j);
+		template<typename Component, typename Record, typename ToRecord>
+		static void WriteComponentChunk(SceneData& data, std::vector<uint8>& output, uint32& numChunks, ChunkType type, ToRecord toRecord);
+		static bool ReadChunks(const uint8* input, uint32 size, std::vector<Chunk>& chunks);
+		static const Chunk* FindChunk(const std::vector<Chunk>& chunks, ChunkType type);
+		static bool ReadCborChunk(const Chunk* chunk, json& result);
+		template<typename Component, typename Record, typename FromRecord>
+		static bool ReadComponentChunk(SceneData& data, const Chunk* chunk, FromRecord fromRecord);
+		static bool ReadEntities(SceneData& data, const Chunk* chunk);
+		static bool ReadScripts(SceneData& data, const Chunk* chunk);
+		static entt::entity FindOrCreateEntity(SceneData& data, uint32 id);
+
+		bool IsBinary(const uint8* data, uint32 size)
+		{
+			uint32 magic = 0;
+			if (size >= sizeof(SceneFileHeader))
+			{
+				memcpy(&magic, data, sizeof(uint32));
+			}
+			return magic == SCENE_MAGIC;
+		}
+
+		void Serialize(SceneData& data, std::vector<uint8>& output)
+		{
+			SceneSnapshot snapshot;
+			TakeSnapshot(data, snapshot);
+			Encode(snapshot, output);
+		}
+
+		void TakeSnapshot(SceneData& data, SceneSnapshot& snapshot)
+		{
+			snapshot.Project = Settings::General::s_CurrentProject.Path;
+			snapshot.Assets = AssetManager::Serialize();
+			snapshot.Chunks.clear();
+			snapshot.NumChunks = 0;
+			std::vector<uint8>& output = snapshot.Chunks;
+			uint32& numChunks = snapshot.NumChunks;
+
+			std::vector<uint32> entities;
+			entities.reserve(data.Registry.size());
+			data.Registry.each([&entities](entt::entity entity)
+			{
+				if (!WorldStreamer::OwnsEntity(entity))
+				{
+					entities.push_back(entt::to_integral(entity));
+				}
+			});
+			size_t entitiesChunk = BeginChunk(output, ChunkType::Entities, (uint32)entities.size(), 0);
+			Append(output, entities.data(), entities.size() * sizeof(uint32));
+			EndChunk(output, entitiesChunk, numChunks);
+
+			WriteComponentChunk<TransformData, TransformRecord>(data, output, numChunks, ChunkType::Transform,
+				[](const TransformData& transform, std::string& strings)
+			{
+				return TransformRecord{ transform.Position, transform.Scale, transform.EulerRotation };
+			});
+
+			WriteComponentChunk<SpriteRenderer, SpriteRendererRecord>(data, output, numChunks, ChunkType::SpriteRenderer,
+				[](const SpriteRenderer& spriteRenderer, std::string& strings)
+			{
+				return SpriteRendererRecord{ spriteRenderer.m_Color, spriteRenderer.m_ZIndex, AssetManager::GetResourceId(spriteRenderer.m_Sprite.m_Texture) };
+			});
+
+			WriteComponentChunk<FontRenderer, FontRendererRecord>(data, output, numChunks, ChunkType::FontRenderer,
+				[](const FontRenderer& fontRenderer, std::string& strings)
+			{
+				FontRendererRecord record;
+				record.Color = fontRenderer.m_Color;
+				record.ZIndex = fontRenderer.m_ZIndex;
+				record.FontId = AssetManager::GetResourceId(fontRenderer.m_Font);
+				record.FontSize = fontRenderer.fontSize;
+				record.Cached = fontRenderer.m_Cached ? 1 : 0;
+				record.TextOffset = (uint32)strings.size();
+				record.TextLength = (uint32)fontRenderer.text.size();
+				strings += fontRenderer.text;
+				return record;
+			});
+
+			WriteComponentChunk<Rigidbody2D, Rigidbody2DRecord>(data, output, numChunks, ChunkType::Rigidbody2D,
+				[](const Rigidbody2D& rb, std::string& strings)
+			{
+				return Rigidbody2DRecord{ rb.m_Velocity, rb.m_AngularDamping, rb.m_LinearDamping, rb.m_Mass, (uint32)rb.m_BodyType,
+					rb.m_FixedRotation ? 1u : 0u, rb.m_ContinuousCollision ? 1u : 0u };
+			});
+
+			WriteComponentChunk<Box2D, BoxRecord>(data, output, numChunks, ChunkType::Box2D,
+				[](const Box2D& box, std::string& strings)
+			{
+				return BoxRecord{ box.m_HalfSize, box.m_Offset };
+			});
+
+			WriteComponentChunk<AABB, BoxRecord>(data, output, numChunks, ChunkType::AABB,
+				[](const AABB& box, std::string& strings)
+			{
+				return BoxRecord{ box.m_HalfSize, box.m_Offset };
+			});
+
+			WriteComponentChunk<CollisionFilter2D, CollisionFilterRecord>(data, output, numChunks, ChunkType::CollisionFilter2D,
+				[](const CollisionFilter2D& filter, std::string& strings)
+			{
+				return CollisionFilterRecord{ filter.m_Category, filter.m_Mask };
+			});
+
+			// Script components are only known to the script library, which saves them as json
+			json scripts = { {"Components", json::array()} };
+			ScriptSystem::SaveScripts(scripts);
+			snapshot.Scripts = std::move(scripts["Components"]);
+			snapshot.WorldCellsHash = WorldStreamer::IsOpen() ? WorldStreamer::GetIndexHash() : 0;
+		}
+
+		void Encode(const SceneSnapshot& snapshot, std::vector<uint8>& output)
+		{
+			SceneFileHeader header;
+			header.Magic = SCENE_MAGIC;
+			header.Version = SCENE_VERSION;
+			header.NumChunks = 0;
+			header.Reserved = 0;
+			output.clear();
+			output.reserve(sizeof(SceneFileHeader) + snapshot.Chunks.size());
+			Append(output, &header, sizeof(SceneFileHeader));
+
+			uint32 numChunks = 0;
+			size_t projectChunk = BeginChunk(output, ChunkType::Project, 0, 0);
+			Append(output, snapshot.Project.data(), snapshot.Project.size());
+			EndChunk(output, projectChunk, numChunks);
+
+			WriteCborChunk(output, numChunks, ChunkType::Assets, snapshot.Assets);
+
+			// Entity and component chunks were already laid out when the snapshot was taken
+			Append(output, snapshot.Chunks.data(), snapshot.Chunks.size());
+			numChunks += snapshot.NumChunks;
+
+			WriteCborChunk(output, numChunks, ChunkType::Scripts, snapshot.Scripts);
+			if (snapshot.WorldCellsHash != 0)
+			{
+				WriteCborChunk(output, numChunks, ChunkType::WorldCells, { {"IndexHash", snapshot.WorldCellsHash} });
+			}
+			memcpy(output.data() + offsetof(SceneFileHeader, NumChunks), &numChunks, sizeof(uint32));
+		}
+
+		bool Deserialize(SceneData& data, const uint8* input, uint32 size)
+		{
+			std::vector<Chunk> chunks;
+			if (!ReadChunks(input, size, chunks))
+			{
+				return false;
+			}
+
+			// Component chunks refer to assets by their id in the scene file, so assets have to go in first
+			json assets;
+			if (ReadCborChunk(FindChunk(chunks, ChunkType::Assets), assets))
+			{
+				AssetManager::LoadTexturesFrom(assets);
+				AssetManager::LoadFontsFrom(assets);
+			}
+			AssetManager::EvictUnreferenced();
+
+			bool success = ReadEntities(data, FindChunk(chunks, ChunkType::Entities));
+
+			success = ReadComponentChunk<TransformData, TransformRecord>(data, FindChunk(chunks, ChunkType::Transform),
+				[](const TransformRecord& record, const char* strings, uint64 stringsSize, TransformData& transform)
+			{
+				transform = Transform::CreateTransform(record.Position, record.Scale, record.EulerRotation);
+				return true;
+			}) && success;
+
+			success = ReadComponentChunk<SpriteRenderer, SpriteRendererRecord>(data, FindChunk(chunks, ChunkType::SpriteRenderer),
+				[](const SpriteRendererRecord& record, const char* strings, uint64 stringsSize, SpriteRenderer& spriteRenderer)
+			{
+				spriteRenderer.m_Color = record.Color;
+				spriteRenderer.m_ZIndex = record.ZIndex;
+				if (record.TextureId != std::numeric_limits<uint32>::max())
+				{
+					spriteRenderer.m_Sprite.m_Texture = AssetManager::GetSceneTexture(record.TextureId);
+				}
+				return true;
+			}) && success;
+
+			success = ReadComponentChunk<FontRenderer, FontRendererRecord>(data, FindChunk(chunks, ChunkType::FontRenderer),
+				[](const FontRendererRecord& record, const char* strings, uint64 stringsSize, FontRenderer& fontRenderer)
+			{
+				if ((uint64)record.TextOffset + record.TextLength > stringsSize)
+				{
+					return false;
+				}
+
+				fontRenderer.m_Color = record.Color;
+				fontRenderer.m_ZIndex = record.ZIndex;
+				if (record.FontId != std::numeric_limits<uint32>::max())
+				{
+					fontRenderer.m_Font = AssetManager::GetSceneFont(record.FontId);
+				}
+				fontRenderer.fontSize = record.FontSize;
+				fontRenderer.m_Cached = record.Cached != 0;
+				fontRenderer.text.assign(strings + record.TextOffset, record.TextLength);
+				return true;
+			}) && success;
+
+			success = ReadComponentChunk<Rigidbody2D, Rigidbody2DRecord>(data, FindChunk(chunks, ChunkType::Rigidbody2D),
+				[](const Rigidbody2DRecord& record, const char* strings, uint64 stringsSize, Rigidbody2D& rb)
+			{
+				rb.m_Velocity = record.Velocity;
+				rb.m_AngularDamping = record.AngularDamping;
+				rb.m_LinearDamping = record.LinearDamping;
+				rb.m_Mass = record.Mass;
+				rb.m_BodyType = (BodyType2D)record.BodyType;
+				rb.m_FixedRotation = record.FixedRotation != 0;
+				rb.m_ContinuousCollision = record.ContinuousCollision != 0;
+				return true;
+			}) && success;
+
+			success = ReadComponentChunk<Box2D, BoxRecord>(data, FindChunk(chunks, ChunkType::Box2D),
+				[](const BoxRecord& record, const char* strings, uint64 stringsSize, Box2D& box)
+			{
+				box.m_HalfSize = record.HalfSize;
+				box.m_Size = record.HalfSize * 2.0f;
+				box.m_Offset = record.Offset;
+				return true;
+			}) && success;
+
+			success = ReadComponentChunk<AABB, BoxRecord>(data, FindChunk(chunks, ChunkType::AABB),
+				[](const BoxRecord& record, const char* strings, uint64 stringsSize, AABB& box)
+			{
+				box.m_HalfSize = record.HalfSize;
+				box.m_Size = record.HalfSize * 2.0f;
+				box.m_Offset = record.Offset;
+				return true;
+			}) && success;
+
+			success = ReadComponentChunk<CollisionFilter2D, CollisionFilterRecord>(data, FindChunk(chunks, ChunkType::CollisionFilter2D),
+				[](const CollisionFilterRecord& record, const char* strings, uint64 stringsSize, CollisionFilter2D& filter)
+			{
+				filter.m_Category = (uint16)record.Category;
+				filter.m_Mask = (uint16)record.Mask;
+				return true;
+			}) && success;
+
+			return ReadScripts(data, FindChunk(chunks, ChunkType::Scripts)) && success;
+		}
+
+		uint64 GetWorldCellsHash(const uint8* input, uint32 size)
+		{
+			std::vector<Chunk> chunks;
+			json worldCells;
+			if (!ReadChunks(input, size, chunks) || !ReadCborChunk(FindChunk(chunks, ChunkType::WorldCells), worldCells))
+			{
+				return 0;
+			}
+
+			return worldCells.value("IndexHash", (uint64)0);
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static void Append(std::vector<uint8>& output, const void* data, size_t size)
+		{
+			if (size > 0)
+			{
+				const uint8* bytes = (const uint8*)data;
+				output.insert(output.end(), bytes, bytes + size);
+			}
+		}
+
+		static size_t BeginChunk(std::vector<uint8>& output, ChunkType type, uint32 count, uint32 recordSize)
+		{
+			ChunkHeader header;
+			header.Type = type;
+			header.Version = CHUNK_VERSION;
+			header.Count = count;
+			header.RecordSize = recordSize;
+			header.Size = 0;
+
+			size_t chunkStart = output.size();
+			Append(output, &header, sizeof(ChunkHeader));
+			return chunkStart;
+		}
+
+		static void EndChunk(std::vector<uint8>& output, size_t chunkStart, uint32& numChunks)
+		{
+			uint64 payloadSize = output.size() - chunkStart - sizeof(ChunkHeader);
+			memcpy(output.data() + chunkStart + offsetof(ChunkHeader, Size), &payloadSize, sizeof(uint64));
+			numChunks++;
+		}
+
+		static void WriteCborChunk(std::vector<uint8>& output, uint32& numChunks, ChunkType type, const json& j)
+		{
+			std::vector<uint8> cbor = json::to_cbor(j);
+			size_t chunkStart = BeginChunk(output, type, 0, 0);
+			Append(output, cbor.data(), cbor.size());
+			EndChunk(output, chunkStart, numChunks);
+		}
+
+		template<typename Component, typename Record, typename ToRecord>
+		static void WriteComponentChunk(SceneData& data, std::vector<uint8>& output, uint32& numChunks, ChunkType type, ToRecord toRecord)
+		{
+			auto view = data.Registry.view<Component>();
+			std::vector<uint32> entities;
+			std::vector<Record> records;
+			std::string strings;
+			entities.reserve(view.size());
+			records.reserve(view.size());
+			for (entt::entity entity : view)
+			{
+				if (WorldStreamer::OwnsEntity(entity))
+				{
+					continue;
+				}
+
+				entities.push_back(entt::to_integral(entity));
+				records.push_back(toRecord(data.Registry.get<Component>(entity), strings));
+			}
+
+			size_t chunkStart = BeginChunk(output, type, (uint32)entities.size(), sizeof(Record));
+			Append(output, entities.data(), entities.size() * sizeof(uint32));
+			Append(output, records.data(), records.size() * sizeof(Record));
+			Append(output, strings.data(), strings.size());
+			EndChunk(output, chunkStart, numChunks);
+		}
+
+		static bool ReadChunks(const uint8* input, uint32 size, std::vector<Chunk>& chunks)
+		{
+			SceneFileHeader header;
+			if (!IsBinary(input, size))
+			{
+				return false;
+			}
+
+			memcpy(&header, input, sizeof(SceneFileHeader));
+			if (header.Version > SCENE_VERSION)
+			{
+				Log::Warning("Scene was saved with a newer version of the engine (%d).", header.Version);
+				return false;
+			}
+
+			uint64 offset = sizeof(SceneFileHeader);
+			for (uint32 i = 0; i < header.NumChunks; i++)
+			{
+				Chunk chunk;
+				if (offset + sizeof(ChunkHeader) > size)
+				{
+					Log::Warning("Scene file is truncated.");
+					return false;
+				}
+
+				memcpy(&chunk.Header, input + offset, sizeof(ChunkHeader));
+				offset += sizeof(ChunkHeader);
+				if (chunk.Header.Size > size - offset)
+				{
+					Log::Warning("Scene file is truncated.");
+					return false;
+				}
+
+				chunk.Payload = input + offset;
+				offset += chunk.Header.Size;
+
+				// Chunks from newer versions of the engine are skipped instead of misread
+				if (chunk.Header.Version != CHUNK_VERSION)
+				{
+					Log::Warning("Skipping scene chunk %d with unknown version %d.", (int)chunk.Header.Type, chunk.Header.Version);
+					continue;
+				}
+				chunks.push_back(chunk);
+			}
+
+			return true;
+		}
+
+		static const Chunk* FindChunk(const std::vector<Chunk>& chunks, ChunkType type)
+		{
+			for (const Chunk& chunk : chunks)
+			{
+				if (chunk.Header.Type == type)
+				{
+					return &chunk;
+				}
+			}
+
+			return nullptr;
+		}
+
+		static bool ReadCborChunk(const Chunk* chunk, json& result)
+		{
+			if (!chunk)
+			{
+				return false;
+			}
+
+			result = json::from_cbor(chunk->Payload, chunk->Payload + chunk->Header.Size, true, false);
+			if (result.is_discarded())
+			{
+				Log::Warning("Scene chunk %d is corrupt.", (int)chunk->Header.Type);
+				result = {};
+				return false;
+			}
+
+			return true;
+		}
+
+		template<typename Component, typename Record, typename FromRecord>
+		static bool ReadComponentChunk(SceneData& data, const Chunk* chunk, FromRecord fromRecord)
+		{
+			if (!chunk)
+			{
+				return true;
+			}
+
+			const ChunkHeader& header = chunk->Header;
+			uint64 columnsSize = (uint64)header.Count * (sizeof(uint32) + sizeof(Record));
+			if (header.RecordSize != sizeof(Record) || header.Size < columnsSize)
+			{
+				Log::Warning("Scene chunk %d is corrupt.", (int)header.Type);
+				return false;
+			}
+
+			const uint8* entityColumn = chunk->Payload;
+			const uint8* recordColumn = chunk->Payload + (uint64)header.Count * sizeof(uint32);
+			const char* strings = (const char*)(chunk->Payload + columnsSize);
+			uint64 stringsSize = header.Size - columnsSize;
+
+			std::vector<entt::entity> entities(header.Count);
+			std::vector<Component> components(header.Count);
+			for (uint32 i = 0; i < header.Count; i++)
+			{
+				uint32 id;
+				memcpy(&id, entityColumn + (uint64)i * sizeof(uint32), sizeof(uint32));
+				entities[i] = FindOrCreateEntity(data, id);
+
+				Record record;
+				memcpy(&record, recordColumn + (uint64)i * sizeof(Record), sizeof(Record));
+				if (!fromRecord(record, strings, stringsSize, components[i]))
+				{
+					Log::Warning("Scene chunk %d is corrupt.", (int)header.Type);
+					return false;
+				}
+			}
+
+			data.Registry.insert<Component>(entities.begin(), entities.end(), components.begin(), components.end());
+			return true;
+		}
+
+		static bool ReadEntities(SceneData& data, const Chunk* chunk)
+		{
+			if (!chunk)
+			{
+				return true;
+			}
+
+			if (chunk->Header.Size != (uint64)chunk->Header.Count * sizeof(uint32))
+			{
+				Log::Warning("Scene chunk %d is corrupt.", (int)chunk->Header.Type);
+				return false;
+			}
+
+			for (uint32 i = 0; i < chunk->Header.Count; i++)
+			{
+				uint32 id;
+				memcpy(&id, chunk->Payload + (uint64)i * sizeof(uint32), sizeof(uint32));
+				FindOrCreateEntity(data, id);
+			}
+
+			return true;
+		}
+
+		static bool ReadScripts(SceneData& data, const Chunk* chunk)
+		{
+			json scripts;
+			if (!chunk)
+			{
+				return true;
+			}
+
+			if (!ReadCborChunk(chunk, scripts))
+			{
+				return false;
+			}
+
+			for (json& component : scripts)
+			{
+				Entity entity = Entity{ FindOrCreateEntity(data, component.front()["Entity"]), &data };
+				ScriptSystem::Deserialize(component, entity);
+			}
+
+			return true;
+		}
+
+		static entt::entity FindOrCreateEntity(SceneData& data, uint32 id)
+		{
+			entt::entity entity = entt::entity(id);
+			if (data.Registry.valid(entity))
+			{
+				return entity;
+			}
+
+			return data.Registry.create(entity);
+		}
+	}
+}
@@ -0,0 +1,226 @@
+#include "cocoa/scenes/ComponentSerializer.h"
+#include "cocoa/components/Transform.h"
+#include "cocoa/systems/RenderSystem.h"
+#include "cocoa/systems/ScriptSystem.h"
+#include "cocoa/physics2d/Physics2D.h"
+#include "cocoa/util/Log.h"
+
+namespace Cocoa
+{
+	namespace ComponentSerializer
+	{
+		// Internal Variables
+		static std::vector<ComponentSerializerEntry> m_Entries;
+		static std::unordered_map<entt::id_type, uint32> m_TypeIdToEntry;
+		static std::unordered_map<entt::id_type, uint32> m_NameHashToEntry;
+		static bool m_Initialized = false;
+
+		// Forward Declarations
+		static entt::id_type HashName(const std::string& name);
+		static void RebuildLookups();
+		static void CopyRigidbody2D(Entity from, Entity to);
+		static Entity FindOrCreateEntity(uint32 id, SceneData& scene);
+		static void CopyScripts(Entity from, Entity to);
+
+		void Init()
+		{
+			if (m_Initialized)
+			{
+				return;
+			}
+			m_Initialized = true;
+
+			Register<TransformData, Transform::Serialize, Transform::Deserialize>("Transform");
+			Register<SpriteRenderer, RenderSystem::Serialize, RenderSystem::DeserializeSpriteRenderer>("SpriteRenderer");
+			Register<FontRenderer, RenderSystem::Serialize, RenderSystem::DeserializeFontRenderer>("FontRenderer");
+			Register<Rigidbody2D, Physics2D::Serialize, Physics2D::DeserializeRigidbody2D>("Rigidbody2D");
+			Register<Box2D, Physics2D::Serialize, Physics2D::DeserializeBox2D>("Box2D");
+			Register<AABB, Physics2D::Serialize, Physics2D::DeserializeAABB>("AABB");
+			Register<CollisionFilter2D, Physics2D::Serialize, Physics2D::DeserializeCollisionFilter2D>("CollisionFilter2D");
+
+			m_Entries[m_TypeIdToEntry[entt::type_info<Rigidbody2D>().id()]].Copy = CopyRigidbody2D;
+		}
+
+		void Register(ComponentSerializerEntry entry)
+		{
+			entry.NameHash = HashName(entry.Name);
+			const ComponentSerializerEntry* existing = Find(entry.Name);
+			if (existing)
+			{
+				Log::Warning("Component '%s' is already registered.", entry.Name.c_str());
+				return;
+			}
+
+			uint32 index = (uint32)m_Entries.size();
+			m_Entries.push_back(entry);
+			m_NameHashToEntry[entry.NameHash] = index;
+			if (!entry.IsScript)
+			{
+				m_TypeIdToEntry[entry.TypeId] = index;
+			}
+		}
+
+		void RegisterScript(const char* name)
+		{
+			ComponentSerializerEntry entry;
+			entry.Name = name;
+			entry.TypeId = 0;
+			entry.IsScript = true;
+			entry.SerializeAll = nullptr;
+			entry.Deserialize = ScriptSystem::Deserialize;
+			entry.Copy = nullptr;
+			entry.Snapshot = nullptr;
+			entry.Restore = nullptr;
+			entry.CopyOut = nullptr;
+			entry.InsertRange = nullptr;
+			Register(entry);
+		}
+
+		void UnregisterScripts()
+		{
+			m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(), [](const ComponentSerializerEntry& entry)
+			{
+				return entry.IsScript;
+			}), m_Entries.end());
+			RebuildLookups();
+		}
+
+		const ComponentSerializerEntry* Find(entt::id_type typeId)
+		{
+			auto iter = m_TypeIdToEntry.find(typeId);
+			return iter != m_TypeIdToEntry.end() ? &m_Entries[iter->second] : nullptr;
+		}
+
+		const ComponentSerializerEntry* Find(const std::string& name)
+		{
+			auto iter = m_NameHashToEntry.find(HashName(name));
+			if (iter == m_NameHashToEntry.end() || m_Entries[iter->second].Name != name)
+			{
+				return nullptr;
+			}
+
+			return &m_Entries[iter->second];
+		}
+
+		const std::vector<ComponentSerializerEntry>& GetEntries()
+		{
+			return m_Entries;
+		}
+
+		void Serialize(json& j, SceneData& scene)
+		{
+			for (const ComponentSerializerEntry& entry : m_Entries)
+			{
+				if (entry.SerializeAll)
+				{
+					entry.SerializeAll(j, scene);
+				}
+			}
+
+			// Script components are saved by the script library in one go
+			ScriptSystem::SaveScripts(j);
+		}
+
+		void Deserialize(json& component, SceneData& scene)
+		{
+			json::iterator it = component.begin();
+			if (it == component.end() || !it.value().contains("Entity"))
+			{
+				Log::Warning("Cannot deserialize component without an entity.");
+				return;
+			}
+
+			Entity entity = FindOrCreateEntity(it.value()["Entity"], scene);
+			const ComponentSerializerEntry* entry = Find(it.key());
+			if (entry && entry->Deserialize)
+			{
+				entry->Deserialize(component, entity);
+			}
+			else
+			{
+				ScriptSystem::Deserialize(component, entity);
+			}
+		}
+
+		void CopyComponents(Entity from, Entity to)
+		{
+			bool hasScripts = false;
+			for (const ComponentSerializerEntry& entry : m_Entries)
+			{
+				if (entry.Copy)
+				{
+					entry.Copy(from, to);
+				}
+				hasScripts = hasScripts || entry.IsScript;
+			}
+
+			// Script entries have no Copy of their own, the script library copies all of an entity's scripts at once
+			if (hasScripts && from.Scene == to.Scene)
+			{
+				CopyScripts(from, to);
+			}
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static void CopyRigidbody2D(Entity from, Entity to)
+		{
+			if (NEntity::HasComponent<Rigidbody2D>(from))
+			{
+				// The copy gets a body of its own, it must not start out pointing at the source entity's
+				Rigidbody2D rb = NEntity::GetComponent<Rigidbody2D>(from);
+				rb.m_RawRigidbody = nullptr;
+				to.Scene->Registry.emplace_or_replace<Rigidbody2D>(to.Handle, rb);
+			}
+		}
+
+		static entt::id_type HashName(const std::string& name)
+		{
+			return entt::hashed_string::value(name.c_str(), name.size());
+		}
+
+		static void RebuildLookups()
+		{
+			m_TypeIdToEntry.clear();
+			m_NameHashToEntry.clear();
+			for (uint32 i = 0; i < (uint32)m_Entries.size(); i++)
+			{
+				m_NameHashToEntry[m_Entries[i].NameHash] = i;
+				if (!m_Entries[i].IsScript)
+				{
+					m_TypeIdToEntry[m_Entries[i].TypeId] = i;
+				}
+			}
+		}
+
+		static void CopyScripts(Entity from, Entity to)
+		{
+			// The script library only saves every script component at once, so the source entity's are picked out and
+			// loaded back onto the copy, the same way registry snapshots restore them
+			json scripts = { {"Components", json::array()} };
+			ScriptSystem::SaveScripts(scripts);
+
+			uint32 fromId = NEntity::GetID(from);
+			for (json& component : scripts["Components"])
+			{
+				if (component.front()["Entity"] == fromId)
+				{
+					component.front()["Entity"] = NEntity::GetID(to);
+					ScriptSystem::Deserialize(component, to);
+				}
+			}
+		}
+
+		static Entity FindOrCreateEntity(uint32 id, SceneData& scene)
+		{
+			entt::entity entity = entt::entity(id);
+			if (!scene.Registry.valid(entity))
+			{
+				entity = scene.Registry.create(entity);
+			}
+
+			return Entity{ entity, &scene };
+		}
+	}
+}
@@ -0,0 +1,459 @@
+#include "cocoa/scenes/JsonSceneReader.h"
+#include "cocoa/core/Entity.h"
+#include "cocoa/core/AssetManager.h"
+#include "cocoa/components/Transform.h"
+#include "cocoa/components/SpriteRenderer.h"
+#include "cocoa/components/FontRenderer.h"
+#include "cocoa/physics2d/PhysicsComponents.h"
+#include "cocoa/systems/ScriptSystem.h"
+#include "cocoa/scenes/ComponentSerializer.h"
+#include "cocoa/util/Log.h"
+
+#include <nlohmann/json.hpp>
+
+namespace Cocoa
+{
+	namespace JsonSceneReader
+	{
+		enum class ComponentType : uint8
+		{
+			None,
+			Transform,
+			SpriteRenderer,
+			FontRenderer,
+			Rigidbody2D,
+			Box2D,
+			AABB,
+			Script,
+		};
+
+		// Nesting depth of each part of a scene file, {"Components": [{"Transform": {"Position": {"X": 0}}}]}
+		enum SceneDepth
+		{
+			ROOT_DEPTH = 1,
+			COMPONENTS_DEPTH = 2,
+			COMPONENT_DEPTH = 3,
+			FIELD_DEPTH = 4,
+			AXIS_DEPTH = 5,
+		};
+
+		class SceneSaxHandler : public nlohmann::json_sax<json>
+		{
+		public:
+			SceneSaxHandler(SceneData& scene)
+				: m_Scene(scene) {}
+
+			bool null() override
+			{
+				if (IsCapturing())
+				{
+					CaptureValue(nullptr);
+				}
+				return true;
+			}
+
+			bool boolean(bool val) override
+			{
+				if (IsCapturing())
+				{
+					CaptureValue(val);
+					return true;
+				}
+
+				return SetNumber(val ? 1.0 : 0.0);
+			}
+
+			bool number_integer(number_integer_t val) override
+			{
+				if (IsCapturing())
+				{
+					CaptureValue(val);
+					return true;
+				}
+
+				return SetNumber((double)val);
+			}
+
+			bool number_unsigned(number_unsigned_t val) override
+			{
+				if (IsCapturing())
+				{
+					CaptureValue(val);
+					return true;
+				}
+
+				return SetNumber((double)val);
+			}
+
+			bool number_float(number_float_t val, const string_t& s) override
+			{
+				if (IsCapturing())
+				{
+					CaptureValue(val);
+					return true;
+				}
+
+				return SetNumber(val);
+			}
+
+			bool string(string_t& val) override
+			{
+				if (IsCapturing())
+				{
+					CaptureValue(std::move(val));
+					return true;
+				}
+
+				if (m_Component == ComponentType::FontRenderer && m_Depth == FIELD_DEPTH && m_Keys[FIELD_DEPTH] == "Text")
+				{
+					m_FontRenderer.text = std::move(val);
+				}
+				return true;
+			}
+
+			bool binary(binary_t& val) override
+			{
+				if (IsCapturing())
+				{
+					CaptureValue(std::move(val));
+				}
+				return true;
+			}
+
+			bool start_object(std::size_t elements) override
+			{
+				if (IsCapturing())
+				{
+					json* object = CaptureValue(json::object());
+					m_CaptureStack.push_back(object);
+					return true;
+				}
+
+				m_Depth++;
+				if (m_Depth == COMPONENTS_DEPTH && m_Keys[ROOT_DEPTH] == "Assets")
+				{
+					m_Capture = json::object();
+					m_CaptureStack.push_back(&m_Capture);
+				}
+				else if (m_Depth == FIELD_DEPTH && m_InComponents)
+				{
+					BeginComponent(m_Keys[COMPONENT_DEPTH]);
+				}
+				return true;
+			}
+
+			bool end_object() override
+			{
+				if (IsCapturing())
+				{
+					m_CaptureStack.pop_back();
+					if (!IsCapturing())
+					{
+						EndCapture();
+					}
+					return true;
+				}
+
+				if (m_Depth == FIELD_DEPTH && m_InComponents)
+				{
+					EndComponent();
+				}
+				m_Depth--;
+				return true;
+			}
+
+			bool start_array(std::size_t elements) override
+			{
+				if (IsCapturing())
+				{
+					json* arr = CaptureValue(json::array());
+					m_CaptureStack.push_back(arr);
+					return true;
+				}
+
+				m_Depth++;
+				if (m_Depth == COMPONENTS_DEPTH && m_Keys[ROOT_DEPTH] == "Components")
+				{
+					m_InComponents = true;
+				}
+				return true;
+			}
+
+			bool end_array() override
+			{
+				if (IsCapturing())
+				{
+					m_CaptureStack.pop_back();
+					if (!IsCapturing())
+					{
+						EndCapture();
+					}
+					return true;
+				}
+
+				if (m_Depth == COMPONENTS_DEPTH)
+				{
+					m_InComponents = false;
+				}
+				m_Depth--;
+				return true;
+			}
+
+			bool key(string_t& val) override
+			{
+				if (IsCapturing())
+				{
+					m_CaptureKey = std::move(val);
+				}
+				else if (m_Depth <= AXIS_DEPTH)
+				{
+					m_Keys[m_Depth] = std::move(val);
+				}
+				return true;
+			}
+
+			bool parse_error(std::size_t position, const std::string& lastToken, const nlohmann::detail::exception& ex) override
+			{
+				Log::Warning("Failed to parse scene at byte %d: %s", (int)position, ex.what());
+				return false;
+			}
+
+		private:
+			bool IsCapturing() const
+			{
+				return !m_CaptureStack.empty();
+			}
+
+			template<typename T>
+			json* CaptureValue(T&& val)
+			{
+				json* parent = m_CaptureStack.back();
+				if (parent->is_array())
+				{
+					parent->emplace_back(std::forward<T>(val));
+					return &parent->back();
+				}
+
+				json& slot = (*parent)[m_CaptureKey];
+				slot = std::forward<T>(val);
+				return &slot;
+			}
+
+			void EndCapture()
+			{
+				if (m_Component == ComponentType::Script)
+				{
+					// The script library reads the component back as {"ClassName": {"Entity": id, ...}}. Engine components
+					// without a streaming path of their own come through here too, in the same shape
+					Entity entity = FindOrCreateEntity(m_Capture.front()["Entity"]);
+					const ComponentSerializerEntry* entry = ComponentSerializer::Find(m_Capture.begin().key());
+					if (entry && !entry->IsScript)
+					{
+						if (entry->Deserialize)
+						{
+							entry->Deserialize(m_Capture, entity);
+						}
+					}
+					else
+					{
+						ScriptSystem::Deserialize(m_Capture, entity);
+					}
+					m_Component = ComponentType::None;
+
+					// The capture started inside the component's object, so the depth it closes at is skipped
+					m_Depth--;
+				}
+				else
+				{
+					AssetManager::LoadTexturesFrom(m_Capture);
+					AssetManager::LoadFontsFrom(m_Capture);
+					m_Depth--;
+				}
+				m_Capture = {};
+			}
+
+			void BeginComponent(const std::string& name)
+			{
+				m_Entity = 0;
+				m_AssetId = std::numeric_limits<uint32>::max();
+				m_Component = ComponentType::None;
+				if (name == "Transform") m_Component = ComponentType::Transform;
+				else if (name == "SpriteRenderer") m_Component = ComponentType::SpriteRenderer;
+				else if (name == "FontRenderer") m_Component = ComponentType::FontRenderer;
+				else if (name == "Rigidbody2D") m_Component = ComponentType::Rigidbody2D;
+				else if (name == "Box2D") m_Component = ComponentType::Box2D;
+				else if (name == "AABB") m_Component = ComponentType::AABB;
+				else
+				{
+					m_Component = ComponentType::Script;
+					m_Capture = json::object();
+					json& fields = m_Capture[name];
+					fields = json::object();
+					m_CaptureStack.push_back(&fields);
+					return;
+				}
+
+				m_Position = glm::vec3();
+				m_Scale = glm::vec3();
+				m_Rotation = glm::vec3();
+				m_SpriteRenderer = SpriteRenderer();
+				m_FontRenderer = FontRenderer();
+				m_Rigidbody2D = Rigidbody2D();
+				m_Box = AABB();
+			}
+
+			void EndComponent()
+			{
+				if (m_Component == ComponentType::None)
+				{
+					return;
+				}
+
+				Entity entity = FindOrCreateEntity(m_Entity);
+				switch (m_Component)
+				{
+				case ComponentType::Transform:
+					NEntity::AddComponent<TransformData>(entity, Transform::CreateTransform(m_Position, m_Scale, m_Rotation));
+					break;
+				case ComponentType::SpriteRenderer:
+					if (m_AssetId != std::numeric_limits<uint32>::max())
+					{
+						m_SpriteRenderer.m_Sprite.m_Texture = AssetManager::GetSceneTexture(m_AssetId);
+					}
+					NEntity::AddComponent<SpriteRenderer>(entity, std::move(m_SpriteRenderer));
+					break;
+				case ComponentType::FontRenderer:
+					if (m_AssetId != std::numeric_limits<uint32>::max())
+					{
+						m_FontRenderer.m_Font = AssetManager::GetSceneFont(m_AssetId);
+					}
+					NEntity::AddComponent<FontRenderer>(entity, std::move(m_FontRenderer));
+					break;
+				case ComponentType::Rigidbody2D:
+					NEntity::AddComponent<Rigidbody2D>(entity, m_Rigidbody2D);
+					break;
+				case ComponentType::Box2D:
+					NEntity::AddComponent<Box2D>(entity, Box2D{ m_Box.m_HalfSize * 2.0f, m_Box.m_HalfSize, m_Box.m_Offset });
+					break;
+				case ComponentType::AABB:
+					m_Box.m_Size = m_Box.m_HalfSize * 2.0f;
+					NEntity::AddComponent<AABB>(entity, m_Box);
+					break;
+				default:
+					break;
+				}
+				m_Component = ComponentType::None;
+			}
+
+			bool SetNumber(double val)
+			{
+				if (m_Component == ComponentType::None || (m_Depth != FIELD_DEPTH && m_Depth != AXIS_DEPTH))
+				{
+					return true;
+				}
+
+				const std::string& field = m_Keys[FIELD_DEPTH];
+				if (m_Depth == FIELD_DEPTH && field == "Entity")
+				{
+					m_Entity = (uint32)val;
+					return true;
+				}
+
+				float fval = (float)val;
+				switch (m_Component)
+				{
+				case ComponentType::Transform:
+					if (field == "Position") SetAxis(&m_Position[0], 3, fval);
+					else if (field == "Scale") SetAxis(&m_Scale[0], 3, fval);
+					else if (field == "Rotation") SetAxis(&m_Rotation[0], 3, fval);
+					break;
+				case ComponentType::SpriteRenderer:
+					if (field == "AssetId") m_AssetId = (uint32)val;
+					else if (field == "ZIndex") m_SpriteRenderer.m_ZIndex = (int)val;
+					else if (field == "Color") SetAxis(&m_SpriteRenderer.m_Color[0], 4, fval);
+					break;
+				case ComponentType::FontRenderer:
+					if (field == "AssetId") m_AssetId = (uint32)val;
+					else if (field == "ZIndex") m_FontRenderer.m_ZIndex = (int)val;
+					else if (field == "Color") SetAxis(&m_FontRenderer.m_Color[0], 4, fval);
+					else if (field == "FontSize") m_FontRenderer.fontSize = (int)val;
+					else if (field == "Cached") m_FontRenderer.m_Cached = val != 0.0;
+					break;
+				case ComponentType::Rigidbody2D:
+					if (field == "AngularDamping") m_Rigidbody2D.m_AngularDamping = fval;
+					else if (field == "LinearDamping") m_Rigidbody2D.m_LinearDamping = fval;
+					else if (field == "Mass") m_Rigidbody2D.m_Mass = fval;
+					else if (field == "Velocity") SetAxis(&m_Rigidbody2D.m_Velocity[0], 2, fval);
+					else if (field == "ContinousCollision") m_Rigidbody2D.m_ContinuousCollision = val != 0.0;
+					else if (field == "FixedRotation") m_Rigidbody2D.m_FixedRotation = val != 0.0;
+					else if (field == "BodyType") m_Rigidbody2D.m_BodyType = (BodyType2D)(uint8)val;
+					break;
+				case ComponentType::Box2D:
+				case ComponentType::AABB:
+					if (field == "HalfSize") SetAxis(&m_Box.m_HalfSize[0], 2, fval);
+					else if (field == "Offset") SetAxis(&m_Box.m_Offset[0], 2, fval);
+					break;
+				default:
+					break;
+				}
+				return true;
+			}
+
+			void SetAxis(float* vec, int numAxes, float val)
+			{
+				if (m_Depth != AXIS_DEPTH)
+				{
+					return;
+				}
+
+				const std::string& axis = m_Keys[AXIS_DEPTH];
+				int index = axis == "X" ? 0 : axis == "Y" ? 1 : axis == "Z" ? 2 : axis == "W" ? 3 : -1;
+				if (index >= 0 && index < numAxes)
+				{
+					vec[index] = val;
+				}
+			}
+
+			Entity FindOrCreateEntity(uint32 id)
+			{
+				entt::entity entity = entt::entity(id);
+				if (!m_Scene.Registry.valid(entity))
+				{
+					entity = m_Scene.Registry.create(entity);
+				}
+				return Entity{ entity, &m_Scene };
+			}
+
+			SceneData& m_Scene;
+
+			int m_Depth = 0;
+			bool m_InComponents = false;
+			std::array<std::string, AXIS_DEPTH + 1> m_Keys;
+
+			// Asset tables and script components are gathered into m_Capture
+			json m_Capture;
+			std::vector<json*> m_CaptureStack;
+			std::string m_CaptureKey;
+
+			// The component currently being read
+			ComponentType m_Component = ComponentType::None;
+			uint32 m_Entity = 0;
+			uint32 m_AssetId = std::numeric_limits<uint32>::max();
+			glm::vec3 m_Position = glm::vec3();
+			glm::vec3 m_Scale = glm::vec3();
+			glm::vec3 m_Rotation = glm::vec3();
+			SpriteRenderer m_SpriteRenderer;
+			FontRenderer m_FontRenderer;
+			Rigidbody2D m_Rigidbody2D;
+			AABB m_Box;
+		};
+
+		bool Load(SceneData& data, const char* input, uint32 size)
+		{
+			SceneSaxHandler handler(data);
+			bool success = json::sax_parse(input, input + size, &handler);
+			AssetManager::EvictUnreferenced();
+			return success;
+		}
+	}
+}
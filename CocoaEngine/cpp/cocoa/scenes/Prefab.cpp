@@ -0,0 +1,214 @@
+#include "cocoa/scenes/Prefab.h"
+#include "cocoa/scenes/ComponentSerializer.h"
+#include "cocoa/scenes/AssetTable.h"
+#include "cocoa/systems/ScriptSystem.h"
+#include "cocoa/physics2d/PhysicsComponents.h"
+#include "cocoa/file/File.h"
+#include "cocoa/util/Log.h"
+
+namespace Cocoa
+{
+	namespace NPrefab
+	{
+		// Internal Variables
+		static std::vector<entt::entity> m_Scratch;
+
+		// Forward Declarations
+		static Prefab CreateFromScene(Entity entity, json scripts);
+
+		Prefab Create(Entity entity)
+		{
+			// The script library only saves every script component at once, this entity's are picked out afterwards
+			json allScripts = { {"Components", json::array()} };
+			ScriptSystem::SaveScripts(allScripts);
+
+			json scripts = json::array();
+			uint32 id = NEntity::GetID(entity);
+			for (json& component : allScripts["Components"])
+			{
+				if (component.front()["Entity"] == id)
+				{
+					scripts.push_back(std::move(component));
+				}
+			}
+
+			return CreateFromScene(entity, std::move(scripts));
+		}
+
+		void Instantiate(SceneData& scene, const Prefab& prefab, uint32 count, const TransformData* transforms, entt::entity* outEntities)
+		{
+			if (count == 0)
+			{
+				return;
+			}
+
+			entt::entity* entities = outEntities;
+			if (!entities)
+			{
+				m_Scratch.resize(count);
+				entities = m_Scratch.data();
+			}
+
+			scene.Registry.create(entities, entities + count);
+			const entt::id_type transformId = entt::type_info<TransformData>().id();
+			for (const PrefabComponent& component : prefab.Components)
+			{
+				if (transforms && component.TypeId == transformId)
+				{
+					scene.Registry.insert<TransformData>(entities, entities + count, transforms, transforms + count);
+					continue;
+				}
+
+				const ComponentSerializerEntry* entry = ComponentSerializer::Find(component.TypeId);
+				if (entry && entry->InsertRange)
+				{
+					entry->InsertRange(scene, entities, entities + count, component.Component.get());
+				}
+			}
+
+			if (transforms && !HasComponent(prefab, transformId))
+			{
+				scene.Registry.insert<TransformData>(entities, entities + count, transforms, transforms + count);
+			}
+
+			for (const json& component : prefab.Scripts)
+			{
+				for (uint32 i = 0; i < count; i++)
+				{
+					json scriptComponent = component;
+					scriptComponent.front()["Entity"] = entt::to_integral(entities[i]);
+					ScriptSystem::Deserialize(scriptComponent, Entity{ entities[i], &scene });
+				}
+			}
+		}
+
+		Entity Instantiate(SceneData& scene, const Prefab& prefab)
+		{
+			entt::entity entity;
+			Instantiate(scene, prefab, 1, nullptr, &entity);
+			return Entity{ entity, &scene };
+		}
+
+		bool HasComponent(const Prefab& prefab, entt::id_type typeId)
+		{
+			for (const PrefabComponent& component : prefab.Components)
+			{
+				if (component.TypeId == typeId)
+				{
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool Save(const Prefab& prefab, const CPath& filename)
+		{
+			// The component serializers write from a registry, so the prefab is laid out in a scratch scene first
+			SceneData scratch;
+			scratch.IsPlaying = false;
+			Entity entity = Instantiate(scratch, Prefab{ prefab.Components, json::array() });
+
+			// Resource ids are only meaningful to the scene they were loaded by, so the prefab carries its own asset table
+			json j = { {"Components", json::array()}, {"Assets", AssetTable::Serialize(&entity, 1)} };
+			for (const ComponentSerializerEntry& entry : ComponentSerializer::GetEntries())
+			{
+				if (entry.SerializeAll)
+				{
+					entry.SerializeAll(j, scratch);
+				}
+			}
+
+			for (const json& component : prefab.Scripts)
+			{
+				j["Components"].push_back(component);
+				j["Components"].back().front()["Entity"] = NEntity::GetID(entity);
+			}
+
+			return File::WriteFile(j.dump(4).c_str(), filename);
+		}
+
+		bool Load(Prefab& prefab, const CPath& filename)
+		{
+			FileHandle* file = File::OpenFile(filename);
+			if (file->m_Size <= 0)
+			{
+				Log::Warning("Could not load prefab %s", filename.Path.c_str());
+				File::CloseFile(file);
+				return false;
+			}
+
+			json j = json::parse(file->m_Data, file->m_Data + file->m_Size, nullptr, false);
+			File::CloseFile(file);
+			if (j.is_discarded() || !j.contains("Components"))
+			{
+				Log::Warning("Prefab %s is not valid json", filename.Path.c_str());
+				return false;
+			}
+
+			// Prefabs saved before they had an asset table fall back to the current scene's resource ids
+			AssetRemap remap;
+			if (j.contains("Assets"))
+			{
+				AssetTable::Resolve(j["Assets"], remap);
+			}
+
+			SceneData scratch;
+			scratch.IsPlaying = false;
+			Entity entity = Entity{ scratch.Registry.create(), &scratch };
+			json scripts = json::array();
+			for (json& component : j["Components"])
+			{
+				json::iterator it = component.begin();
+				if (it == component.end())
+				{
+					continue;
+				}
+
+				const ComponentSerializerEntry* entry = ComponentSerializer::Find(it.key());
+				if (entry && !entry->IsScript && entry->Deserialize)
+				{
+					entry->Deserialize(component, entity);
+					AssetTable::Remap(component, entity, remap);
+				}
+				else
+				{
+					scripts.push_back(component);
+				}
+			}
+
+			prefab = CreateFromScene(entity, std::move(scripts));
+			return true;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static Prefab CreateFromScene(Entity entity, json scripts)
+		{
+			Prefab prefab;
+			for (const ComponentSerializerEntry& entry : ComponentSerializer::GetEntries())
+			{
+				if (entry.CopyOut)
+				{
+					std::shared_ptr<const void> component = entry.CopyOut(entity);
+					if (component && entry.TypeId == entt::type_info<Rigidbody2D>().id())
+					{
+						// Every instance gets a body of its own, none of them may start out with the source entity's
+						Rigidbody2D rb = *static_cast<const Rigidbody2D*>(component.get());
+						rb.m_RawRigidbody = nullptr;
+						component = std::make_shared<const Rigidbody2D>(rb);
+					}
+
+					if (component)
+					{
+						prefab.Components.push_back({ entry.TypeId, std::move(component) });
+					}
+				}
+			}
+
+			prefab.Scripts = std::move(scripts);
+			return prefab;
+		}
+	}
+}
@@ -0,0 +1,80 @@
+#include "cocoa/scenes/RegistrySnapshot.h"
+#include "cocoa/physics2d/Physics2D.h"
+#include "cocoa/systems/ScriptSystem.h"
+#include "cocoa/util/Log.h"
+
+namespace Cocoa
+{
+	namespace NRegistrySnapshot
+	{
+		void Capture(SceneData& scene, RegistrySnapshot& snapshot)
+		{
+			snapshot.Entities.clear();
+			snapshot.Entities.reserve(scene.Registry.alive());
+			scene.Registry.each([&snapshot](entt::entity entity)
+			{
+				snapshot.Entities.push_back(entity);
+			});
+
+			snapshot.Components.clear();
+			for (const ComponentSerializerEntry& entry : ComponentSerializer::GetEntries())
+			{
+				if (entry.Snapshot)
+				{
+					snapshot.Components.emplace_back();
+					entry.Snapshot(scene, snapshot.Components.back());
+				}
+			}
+
+			CaptureScripts(snapshot);
+		}
+
+		void Restore(SceneData& scene, const RegistrySnapshot& snapshot)
+		{
+			ScriptSystem::ClearScripts();
+			scene.Registry.clear();
+
+			// The hints carry the entity versions too, so every handle held before the capture is valid again
+			for (entt::entity entity : snapshot.Entities)
+			{
+				scene.Registry.create(entity);
+			}
+
+			for (const ComponentArray& array : snapshot.Components)
+			{
+				const ComponentSerializerEntry* entry = ComponentSerializer::Find(array.TypeId);
+				if (entry && entry->Restore)
+				{
+					entry->Restore(scene, array);
+				}
+			}
+
+			RestoreScripts(scene, snapshot);
+
+			// Bodies outlive the components, restored rigidbodies get their entity's body back in its restored pose
+			Physics2D::ResetBodies(scene);
+		}
+
+		void CaptureScripts(RegistrySnapshot& snapshot)
+		{
+			json scripts = { {"Components", json::array()} };
+			ScriptSystem::SaveScripts(scripts);
+			snapshot.Scripts = std::move(scripts["Components"]);
+		}
+
+		void RestoreScripts(SceneData& scene, const RegistrySnapshot& snapshot)
+		{
+			for (const json& component : snapshot.Scripts)
+			{
+				// The script library takes a mutable json, so each component is copied on its own
+				json scriptComponent = component;
+				entt::entity entity = entt::entity((uint32)scriptComponent.front()["Entity"]);
+				if (!scene.Registry.valid(entity))
+				{
+					entity = scene.Registry.create(entity);
+				}
+				ScriptSystem::Deserialize(scriptComponent, Entity{ entity, &scene });
+			}
+		}
+	}
+}
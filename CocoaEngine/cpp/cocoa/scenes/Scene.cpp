@@ -1,6 +1,11 @@
 #include "cocoa/scenes/Scene.h"
+#include "cocoa/scenes/BinaryScene.h"
+#include "cocoa/scenes/JsonSceneReader.h"
+#include "cocoa/scenes/ComponentSerializer.h"
+#include "cocoa/scenes/AsyncSceneSaver.h"
+#include "cocoa/scenes/WorldStreamer.h"
+#include "cocoa/scenes/SpatialIndex.h"
 
-#include "cocoa/file/OutputArchive.h"
 #include "cocoa/file/File.h"
 #include "cocoa/util/Settings.h"
 #include "cocoa/core/Entity.h"
@@ -18,7 +23,6 @@ namespace Cocoa
 	{
 		// Forward Declarations
 		static void LoadDefaultAssets();
-		static Entity FindOrCreateEntity(int id, SceneData& scene, entt::registry& registry);
 
 		SceneData Create(SceneInitializer* sceneInitializer)
 		{
@@ -41,7 +45,8 @@ namespace Cocoa
 			NEntity::SetScene(&data);
 
 			RenderSystem::Init(data);
-			Physics2D::Init({ 0, -10.0f });
+			SpatialIndex::Init(data);
+			Physics2D::Init(data, { 0, -10.0f });
 			ScriptSystem::Init();
 
 			data.CurrentSceneInitializer->Init(data);
@@ -54,14 +59,19 @@ namespace Cocoa
 
 		void Update(SceneData& data, float dt)
 		{
+			WorldStreamer::Update(data);
 			Physics2D::Update(data, dt);
 			ScriptSystem::Update(data, dt);
+			Physics2D::StartStep(data);
 			NCamera::Update(data.SceneCamera);
 		}
 
 		void EditorUpdate(SceneData& data, float dt)
 		{
+			WorldStreamer::Update(data);
 			ScriptSystem::EditorUpdate(data, dt);
+			SpatialIndex::Update(data);
+			Physics2D::EditorUpdate(data);
 			NCamera::Update(data.SceneCamera);
 		}
 
@@ -88,7 +98,10 @@ namespace Cocoa
 
 		void FreeResources(SceneData& data)
 		{
-			AssetManager::Clear();
+			// Assets stay loaded, the next scene picks up whatever it shares with this one
+			AssetManager::ReleaseScene(AssetManager::s_CurrentScene);
+			WorldStreamer::Close(data);
+			SpatialIndex::Destroy(data);
 			auto view = data.Registry.view<TransformData>();
 			data.Registry.destroy(view.begin(), view.end());
 
@@ -102,39 +115,54 @@ namespace Cocoa
 		void Play(SceneData& data)
 		{
 			data.IsPlaying = true;
-			auto view = data.Registry.view<TransformData>();
-			for (auto entity : view)
-			{
-				Physics2D::AddEntity(Entity{entity, &data});
-			}
+
+			// The index isn't kept up to date while playing, it is rebuilt on the first editor frame after Stop
+			SpatialIndex::Clear();
+
+			// Bodies already exist, they only have to be put back where the editor left their entities
+			Physics2D::ResetBodies(data);
 		}
 
 		void Stop(SceneData& data)
 		{
+			WorldStreamer::Stop(data);
 			data.IsPlaying = false;
 		}
 
 		void Save(SceneData& data, const CPath& filename)
 		{
 			Log::Info("Saving scene for %s", filename.Path.c_str());
+
+			// A queued save of an older snapshot must not land on top of this one
+			AsyncSceneSaver::WaitAll();
+			WorldStreamer::SaveCells(data, filename);
+			std::vector<uint8> output;
+			BinaryScene::Serialize(data, output);
+			if (!File::WriteFileAtomic(output.data(), (uint32)output.size(), filename))
+			{
+				Log::Warning("Failed to save scene %s", filename.Path.c_str());
+			}
+		}
+
+		void ExportJson(SceneData& data, const CPath& filename)
+		{
+			Log::Info("Exporting scene as json to %s", filename.Path.c_str());
+
+			// The json file holds the whole world, not just what is streamed in
+			WorldStreamer::LoadAll(data);
 			data.SaveDataJson = {
 				{"Components", {}},
 				{"Project", Settings::General::s_CurrentProject.Path.c_str()},
 				{"Assets", AssetManager::Serialize()}
 			};
 
-			OutputArchive output(data.SaveDataJson);
-			entt::snapshot{ data.Registry }
-				.entities(output)
-				.component<TransformData, Rigidbody2D, Box2D, SpriteRenderer, FontRenderer, AABB>(output);
-
-			ScriptSystem::SaveScripts(data.SaveDataJson);
-
+			ComponentSerializer::Serialize(data.SaveDataJson, data);
 			File::WriteFile(data.SaveDataJson.dump(4).c_str(), filename);
 		}
 
 		void Load(SceneData& data, const CPath& filename)
 		{
+			AsyncSceneSaver::WaitAll();
 			FreeResources(data);
 			Log::Info("Loading scene %s", filename.Path.c_str());
 
@@ -142,88 +170,33 @@ namespace Cocoa
 			FileHandle* file = File::OpenFile(filename);
 			if (file->m_Size <= 0)
 			{
+				File::CloseFile(file);
 				return;
 			}
 
 			Init(data);
 
-			json j = json::parse(file->m_Data);
-
-			if (j.contains("Assets"))
+			if (BinaryScene::IsBinary((const uint8*)file->m_Data, file->m_Size))
 			{
-				AssetManager::LoadTexturesFrom(j["Assets"]);
-				AssetManager::LoadFontsFrom(j["Assets"]);
-			}
-
-			int size = !j.contains("Components") ? 0 : j["Components"].size();
-			for (int i = 0; i < size; i++)
-			{
-				json::iterator it = j["Components"][i].begin();
-				json component = j["Components"][i];
-				if (it.key() == "SpriteRenderer")
-				{
-					Entity entity = FindOrCreateEntity(component["SpriteRenderer"]["Entity"], data, data.Registry);
-					RenderSystem::DeserializeSpriteRenderer(component, entity);
-				}
-				else if (it.key() == "FontRenderer")
-				{
-					Entity entity = FindOrCreateEntity(component["FontRenderer"]["Entity"], data, data.Registry);
-					RenderSystem::DeserializeFontRenderer(component, entity);
-				}
-				else if (it.key() == "Transform")
-				{
-					Entity entity = FindOrCreateEntity(component["Transform"]["Entity"], data, data.Registry);
-					Transform::Deserialize(component, entity);
-				}
-				else if (it.key() == "Rigidbody2D")
+				if (!BinaryScene::Deserialize(data, (const uint8*)file->m_Data, file->m_Size))
 				{
-					Entity entity = FindOrCreateEntity(component["Rigidbody2D"]["Entity"], data, data.Registry);
-					Physics2D::DeserializeRigidbody2D(component, entity);
+					Log::Warning("Failed to load scene %s", filename.Path.c_str());
 				}
-				else if (it.key() == "Box2D")
-				{
-					Entity entity = FindOrCreateEntity(component["Box2D"]["Entity"], data, data.Registry);
-					Physics2D::DeserializeBox2D(component, entity);
-				}
-				else if (it.key() == "AABB")
-				{
-					Entity entity = FindOrCreateEntity(component["AABB"]["Entity"], data, data.Registry);
-					Physics2D::DeserializeAABB(component, entity);
-				}
-				else
+
+				// Entities in world cells aren't part of the scene file, they stream in around the camera
+				uint64 worldCellsHash = BinaryScene::GetWorldCellsHash((const uint8*)file->m_Data, file->m_Size);
+				if (worldCellsHash != 0)
 				{
-					Entity entity = FindOrCreateEntity(component.front()["Entity"], data, data.Registry);
-					ScriptSystem::Deserialize(component, entity);
+					WorldStreamer::Open(data, filename, worldCellsHash);
 				}
-			}
-
-			j = {};
-			File::CloseFile(file);
-		}
-
-		void LoadScriptsOnly(SceneData& data, const CPath& filename)
-		{
-			FileHandle* file = File::OpenFile(filename);
-			if (file->m_Size <= 0)
-			{
+				File::CloseFile(file);
 				return;
 			}
 
-			Log::Info("Loading scripts only for %s", filename.Path.c_str());
-			json j = json::parse(file->m_Data);
-			int size = !j.contains("Components") ? 0 : j["Components"].size();
-			for (int i = 0; i < size; i++)
+			if (!JsonSceneReader::Load(data, file->m_Data, file->m_Size))
 			{
-				json::iterator it = j["Components"][i].begin();
-				json component = j["Components"][i];
-				if (it.key() != "SpriteRenderer" && it.key() != "Transform" && it.key() != "Rigidbody2D" && it.key() != "Box2D" && it.key() != "AABB")
-				{
-					Entity entity = FindOrCreateEntity(component.front()["Entity"], data, data.Registry);
-					ScriptSystem::Deserialize(component, entity);
-				}
+				Log::Warning("Failed to load scene %s", filename.Path.c_str());
 			}
-
-			j = {};
 			File::CloseFile(file);
 		}
 
@@ -240,26 +213,7 @@ namespace Cocoa
 		{
 			entt::entity newEntEntity = data.Registry.create();
 			Entity newEntity = Entity{newEntEntity, &data};
-			if (NEntity::HasComponent<TransformData>(entity))
-			{
-				NEntity::AddComponent<TransformData>(newEntity, NEntity::GetComponent<TransformData>(entity));
-			}
-
-			if (NEntity::HasComponent<SpriteRenderer>(entity))
-			{
-				NEntity::AddComponent<SpriteRenderer>(newEntity, NEntity::GetComponent<SpriteRenderer>(entity));
-			}
-
-			if (NEntity::HasComponent<Rigidbody2D>(entity))
-			{
-				NEntity::AddComponent<Rigidbody2D>(newEntity, NEntity::GetComponent<Rigidbody2D>(entity));
-			}
-
-			if (NEntity::HasComponent<Box2D>(entity))
-			{
-				NEntity::AddComponent<Box2D>(newEntity, NEntity::GetComponent<Box2D>(entity));
-			}
-
+			ComponentSerializer::CopyComponents(entity, newEntity);
 			return newEntity;
 		}
 
@@ -285,20 +239,5 @@ namespace Cocoa
 			NCPath::Join(gizmoPath, NCPath::CreatePath("images/gizmos.png"));
 			auto asset = AssetManager::LoadTextureFromFile(gizmoSpec, gizmoPath);
 		}
-
-		static Entity FindOrCreateEntity(int id, SceneData& scene, entt::registry& registry)
-		{
-			Entity entity;
-			if (registry.valid(entt::entity(id)))
-			{
-				entity = Entity{entt::entity(id), &scene};
-			}
-			else
-			{
-				entity = Entity{registry.create(entt::entity(id)), &scene};
-			}
-
-			return entity;
-		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "cocoa/scenes/SpatialIndex.h"
+#include "cocoa/util/DynamicAabbTree.h"
+#include "cocoa/util/CMath.h"
+#include "cocoa/components/Transform.h"
+#include "cocoa/components/SpriteRenderer.h"
+#include "cocoa/physics2d/PhysicsComponents.h"
+
+namespace Cocoa
+{
+	namespace SpatialIndex
+	{
+		// Everything an entity's bounds are computed from, compared each Update to find the entities that changed
+		struct BoundsSource
+		{
+			glm::vec3 Position;
+			glm::vec3 Scale;
+			float Rotation;
+			glm::vec2 SpriteSize;
+			glm::vec2 BoxHalfSize;
+			glm::vec2 BoxOffset;
+			bool HasSprite;
+			bool HasBox;
+		};
+
+		struct IndexedEntity
+		{
+			entt::entity Entity;
+			int32 Proxy;
+			BoundsSource Source;
+			glm::vec2 Min;
+			glm::vec2 Max;
+		};
+
+		// Internal Variables
+		// Sprites are 32 units across by default, so small nudges in the editor don't reinsert anything
+		static const float FAT_MARGIN = 8.0f;
+
+		static DynamicAabbTree m_Tree = NDynamicAabbTree::Create(FAT_MARGIN);
+		static std::vector<int32> m_Proxies;
+		static bool m_Active = false;
+
+		// Indexed by entity index. Slots of entities that aren't in the tree hold entt::null
+		static std::vector<IndexedEntity> m_Slots;
+
+		// Entities that lost a component their bounds depend on since the last Update
+		static std::vector<entt::entity> m_Removed;
+
+		// Forward Declarations
+		template<typename Component>
+		static void ConnectEvents(entt::registry& registry);
+		template<typename Component>
+		static void DisconnectEvents(entt::registry& registry);
+		static void OnBoundsRemoved(entt::registry& registry, entt::entity entity);
+		static IndexedEntity* FindSlot(entt::entity entity);
+		static void RemoveIfUnbounded(const SceneData& scene, entt::entity entity);
+		static BoundsSource GetBoundsSource(const TransformData& transform, const SpriteRenderer* spr, const AABB* box);
+		static bool SameSource(const BoundsSource& a, const BoundsSource& b);
+		static void ComputeBounds(const BoundsSource& source, glm::vec2& min, glm::vec2& max);
+		static bool ContainsPoint(const IndexedEntity& indexed, const glm::vec2& point);
+
+		void Init(SceneData& scene)
+		{
+			ConnectEvents<TransformData>(scene.Registry);
+			ConnectEvents<SpriteRenderer>(scene.Registry);
+			ConnectEvents<AABB>(scene.Registry);
+		}
+
+		void Destroy(SceneData& scene)
+		{
+			DisconnectEvents<TransformData>(scene.Registry);
+			DisconnectEvents<SpriteRenderer>(scene.Registry);
+			DisconnectEvents<AABB>(scene.Registry);
+			Clear();
+		}
+
+		void Update(SceneData& scene)
+		{
+			m_Active = true;
+			for (entt::entity entity : m_Removed)
+			{
+				RemoveIfUnbounded(scene, entity);
+			}
+			m_Removed.clear();
+
+			auto view = scene.Registry.view<TransformData>();
+			for (entt::entity entity : view)
+			{
+				const SpriteRenderer* spr = scene.Registry.try_get<SpriteRenderer>(entity);
+				const AABB* box = scene.Registry.try_get<AABB>(entity);
+				if (!spr && !box)
+				{
+					continue;
+				}
+
+				BoundsSource source = GetBoundsSource(view.get<TransformData>(entity), spr, box);
+				uint32 index = entt::to_integral(entity) & entt::entt_traits<entt::entity>::entity_mask;
+				if (index >= m_Slots.size())
+				{
+					m_Slots.resize(index + 1, IndexedEntity{ entt::null });
+				}
+
+				IndexedEntity& indexed = m_Slots[index];
+				if (indexed.Entity != entity)
+				{
+					if (indexed.Entity != entt::null)
+					{
+						// The index was recycled before the removal of the entity it belonged to got processed
+						NDynamicAabbTree::Remove(m_Tree, indexed.Proxy);
+					}
+
+					indexed.Entity = entity;
+					indexed.Source = source;
+					ComputeBounds(source, indexed.Min, indexed.Max);
+					indexed.Proxy = NDynamicAabbTree::Insert(m_Tree, indexed.Min, indexed.Max, (uint32)entity);
+				}
+				else if (!SameSource(indexed.Source, source))
+				{
+					indexed.Source = source;
+					ComputeBounds(source, indexed.Min, indexed.Max);
+					NDynamicAabbTree::Move(m_Tree, indexed.Proxy, indexed.Min, indexed.Max);
+				}
+			}
+		}
+
+		void Clear()
+		{
+			NDynamicAabbTree::Clear(m_Tree);
+			m_Slots.clear();
+			m_Removed.clear();
+			m_Active = false;
+		}
+
+		bool IsActive()
+		{
+			return m_Active;
+		}
+
+		Entity Pick(SceneData& scene, const glm::vec2& point)
+		{
+			m_Proxies.clear();
+			NDynamicAabbTree::Query(m_Tree, point, point, m_Proxies);
+
+			entt::entity best = entt::null;
+			int bestZIndex = 0;
+			for (int32 proxy : m_Proxies)
+			{
+				entt::entity entity = entt::entity(NDynamicAabbTree::GetUserData(m_Tree, proxy));
+				const IndexedEntity* indexed = FindSlot(entity);
+				if (!indexed || !scene.Registry.valid(entity) || !ContainsPoint(*indexed, point))
+				{
+					continue;
+				}
+
+				const SpriteRenderer* spr = scene.Registry.try_get<SpriteRenderer>(entity);
+				int zIndex = spr ? spr->m_ZIndex : 0;
+				if (best == entt::null || zIndex > bestZIndex)
+				{
+					best = entity;
+					bestZIndex = zIndex;
+				}
+			}
+
+			return Entity{ best, &scene };
+		}
+
+		void QueryBox(const glm::vec2& min, const glm::vec2& max, std::vector<entt::entity>& results)
+		{
+			m_Proxies.clear();
+			NDynamicAabbTree::Query(m_Tree, min, max, m_Proxies);
+			for (int32 proxy : m_Proxies)
+			{
+				// The tree only knows the fat boxes
+				entt::entity entity = entt::entity(NDynamicAabbTree::GetUserData(m_Tree, proxy));
+				const IndexedEntity* indexed = FindSlot(entity);
+				if (indexed && indexed->Min.x <= max.x && indexed->Min.y <= max.y && indexed->Max.x >= min.x && indexed->Max.y >= min.y)
+				{
+					results.push_back(entity);
+				}
+			}
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		template<typename Component>
+		static void ConnectEvents(entt::registry& registry)
+		{
+			registry.on_destroy<Component>().template connect<&OnBoundsRemoved>();
+		}
+
+		template<typename Component>
+		static void DisconnectEvents(entt::registry& registry)
+		{
+			registry.on_destroy<Component>().template disconnect<&OnBoundsRemoved>();
+		}
+
+		static void OnBoundsRemoved(entt::registry& registry, entt::entity entity)
+		{
+			// The component is still attached, the entity is looked at on the next Update. While playing the index is
+			// cleared and rebuilt afterwards anyway
+			if (m_Active)
+			{
+				m_Removed.push_back(entity);
+			}
+		}
+
+		static IndexedEntity* FindSlot(entt::entity entity)
+		{
+			uint32 index = entt::to_integral(entity) & entt::entt_traits<entt::entity>::entity_mask;
+			if (index < m_Slots.size() && m_Slots[index].Entity == entity)
+			{
+				return &m_Slots[index];
+			}
+			return nullptr;
+		}
+
+		static void RemoveIfUnbounded(const SceneData& scene, entt::entity entity)
+		{
+			IndexedEntity* indexed = FindSlot(entity);
+			if (!indexed)
+			{
+				return;
+			}
+
+			const entt::registry& registry = scene.Registry;
+			if (registry.valid(entity) && registry.has<TransformData>(entity) &&
+				(registry.has<SpriteRenderer>(entity) || registry.has<AABB>(entity)))
+			{
+				return;
+			}
+
+			NDynamicAabbTree::Remove(m_Tree, indexed->Proxy);
+			indexed->Entity = entt::null;
+		}
+
+		static BoundsSource GetBoundsSource(const TransformData& transform, const SpriteRenderer* spr, const AABB* box)
+		{
+			BoundsSource source;
+			source.Position = transform.Position;
+			source.Scale = transform.Scale;
+			source.Rotation = transform.EulerRotation.z;
+			source.HasSprite = spr != nullptr;
+			source.SpriteSize = spr ? glm::vec2((float)spr->m_Sprite.m_Width, (float)spr->m_Sprite.m_Height) : glm::vec2();
+			source.HasBox = box != nullptr;
+			source.BoxHalfSize = box ? box->m_HalfSize : glm::vec2();
+			source.BoxOffset = box ? box->m_Offset : glm::vec2();
+			return source;
+		}
+
+		static bool SameSource(const BoundsSource& a, const BoundsSource& b)
+		{
+			return a.Position == b.Position && a.Scale == b.Scale && a.Rotation == b.Rotation &&
+				a.HasSprite == b.HasSprite && a.SpriteSize == b.SpriteSize &&
+				a.HasBox == b.HasBox && a.BoxHalfSize == b.BoxHalfSize && a.BoxOffset == b.BoxOffset;
+		}
+
+		static void ComputeBounds(const BoundsSource& source, glm::vec2& min, glm::vec2& max)
+		{
+			glm::vec2 position = glm::vec2(source.Position.x, source.Position.y);
+			glm::vec2 scale = glm::vec2(source.Scale.x, source.Scale.y);
+			min = glm::vec2(std::numeric_limits<float>::max());
+			max = glm::vec2(-std::numeric_limits<float>::max());
+
+			if (source.HasSprite)
+			{
+				// The same quad the render batch builds, centered on the position and rotated around it
+				glm::vec2 halfSize = glm::abs(source.SpriteSize * scale) * 0.5f;
+				float radians = CMath::ToRadians(source.Rotation);
+				float cosAngle = glm::abs(glm::cos(radians));
+				float sinAngle = glm::abs(glm::sin(radians));
+				glm::vec2 extents = glm::vec2(cosAngle * halfSize.x + sinAngle * halfSize.y, sinAngle * halfSize.x + cosAngle * halfSize.y);
+				min = position - extents;
+				max = position + extents;
+			}
+
+			if (source.HasBox)
+			{
+				glm::vec2 center = position + source.BoxOffset * scale;
+				glm::vec2 halfSize = glm::abs(source.BoxHalfSize * scale);
+				min = glm::min(min, center - halfSize);
+				max = glm::max(max, center + halfSize);
+			}
+		}
+
+		static bool ContainsPoint(const IndexedEntity& indexed, const glm::vec2& point)
+		{
+			const BoundsSource& source = indexed.Source;
+			glm::vec2 scale = glm::vec2(source.Scale.x, source.Scale.y);
+			if (source.HasSprite)
+			{
+				// Rotate the point into the sprite's space instead of testing against the rotated quad
+				glm::vec2 halfSize = glm::abs(source.SpriteSize * scale) * 0.5f;
+				float radians = -CMath::ToRadians(source.Rotation);
+				glm::vec2 offset = point - glm::vec2(source.Position.x, source.Position.y);
+				glm::vec2 local = glm::vec2(
+					offset.x * glm::cos(radians) - offset.y * glm::sin(radians),
+					offset.x * glm::sin(radians) + offset.y * glm::cos(radians));
+				if (glm::abs(local.x) <= halfSize.x && glm::abs(local.y) <= halfSize.y)
+				{
+					return true;
+				}
+			}
+
+			if (source.HasBox)
+			{
+				glm::vec2 center = glm::vec2(source.Position.x, source.Position.y) + source.BoxOffset * scale;
+				glm::vec2 halfSize = glm::abs(source.BoxHalfSize * scale);
+				glm::vec2 offset = glm::abs(point - center);
+				return offset.x <= halfSize.x && offset.y <= halfSize.y;
+			}
+
+			return false;
+		}
+	}
+}
@@ -0,0 +1,654 @@
+#include "externalLibs.h"
+
+#include "cocoa/scenes/WorldStreamer.h"
+#include "cocoa/scenes/ComponentSerializer.h"
+#include "cocoa/scenes/AssetTable.h"
+#include "cocoa/components/Transform.h"
+#include "cocoa/systems/ScriptSystem.h"
+#include "cocoa/file/File.h"
+#include "cocoa/util/Settings.h"
+#include "cocoa/util/Log.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+
+namespace Cocoa
+{
+	namespace WorldStreamer
+	{
+		enum class CellStatus : uint8
+		{
+			Unloaded,
+			Loading,
+			Resident
+		};
+
+		struct Cell
+		{
+			int32 X;
+			int32 Y;
+			std::string Filepath;
+			std::vector<entt::entity> Entities;
+			CellStatus Status;
+
+			// Pinned cells stay resident until the scene is closed
+			bool Pinned;
+		};
+
+		struct LoadJob
+		{
+			uint64 Key;
+			std::string Filepath;
+			uint32 Generation;
+		};
+
+		struct LoadedCell
+		{
+			uint64 Key;
+			uint32 Generation;
+			json Components;
+			bool Success;
+		};
+
+		// Internal Variables
+		static const char* INDEX_FILENAME = "index.json";
+
+		static std::thread m_Worker;
+		static std::mutex m_Mutex;
+		static std::condition_variable m_JobAvailable;
+		static std::deque<LoadJob> m_Jobs;
+		static std::deque<LoadedCell> m_Loaded;
+		static uint32 m_Generation = 0;
+		static bool m_Running = false;
+
+		// Only touched on the main thread
+		static std::unordered_map<uint64, Cell> m_Cells;
+		static std::unordered_set<entt::entity> m_OwnedEntities;
+		static CPath m_Directory;
+		static float m_CellSize = 0.0f;
+		static uint64 m_IndexHash = 0;
+		static bool m_Open = false;
+
+		// Forward Declarations
+		static void WorkerLoop();
+		static bool ReadCell(const std::string& filepath, json& components);
+		static uint64 CellKey(int32 x, int32 y);
+		static std::string CellFilename(int32 x, int32 y);
+		static uint64 HashBytes(const std::string& bytes);
+		static void CancelLoads();
+		static void Queue(uint64 key, Cell& cell);
+		static void LoadNow(SceneData& scene, Cell& cell);
+		static bool WriteCell(SceneData& scene, Cell& cell, const std::vector<entt::entity>& entities);
+		static void AddToScene(SceneData& scene, Cell& cell, json& components);
+		static void RemoveFromScene(SceneData& scene, Cell& cell);
+
+		void Init()
+		{
+			Log::Assert(!m_Running, "Tried to initialize the world streamer twice.");
+			m_Running = true;
+			m_Worker = std::thread(WorkerLoop);
+		}
+
+		void Destroy()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Running = false;
+				m_Jobs.clear();
+			}
+			m_JobAvailable.notify_all();
+			m_Worker.join();
+			m_Loaded.clear();
+		}
+
+		bool SaveCells(SceneData& scene, const CPath& sceneFile)
+		{
+			CPath directory = GetCellDirectory(sceneFile);
+			if (scene.IsPlaying)
+			{
+				if (File::IsDirectory(directory))
+				{
+					Log::Warning("World cells are not saved while playing.");
+				}
+				return false;
+			}
+
+			const float cellSize = Settings::Streaming::s_CellSize;
+			if (m_Open && (m_Directory.Path != directory.Path || m_CellSize != cellSize))
+			{
+				// Saved under a new name, or split on a new grid. Either way the whole world has to be in the scene, and
+				// every cell is written again from scratch
+				LoadAll(scene);
+				m_Cells.clear();
+				m_OwnedEntities.clear();
+				m_Open = false;
+			}
+
+			if (!File::IsDirectory(directory))
+			{
+				return false;
+			}
+
+			CancelLoads();
+			m_Directory = directory;
+			m_CellSize = cellSize;
+
+			// Script components can't be streamed out again, so their entities stay in the scene
+			json scripts = { {"Components", json::array()} };
+			ScriptSystem::SaveScripts(scripts);
+			std::unordered_set<uint32> scriptedEntities;
+			for (const json& component : scripts["Components"])
+			{
+				scriptedEntities.insert((uint32)component.front()["Entity"]);
+			}
+
+			std::unordered_map<uint64, std::vector<entt::entity>> cellEntities;
+			auto view = scene.Registry.view<TransformData>();
+			for (entt::entity entity : view)
+			{
+				if (scriptedEntities.find(entt::to_integral(entity)) != scriptedEntities.end())
+				{
+					continue;
+				}
+
+				const TransformData& transform = view.get(entity);
+				int32 x = (int32)glm::floor(transform.Position.x / cellSize);
+				int32 y = (int32)glm::floor(transform.Position.y / cellSize);
+				cellEntities[CellKey(x, y)].push_back(entity);
+			}
+
+			// Entities that moved into a cell that isn't resident would overwrite what the cell holds on disk, so the cell
+			// comes in first and gets written with them
+			for (auto& [key, entities] : cellEntities)
+			{
+				auto iter = m_Cells.find(key);
+				if (iter != m_Cells.end() && iter->second.Status != CellStatus::Resident)
+				{
+					LoadNow(scene, iter->second);
+					entities.insert(entities.end(), iter->second.Entities.begin(), iter->second.Entities.end());
+				}
+			}
+
+			// Resident cells that lost all their entities are dropped, cells that aren't resident were not touched
+			for (auto iter = m_Cells.begin(); iter != m_Cells.end();)
+			{
+				if (iter->second.Status == CellStatus::Resident && cellEntities.find(iter->first) == cellEntities.end())
+				{
+					iter = m_Cells.erase(iter);
+				}
+				else
+				{
+					++iter;
+				}
+			}
+
+			bool success = true;
+			for (const auto& [key, entities] : cellEntities)
+			{
+				auto iter = m_Cells.find(key);
+				if (iter == m_Cells.end())
+				{
+					Cell cell;
+					cell.X = (int32)(uint32)(key >> 32);
+					cell.Y = (int32)(uint32)(key & 0xFFFFFFFF);
+					CPath cellPath = directory;
+					NCPath::Join(cellPath, NCPath::CreatePath(CellFilename(cell.X, cell.Y)));
+					cell.Filepath = cellPath.Path;
+					cell.Pinned = true;
+					iter = m_Cells.insert({ key, std::move(cell) }).first;
+				}
+
+				iter->second.Status = CellStatus::Resident;
+				success = WriteCell(scene, iter->second, entities) && success;
+			}
+
+			json index = {
+				{"CellSize", cellSize},
+				{"Cells", json::array()}
+			};
+			std::unordered_set<std::string> cellFiles;
+			m_OwnedEntities.clear();
+			for (const auto& [key, cell] : m_Cells)
+			{
+				std::string filename = CellFilename(cell.X, cell.Y);
+				index["Cells"].push_back({
+					{"X", cell.X},
+					{"Y", cell.Y},
+					{"File", filename}
+				});
+				cellFiles.insert(filename);
+				m_OwnedEntities.insert(cell.Entities.begin(), cell.Entities.end());
+			}
+
+			// Leftovers of emptied cells and of earlier builds
+			for (const CPath& file : File::GetFilesInDir(directory))
+			{
+				std::string filename = NCPath::Filename(file);
+				if (filename.rfind("cell_", 0) == 0 && cellFiles.find(filename) == cellFiles.end())
+				{
+					File::DeleteFile(file);
+				}
+			}
+
+			std::string indexBytes = index.dump(4);
+			CPath indexPath = directory;
+			NCPath::Join(indexPath, NCPath::CreatePath(INDEX_FILENAME));
+			if (!File::WriteFileAtomic((const uint8*)indexBytes.data(), (uint32)indexBytes.size(), indexPath))
+			{
+				Log::Warning("Failed to write world cell index %s", indexPath.Path.c_str());
+				success = false;
+			}
+
+			m_IndexHash = HashBytes(indexBytes);
+			m_Open = true;
+			return success;
+		}
+
+		bool Open(SceneData& scene, const CPath& sceneFile, uint64 indexHash)
+		{
+			if (m_Open)
+			{
+				Close(scene);
+			}
+
+			CPath directory = GetCellDirectory(sceneFile);
+			CPath indexPath = directory;
+			NCPath::Join(indexPath, NCPath::CreatePath(INDEX_FILENAME));
+			FileHandle* file = File::OpenFile(indexPath);
+			if (file->m_Size <= 0)
+			{
+				File::CloseFile(file);
+				Log::Warning("Scene %s was saved with world cells, but %s is missing.", sceneFile.Path.c_str(), indexPath.Path.c_str());
+				return false;
+			}
+
+			std::string indexBytes(file->m_Data, file->m_Size);
+			File::CloseFile(file);
+			if (HashBytes(indexBytes) != indexHash)
+			{
+				Log::Warning("World cells in %s were not written together with the scene, refusing to stream them.", directory.Path.c_str());
+				return false;
+			}
+
+			json index = json::parse(indexBytes, nullptr, false);
+			if (index.is_discarded() || !index.contains("Cells"))
+			{
+				Log::Warning("World cell index %s is not valid json", indexPath.Path.c_str());
+				return false;
+			}
+
+			m_CellSize = index["CellSize"];
+			for (const json& cellJson : index["Cells"])
+			{
+				Cell cell;
+				cell.X = cellJson["X"];
+				cell.Y = cellJson["Y"];
+				CPath cellPath = directory;
+				NCPath::Join(cellPath, NCPath::CreatePath(cellJson["File"].get<std::string>()));
+				cell.Filepath = cellPath.Path;
+				cell.Status = CellStatus::Unloaded;
+				cell.Pinned = false;
+				m_Cells[CellKey(cell.X, cell.Y)] = std::move(cell);
+			}
+
+			m_Directory = directory;
+			m_IndexHash = indexHash;
+			m_Open = true;
+			return true;
+		}
+
+		void Close(SceneData& scene)
+		{
+			CancelLoads();
+			for (auto& [key, cell] : m_Cells)
+			{
+				if (cell.Status == CellStatus::Resident)
+				{
+					RemoveFromScene(scene, cell);
+				}
+			}
+			m_Cells.clear();
+			m_OwnedEntities.clear();
+			m_IndexHash = 0;
+			m_Open = false;
+		}
+
+		void LoadAll(SceneData& scene)
+		{
+			CancelLoads();
+			for (auto& [key, cell] : m_Cells)
+			{
+				if (cell.Status != CellStatus::Resident)
+				{
+					LoadNow(scene, cell);
+				}
+			}
+		}
+
+		void Stop(SceneData& scene)
+		{
+			CancelLoads();
+			for (auto& [key, cell] : m_Cells)
+			{
+				if (cell.Status == CellStatus::Resident && !cell.Pinned)
+				{
+					RemoveFromScene(scene, cell);
+					cell.Status = CellStatus::Unloaded;
+				}
+			}
+		}
+
+		void Update(SceneData& scene)
+		{
+			if (!m_Open)
+			{
+				return;
+			}
+
+			for (int i = 0; i < Settings::Streaming::s_MaxCellsPerFrame; i++)
+			{
+				LoadedCell loaded;
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					if (m_Loaded.empty())
+					{
+						break;
+					}
+
+					loaded = std::move(m_Loaded.front());
+					m_Loaded.pop_front();
+				}
+
+				auto iter = m_Cells.find(loaded.Key);
+				if (loaded.Generation != m_Generation || iter == m_Cells.end() || iter->second.Status != CellStatus::Loading)
+				{
+					// The cell left the unload radius while it was being read
+					i--;
+					continue;
+				}
+
+				iter->second.Status = CellStatus::Resident;
+				iter->second.Pinned = !scene.IsPlaying;
+				if (!loaded.Success)
+				{
+					Log::Warning("Failed to load world cell %s", iter->second.Filepath.c_str());
+					continue;
+				}
+				AddToScene(scene, iter->second, loaded.Components);
+			}
+
+			const Camera& camera = scene.SceneCamera;
+			glm::vec2 halfView = camera.ProjectionSize * camera.Zoom * 0.5f;
+			glm::vec2 cameraPos = glm::vec2(camera.Transform.Position.x, camera.Transform.Position.y);
+			glm::ivec2 viewMin = glm::ivec2(glm::floor((cameraPos - halfView) / m_CellSize));
+			glm::ivec2 viewMax = glm::ivec2(glm::floor((cameraPos + halfView) / m_CellSize));
+
+			const int unloadRadius = Settings::Streaming::s_UnloadRadius;
+			for (auto& [key, cell] : m_Cells)
+			{
+				if (cell.Status == CellStatus::Unloaded || cell.Pinned ||
+					(cell.X >= viewMin.x - unloadRadius && cell.X <= viewMax.x + unloadRadius &&
+					cell.Y >= viewMin.y - unloadRadius && cell.Y <= viewMax.y + unloadRadius))
+				{
+					continue;
+				}
+
+				if (cell.Status == CellStatus::Resident)
+				{
+					RemoveFromScene(scene, cell);
+				}
+				cell.Status = CellStatus::Unloaded;
+			}
+
+			const int loadRadius = Settings::Streaming::s_LoadRadius;
+			for (int32 y = viewMin.y - loadRadius; y <= viewMax.y + loadRadius; y++)
+			{
+				for (int32 x = viewMin.x - loadRadius; x <= viewMax.x + loadRadius; x++)
+				{
+					uint64 key = CellKey(x, y);
+					auto iter = m_Cells.find(key);
+					if (iter != m_Cells.end() && iter->second.Status == CellStatus::Unloaded)
+					{
+						Queue(key, iter->second);
+					}
+				}
+			}
+		}
+
+		bool IsOpen()
+		{
+			return m_Open;
+		}
+
+		bool OwnsEntity(entt::entity entity)
+		{
+			return m_OwnedEntities.find(entity) != m_OwnedEntities.end();
+		}
+
+		uint64 GetIndexHash()
+		{
+			return m_IndexHash;
+		}
+
+		int NumResidentCells()
+		{
+			int numResident = 0;
+			for (const auto& [key, cell] : m_Cells)
+			{
+				if (cell.Status == CellStatus::Resident)
+				{
+					numResident++;
+				}
+			}
+
+			return numResident;
+		}
+
+		CPath GetCellDirectory(const CPath& sceneFile)
+		{
+			CPath directory = NCPath::CreatePath(NCPath::GetDirectory(sceneFile, -1));
+			NCPath::Join(directory, NCPath::CreatePath(NCPath::GetFilenameWithoutExt(sceneFile) + "_cells"));
+			return directory;
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static void WorkerLoop()
+		{
+			while (true)
+			{
+				LoadJob job;
+				{
+					std::unique_lock<std::mutex> lock(m_Mutex);
+					m_JobAvailable.wait(lock, [] { return !m_Jobs.empty() || !m_Running; });
+					if (!m_Running)
+					{
+						return;
+					}
+
+					job = std::move(m_Jobs.front());
+					m_Jobs.pop_front();
+				}
+
+				LoadedCell loaded;
+				loaded.Key = job.Key;
+				loaded.Generation = job.Generation;
+				loaded.Success = ReadCell(job.Filepath, loaded.Components);
+
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					if (job.Generation == m_Generation)
+					{
+						m_Loaded.push_back(std::move(loaded));
+					}
+				}
+			}
+		}
+
+		static bool ReadCell(const std::string& filepath, json& components)
+		{
+			// File::OpenFile allocates through the engine's allocator, which is main thread only
+			std::ifstream file(filepath, std::ios::binary);
+			std::vector<uint8> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			components = json::from_cbor(bytes, true, false);
+			return components.is_object() && components.contains("Components");
+		}
+
+		static uint64 CellKey(int32 x, int32 y)
+		{
+			return ((uint64)(uint32)x << 32) | (uint64)(uint32)y;
+		}
+
+		static std::string CellFilename(int32 x, int32 y)
+		{
+			return "cell_" + std::to_string(x) + "_" + std::to_string(y) + ".cbor";
+		}
+
+		static uint64 HashBytes(const std::string& bytes)
+		{
+			// 64 bit FNV-1a
+			uint64 hash = 14695981039346656037ull;
+			for (char c : bytes)
+			{
+				hash ^= (uint8)c;
+				hash *= 1099511628211ull;
+			}
+			return hash;
+		}
+
+		static void CancelLoads()
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Generation++;
+				m_Jobs.clear();
+				m_Loaded.clear();
+			}
+
+			for (auto& [key, cell] : m_Cells)
+			{
+				if (cell.Status == CellStatus::Loading)
+				{
+					cell.Status = CellStatus::Unloaded;
+				}
+			}
+		}
+
+		static void Queue(uint64 key, Cell& cell)
+		{
+			cell.Status = CellStatus::Loading;
+			{
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				m_Jobs.push_back({ key, cell.Filepath, m_Generation });
+			}
+			m_JobAvailable.notify_one();
+		}
+
+		static void LoadNow(SceneData& scene, Cell& cell)
+		{
+			json components;
+			cell.Status = CellStatus::Resident;
+			cell.Pinned = !scene.IsPlaying;
+			if (!ReadCell(cell.Filepath, components))
+			{
+				Log::Warning("Failed to load world cell %s", cell.Filepath.c_str());
+				return;
+			}
+			AddToScene(scene, cell, components);
+		}
+
+		static bool WriteCell(SceneData& scene, Cell& cell, const std::vector<entt::entity>& entities)
+		{
+			// The serializers write whole registries, so the cell is copied into its own scratch scene. Created from hints
+			// the copies keep the original entity ids
+			SceneData cellScene;
+			cellScene.IsPlaying = false;
+			std::vector<Entity> sceneEntities;
+			sceneEntities.reserve(entities.size());
+			for (entt::entity entity : entities)
+			{
+				entt::entity copy = cellScene.Registry.create(entity);
+				ComponentSerializer::CopyComponents(Entity{ entity, &scene }, Entity{ copy, &cellScene });
+				sceneEntities.push_back(Entity{ entity, &scene });
+			}
+
+			json components = {
+				{"Components", json::array()},
+				{"Assets", AssetTable::Serialize(sceneEntities.data(), (int)sceneEntities.size())}
+			};
+			for (const ComponentSerializerEntry& entry : ComponentSerializer::GetEntries())
+			{
+				if (entry.SerializeAll)
+				{
+					entry.SerializeAll(components, cellScene);
+				}
+			}
+
+			cell.Entities = entities;
+			std::vector<uint8> bytes = json::to_cbor(components);
+			if (!File::WriteFileAtomic(bytes.data(), (uint32)bytes.size(), NCPath::CreatePath(cell.Filepath)))
+			{
+				Log::Warning("Failed to write world cell %s", cell.Filepath.c_str());
+				return false;
+			}
+
+			return true;
+		}
+
+		static void AddToScene(SceneData& scene, Cell& cell, json& components)
+		{
+			// Cells are loaded into whatever the scene's asset table looks like at the time, so they bring their own
+			AssetRemap remap;
+			if (components.contains("Assets"))
+			{
+				AssetTable::Resolve(components["Assets"], remap);
+			}
+
+			std::unordered_map<uint32, entt::entity> entities;
+			for (json& component : components["Components"])
+			{
+				json::iterator it = component.begin();
+				if (it == component.end() || !it.value().contains("Entity"))
+				{
+					continue;
+				}
+
+				uint32 id = it.value()["Entity"];
+				auto entityIter = entities.find(id);
+				if (entityIter == entities.end())
+				{
+					// Keeps the written id when it's free, which it is unless something else took it since
+					entityIter = entities.insert({ id, scene.Registry.create(entt::entity(id)) }).first;
+					cell.Entities.push_back(entityIter->second);
+					m_OwnedEntities.insert(entityIter->second);
+				}
+
+				const ComponentSerializerEntry* entry = ComponentSerializer::Find(it.key());
+				if (entry && entry->Deserialize)
+				{
+					Entity entity = Entity{ entityIter->second, &scene };
+					entry->Deserialize(component, entity);
+					AssetTable::Remap(component, entity, remap);
+				}
+			}
+		}
+
+		static void RemoveFromScene(SceneData& scene, Cell& cell)
+		{
+			for (entt::entity entity : cell.Entities)
+			{
+				// Gameplay may have destroyed some of them already
+				if (scene.Registry.valid(entity))
+				{
+					scene.Registry.destroy(entity);
+				}
+				m_OwnedEntities.erase(entity);
+			}
+			cell.Entities.clear();
+		}
+	}
+}
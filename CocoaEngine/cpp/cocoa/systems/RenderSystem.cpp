@@ -7,6 +7,10 @@
 #include "cocoa/commands/ICommand.h"
 #include "cocoa/util/CMath.h"
 #include "cocoa/util/DynamicArray.h"
+#include "cocoa/renderer/TextureStreamer.h"
+#include "cocoa/renderer/TextureAtlas.h"
+#include "cocoa/physics2d/Physics2D.h"
+#include "cocoa/scenes/SpatialIndex.h"
 
 #include <nlohmann/json.hpp>
 
@@ -24,6 +28,14 @@ namespace Cocoa
 
 		static DynamicArray<RenderBatchData> m_Batches;
 		static Camera* m_Camera;
+		static std::vector<entt::entity> m_VisibleEntities;
+
+		// Indexed by entity index, holds the entity while it is in m_VisibleEntities and entt::null otherwise
+		static std::vector<entt::entity> m_VisibleSlots;
+
+		// Forward Declarations
+		static void ReportTextureUsage(const TransformData& transform, const SpriteRenderer& spr);
+		static void AddVisibleSprites(const SceneData& scene);
 
 		void Init(SceneData& scene)
 		{
@@ -58,6 +70,8 @@ namespace Cocoa
 			CPath pickingShaderPath = Settings::General::s_EngineAssetsPath;
 			NCPath::Join(pickingShaderPath, NCPath::CreatePath("shaders/Picking.glsl"));
 			AssetManager::LoadShaderFromFile(pickingShaderPath, true);
+
+			TextCache::Init(m_FontShader);
 		}
 
 		void Destroy()
@@ -69,11 +83,26 @@ namespace Cocoa
 				RenderBatch::Free(data);
 			}
 			NDynamicArray::Free<RenderBatchData>(m_Batches);
+			TextCache::Destroy();
 		}
 
 		void AddEntity(const TransformData& transform, const SpriteRenderer& spr)
 		{
-			const Sprite& sprite = spr.m_Sprite;
+			AddEntity(transform, spr, transform.Position, transform.EulerRotation.z);
+		}
+
+		void AddEntity(const TransformData& transform, const SpriteRenderer& spr, const glm::vec3& position, float rotationDegrees)
+		{
+			if (spr.m_Sprite.m_Texture)
+			{
+				ReportTextureUsage(transform, spr);
+			}
+
+			// Packed textures draw from their atlas page, so sprites with different source images still share a batch
+			SpriteRenderer atlasSprite = spr;
+			atlasSprite.m_Sprite.m_Texture = TextureAtlas::Resolve(spr.m_Sprite.m_Texture, atlasSprite.m_Sprite.m_TexCoords);
+			const Sprite& sprite = atlasSprite.m_Sprite;
+
 			bool wasAdded = false;
 			for (int i=0; i < m_Batches.m_NumElements; i++)
 			{
@@ -83,7 +112,7 @@ namespace Cocoa
 					Handle<Texture> tex = sprite.m_Texture;
 					if (!tex || RenderBatch::HasTexture(batch, tex) || RenderBatch::HasTextureRoom(batch))
 					{
-						RenderBatch::Add(batch, transform, spr);
+						RenderBatch::Add(batch, transform, atlasSprite, position, rotationDegrees);
 						wasAdded = true;
 						break;
 					}
@@ -94,15 +123,52 @@ namespace Cocoa
 			{
 				RenderBatchData newBatch = RenderBatch::CreateRenderBatch(MAX_BATCH_SIZE, spr.m_ZIndex, m_SpriteShader);
 				RenderBatch::Start(newBatch);
-				RenderBatch::Add(newBatch, transform, spr);
+				RenderBatch::Add(newBatch, transform, atlasSprite, position, rotationDegrees);
 				NDynamicArray::Add(m_Batches, newBatch);
 				std::sort(NDynamicArray::Begin<RenderBatchData>(m_Batches), NDynamicArray::End<RenderBatchData>(m_Batches), RenderBatch::Compare);
 			}
 		}
 
+		static void AddCachedText(const TransformData& transform, const FontRenderer& fontRenderer)
+		{
+			Entity entity = NEntity::FromComponent<TransformData>(transform);
+			const CachedText& cachedText = TextCache::Get(entity.Handle, transform, fontRenderer);
+
+			// Cached text is just a textured quad, so it can share batches with sprites
+			bool wasAdded = false;
+			for (int i = 0; i < m_Batches.m_NumElements; i++)
+			{
+				RenderBatchData& batch = NDynamicArray::Get<RenderBatchData>(m_Batches, i);
+				if (RenderBatch::HasRoom(batch) && fontRenderer.m_ZIndex == batch.ZIndex && batch.BatchShader == m_SpriteShader)
+				{
+					if (RenderBatch::HasTexture(batch, cachedText.TextureHandle) || RenderBatch::HasTextureRoom(batch))
+					{
+						RenderBatch::Add(batch, transform, fontRenderer, cachedText);
+						wasAdded = true;
+						break;
+					}
+				}
+			}
+
+			if (!wasAdded)
+			{
+				RenderBatchData newBatch = RenderBatch::CreateRenderBatch(MAX_BATCH_SIZE, fontRenderer.m_ZIndex, m_SpriteShader);
+				RenderBatch::Start(newBatch);
+				RenderBatch::Add(newBatch, transform, fontRenderer, cachedText);
+				NDynamicArray::Add<RenderBatchData>(m_Batches, newBatch);
+				std::sort(NDynamicArray::Begin<RenderBatchData>(m_Batches), NDynamicArray::End<RenderBatchData>(m_Batches), RenderBatch::Compare);
+			}
+		}
+
 		void AddEntity(const TransformData& transform, const FontRenderer& fontRenderer)
 		{
-			const Font& font = AssetManager::GetFont(fontRenderer.m_Font.m_AssetId);
+			if (fontRenderer.m_Cached)
+			{
+				AddCachedText(transform, fontRenderer);
+				return;
+			}
+
+			const Font& font = AssetManager::GetFont(fontRenderer.m_Font);
 			bool wasAdded = false;
 			for (int i=0; i < m_Batches.m_NumElements; i++)
 			{
@@ -131,10 +197,30 @@ namespace Cocoa
 
 		void Render(const SceneData& scene)
 		{
-			scene.Registry.group<const SpriteRenderer>(entt::get<const TransformData>).each([](auto entity, auto& spr, auto& transform)
-				{
-					AddEntity(transform, spr);
-				});
+			// Physics runs at a fixed rate, so bodies are drawn between their last two steps to keep motion smooth
+			const bool interpolate = scene.IsPlaying && Physics2D::GetInterpolationAlpha() < 1.0f;
+			if (!scene.IsPlaying && SpatialIndex::IsActive())
+			{
+				AddVisibleSprites(scene);
+			}
+			else
+			{
+				scene.Registry.group<const SpriteRenderer>(entt::get<const TransformData>).each([&scene, interpolate](auto entity, auto& spr, auto& transform)
+					{
+						const Rigidbody2D* rb = interpolate ? scene.Registry.try_get<Rigidbody2D>(entity) : nullptr;
+						if (rb && rb->m_RawRigidbody)
+						{
+							glm::vec3 position;
+							float rotation;
+							Physics2D::GetInterpolatedPose(transform, *rb, position, rotation);
+							AddEntity(transform, spr, position, rotation);
+						}
+						else
+						{
+							AddEntity(transform, spr);
+						}
+					});
+			}
 
 			scene.Registry.group<const FontRenderer>(entt::get<const TransformData>).each([](auto entity, const auto& fontRenderer, const auto& transform)
 				{
@@ -145,7 +231,7 @@ namespace Cocoa
 			{
 				RenderBatchData& batch = NDynamicArray::Get<RenderBatchData>(m_Batches, i);
 				Log::Assert(!batch.BatchShader.IsNull(), "Cannot render with a null shader.");
-				const Shader& shader = AssetManager::GetShader(batch.BatchShader.m_AssetId);
+				const Shader& shader = AssetManager::GetShader(batch.BatchShader);
 				NShader::Bind(shader);
 				NShader::UploadMat4(shader, "uProjection", m_Camera->ProjectionMatrix);
 				NShader::UploadMat4(shader, "uView", m_Camera->ViewMatrix);
@@ -154,6 +240,64 @@ namespace Cocoa
 				RenderBatch::Render(batch);
 				RenderBatch::Clear(batch);
 			}
+
+			TextCache::EndFrame();
+			TextureStreamer::Update();
+		}
+
+		static void AddVisibleSprites(const SceneData& scene)
+		{
+			// In the editor only sprites the spatial index finds in the camera's view are batched
+			const Camera& camera = scene.SceneCamera;
+			glm::vec2 halfView = camera.ProjectionSize * camera.Zoom * 0.5f;
+			glm::vec2 cameraPos = glm::vec2(camera.Transform.Position.x, camera.Transform.Position.y);
+			m_VisibleEntities.clear();
+			SpatialIndex::QueryBox(cameraPos - halfView, cameraPos + halfView, m_VisibleEntities);
+
+			for (entt::entity entity : m_VisibleEntities)
+			{
+				uint32 index = entt::to_integral(entity) & entt::entt_traits<entt::entity>::entity_mask;
+				if (index >= m_VisibleSlots.size())
+				{
+					m_VisibleSlots.resize(index + 1, entt::null);
+				}
+				m_VisibleSlots[index] = entity;
+			}
+
+			// Sprites on the same z index draw in the order they're added. Walking the group and skipping what isn't
+			// visible keeps the order play mode uses, the query's order depends on the tree's layout
+			scene.Registry.group<const SpriteRenderer>(entt::get<const TransformData>).each([](auto entity, auto& spr, auto& transform)
+				{
+					uint32 index = entt::to_integral(entity) & entt::entt_traits<entt::entity>::entity_mask;
+					if (index < m_VisibleSlots.size() && m_VisibleSlots[index] == entity)
+					{
+						AddEntity(transform, spr);
+					}
+				});
+
+			for (entt::entity entity : m_VisibleEntities)
+			{
+				m_VisibleSlots[entt::to_integral(entity) & entt::entt_traits<entt::entity>::entity_mask] = entt::null;
+			}
+		}
+
+		static void ReportTextureUsage(const TransformData& transform, const SpriteRenderer& spr)
+		{
+			// Size the sprite covers in the main framebuffer, scaled up to what the whole texture would cover
+			const Sprite& sprite = spr.m_Sprite;
+			glm::vec2 pixelsPerUnit = glm::vec2((float)m_MainFramebuffer.Width, (float)m_MainFramebuffer.Height) / (m_Camera->ProjectionSize * m_Camera->Zoom);
+			glm::vec2 screenSize = glm::abs(glm::vec2(sprite.m_Width * transform.Scale.x, sprite.m_Height * transform.Scale.y)) * pixelsPerUnit;
+
+			glm::vec2 minTexCoord = sprite.m_TexCoords[0];
+			glm::vec2 maxTexCoord = sprite.m_TexCoords[0];
+			for (int i = 1; i < 4; i++)
+			{
+				minTexCoord = glm::min(minTexCoord, sprite.m_TexCoords[i]);
+				maxTexCoord = glm::max(maxTexCoord, sprite.m_TexCoords[i]);
+			}
+			glm::vec2 texCoordSize = glm::max(maxTexCoord - minTexCoord, glm::vec2(0.0001f));
+
+			TextureStreamer::ReportUsage(sprite.m_Texture, screenSize / texCoordSize);
 		}
 
 		const Framebuffer& GetMainFramebuffer()
@@ -168,7 +312,7 @@ namespace Cocoa
 			json zIndex = { "ZIndex", spriteRenderer.m_ZIndex };
 			if (spriteRenderer.m_Sprite.m_Texture)
 			{
-				assetId = { "AssetId", spriteRenderer.m_Sprite.m_Texture.m_AssetId };
+				assetId = { "AssetId", AssetManager::GetResourceId(spriteRenderer.m_Sprite.m_Texture) };
 			}
 
 			int size = j["Components"].size();
@@ -190,7 +334,7 @@ namespace Cocoa
 			{
 				if (j["SpriteRenderer"]["AssetId"] != std::numeric_limits<uint32>::max())
 				{
-					spriteRenderer.m_Sprite.m_Texture = Handle<Texture>(j["SpriteRenderer"]["AssetId"]);
+					spriteRenderer.m_Sprite.m_Texture = AssetManager::GetSceneTexture(j["SpriteRenderer"]["AssetId"]);
 				}
 			}
 
@@ -208,9 +352,10 @@ namespace Cocoa
 			json zIndex = { "ZIndex", fontRenderer.m_ZIndex };
 			json text = { "Text", fontRenderer.text };
 			json fontSize = { "FontSize", fontRenderer.fontSize };
+			json cached = { "Cached", fontRenderer.m_Cached };
 			if (fontRenderer.m_Font)
 			{
-				assetId = { "AssetId", fontRenderer.m_Font.m_AssetId };
+				assetId = { "AssetId", AssetManager::GetResourceId(fontRenderer.m_Font) };
 			}
 
 			int size = j["Components"].size();
@@ -221,7 +366,8 @@ namespace Cocoa
 					zIndex,
 					color,
 					text,
-					fontSize
+					fontSize,
+					cached
 				}}
 			};
 		}
@@ -234,7 +380,7 @@ namespace Cocoa
 			{
 				if (j["FontRenderer"]["AssetId"] != std::numeric_limits<uint32>::max())
 				{
-					fontRenderer.m_Font = Handle<Font>(j["FontRenderer"]["AssetId"]);
+					fontRenderer.m_Font = AssetManager::GetSceneFont(j["FontRenderer"]["AssetId"]);
 				}
 			}
 
@@ -252,6 +398,11 @@ namespace Cocoa
 			{
 				fontRenderer.fontSize = j["FontRenderer"]["FontSize"];
 			}
+
+			if (j["FontRenderer"].contains("Cached"))
+			{
+				fontRenderer.m_Cached = j["FontRenderer"]["Cached"];
+			}
 			NEntity::AddComponent<FontRenderer>(entity, fontRenderer);
 		}
 	}
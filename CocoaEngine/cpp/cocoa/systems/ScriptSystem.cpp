@@ -1,6 +1,7 @@
 #include "cocoa/systems/ScriptSystem.h"
 #include "cocoa/file/File.h"
 #include "cocoa/util/Settings.h"
+#include "cocoa/scenes/ComponentSerializer.h"
 
 #ifdef _WIN32
 #include <windows.h>
@@ -118,6 +119,7 @@ namespace Cocoa
 			m_InitScripts = InitScriptsStub;
 			m_InitImGui = InitImGuiStub;
 			m_ImGui = ImGuiStub;
+			ComponentSerializer::UnregisterScripts();
 
 			if (!FreeLibrary(m_Module))
 			{
@@ -131,6 +133,14 @@ namespace Cocoa
 			return true;
 		}
 
+		void ClearScripts()
+		{
+			if (m_DeleteScripts)
+			{
+				m_DeleteScripts();
+			}
+		}
+
 		void ImGui(Entity entity)
 		{
 			if (m_ImGui)
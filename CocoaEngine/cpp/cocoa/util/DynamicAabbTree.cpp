@@ -0,0 +1,342 @@
+#include "cocoa/util/DynamicAabbTree.h"
+#include "cocoa/util/Log.h"
+#include "cocoa/util/CMath.h"
+
+namespace Cocoa
+{
+	namespace NDynamicAabbTree
+	{
+		// Internal Variables
+		// The tree stays balanced, so even millions of leaves are nowhere near this deep
+		static const int MAX_QUERY_STACK = 128;
+
+		// Forward Declarations
+		static int32 AllocateNode(DynamicAabbTree& tree);
+		static void FreeNode(DynamicAabbTree& tree, int32 index);
+		static void InsertLeaf(DynamicAabbTree& tree, int32 leaf);
+		static void RemoveLeaf(DynamicAabbTree& tree, int32 leaf);
+		static int32 Balance(DynamicAabbTree& tree, int32 index);
+		static void Refit(DynamicAabbTree& tree, int32 index);
+		static float DescendCost(const DynamicAabbTree& tree, int32 child, const glm::vec2& leafMin, const glm::vec2& leafMax);
+		static float Perimeter(const glm::vec2& min, const glm::vec2& max);
+
+		DynamicAabbTree Create(float margin)
+		{
+			DynamicAabbTree tree;
+			tree.Margin = margin;
+			return tree;
+		}
+
+		void Clear(DynamicAabbTree& tree)
+		{
+			tree.Nodes.clear();
+			tree.Root = -1;
+			tree.FreeList = -1;
+			tree.NumLeaves = 0;
+		}
+
+		int32 Insert(DynamicAabbTree& tree, const glm::vec2& min, const glm::vec2& max, uint32 userData)
+		{
+			int32 leaf = AllocateNode(tree);
+			AabbTreeNode& node = tree.Nodes[leaf];
+			node.Min = min - glm::vec2(tree.Margin);
+			node.Max = max + glm::vec2(tree.Margin);
+			node.UserData = userData;
+			node.Height = 0;
+
+			InsertLeaf(tree, leaf);
+			tree.NumLeaves++;
+			return leaf;
+		}
+
+		void Remove(DynamicAabbTree& tree, int32 proxy)
+		{
+			Log::Assert(proxy >= 0 && proxy < (int32)tree.Nodes.size() && tree.Nodes[proxy].Height == 0, "Tried to remove an invalid proxy from an AABB tree.");
+			RemoveLeaf(tree, proxy);
+			FreeNode(tree, proxy);
+			tree.NumLeaves--;
+		}
+
+		bool Move(DynamicAabbTree& tree, int32 proxy, const glm::vec2& min, const glm::vec2& max)
+		{
+			Log::Assert(proxy >= 0 && proxy < (int32)tree.Nodes.size() && tree.Nodes[proxy].Height == 0, "Tried to move an invalid proxy in an AABB tree.");
+			const AabbTreeNode& node = tree.Nodes[proxy];
+			if (node.Min.x <= min.x && node.Min.y <= min.y && max.x <= node.Max.x && max.y <= node.Max.y)
+			{
+				return false;
+			}
+
+			RemoveLeaf(tree, proxy);
+			tree.Nodes[proxy].Min = min - glm::vec2(tree.Margin);
+			tree.Nodes[proxy].Max = max + glm::vec2(tree.Margin);
+			InsertLeaf(tree, proxy);
+			return true;
+		}
+
+		uint32 GetUserData(const DynamicAabbTree& tree, int32 proxy)
+		{
+			return tree.Nodes[proxy].UserData;
+		}
+
+		void Query(const DynamicAabbTree& tree, const glm::vec2& min, const glm::vec2& max, std::vector<int32>& proxies)
+		{
+			if (tree.Root == -1)
+			{
+				return;
+			}
+
+			int32 stack[MAX_QUERY_STACK];
+			int stackSize = 0;
+			stack[stackSize++] = tree.Root;
+			while (stackSize > 0)
+			{
+				int32 index = stack[--stackSize];
+				const AabbTreeNode& node = tree.Nodes[index];
+				if (node.Max.x < min.x || node.Max.y < min.y || node.Min.x > max.x || node.Min.y > max.y)
+				{
+					continue;
+				}
+
+				if (node.Height == 0)
+				{
+					proxies.push_back(index);
+				}
+				else
+				{
+					Log::Assert(stackSize + 2 <= MAX_QUERY_STACK, "AABB tree is too deep to query.");
+					stack[stackSize++] = node.Left;
+					stack[stackSize++] = node.Right;
+				}
+			}
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static int32 AllocateNode(DynamicAabbTree& tree)
+		{
+			int32 index;
+			if (tree.FreeList == -1)
+			{
+				index = (int32)tree.Nodes.size();
+				tree.Nodes.emplace_back();
+			}
+			else
+			{
+				index = tree.FreeList;
+				tree.FreeList = tree.Nodes[index].Parent;
+			}
+
+			AabbTreeNode& node = tree.Nodes[index];
+			node.UserData = 0;
+			node.Parent = -1;
+			node.Left = -1;
+			node.Right = -1;
+			node.Height = 0;
+			return index;
+		}
+
+		static void FreeNode(DynamicAabbTree& tree, int32 index)
+		{
+			tree.Nodes[index].Parent = tree.FreeList;
+			tree.Nodes[index].Height = -1;
+			tree.FreeList = index;
+		}
+
+		static void InsertLeaf(DynamicAabbTree& tree, int32 leaf)
+		{
+			if (tree.Root == -1)
+			{
+				tree.Root = leaf;
+				tree.Nodes[leaf].Parent = -1;
+				return;
+			}
+
+			// Walk down to the sibling that makes the tree's total perimeter grow the least
+			const glm::vec2 leafMin = tree.Nodes[leaf].Min;
+			const glm::vec2 leafMax = tree.Nodes[leaf].Max;
+			int32 index = tree.Root;
+			while (tree.Nodes[index].Height > 0)
+			{
+				const AabbTreeNode& node = tree.Nodes[index];
+				float perimeter = Perimeter(node.Min, node.Max);
+				float combinedPerimeter = Perimeter(glm::min(node.Min, leafMin), glm::max(node.Max, leafMax));
+
+				// Cost of pairing the leaf with this node, versus pushing it further down which grows this node anyway
+				float cost = 2.0f * combinedPerimeter;
+				float inheritedCost = 2.0f * (combinedPerimeter - perimeter);
+				float leftCost = DescendCost(tree, node.Left, leafMin, leafMax) + inheritedCost;
+				float rightCost = DescendCost(tree, node.Right, leafMin, leafMax) + inheritedCost;
+				if (cost < leftCost && cost < rightCost)
+				{
+					break;
+				}
+
+				index = leftCost < rightCost ? node.Left : node.Right;
+			}
+
+			int32 sibling = index;
+			int32 oldParent = tree.Nodes[sibling].Parent;
+			int32 newParent = AllocateNode(tree);
+			AabbTreeNode& parent = tree.Nodes[newParent];
+			parent.Parent = oldParent;
+			parent.Min = glm::min(leafMin, tree.Nodes[sibling].Min);
+			parent.Max = glm::max(leafMax, tree.Nodes[sibling].Max);
+			parent.Height = tree.Nodes[sibling].Height + 1;
+			parent.Left = sibling;
+			parent.Right = leaf;
+			tree.Nodes[sibling].Parent = newParent;
+			tree.Nodes[leaf].Parent = newParent;
+
+			if (oldParent == -1)
+			{
+				tree.Root = newParent;
+			}
+			else if (tree.Nodes[oldParent].Left == sibling)
+			{
+				tree.Nodes[oldParent].Left = newParent;
+			}
+			else
+			{
+				tree.Nodes[oldParent].Right = newParent;
+			}
+
+			Refit(tree, tree.Nodes[leaf].Parent);
+		}
+
+		static void RemoveLeaf(DynamicAabbTree& tree, int32 leaf)
+		{
+			if (leaf == tree.Root)
+			{
+				tree.Root = -1;
+				return;
+			}
+
+			int32 parent = tree.Nodes[leaf].Parent;
+			int32 grandParent = tree.Nodes[parent].Parent;
+			int32 sibling = tree.Nodes[parent].Left == leaf ? tree.Nodes[parent].Right : tree.Nodes[parent].Left;
+
+			// The sibling takes the parent's place
+			tree.Nodes[sibling].Parent = grandParent;
+			FreeNode(tree, parent);
+			if (grandParent == -1)
+			{
+				tree.Root = sibling;
+				return;
+			}
+
+			if (tree.Nodes[grandParent].Left == parent)
+			{
+				tree.Nodes[grandParent].Left = sibling;
+			}
+			else
+			{
+				tree.Nodes[grandParent].Right = sibling;
+			}
+			Refit(tree, grandParent);
+		}
+
+		static void Refit(DynamicAabbTree& tree, int32 index)
+		{
+			// Rebalances and recomputes the boxes and heights of every node from index up to the root
+			while (index != -1)
+			{
+				index = Balance(tree, index);
+				AabbTreeNode& node = tree.Nodes[index];
+				const AabbTreeNode& left = tree.Nodes[node.Left];
+				const AabbTreeNode& right = tree.Nodes[node.Right];
+				node.Height = 1 + CMath::Max(left.Height, right.Height);
+				node.Min = glm::min(left.Min, right.Min);
+				node.Max = glm::max(left.Max, right.Max);
+				index = node.Parent;
+			}
+		}
+
+		static int32 Balance(DynamicAabbTree& tree, int32 index)
+		{
+			// Rotates the taller child up when the two subtrees differ in height by more than one
+			AabbTreeNode& a = tree.Nodes[index];
+			if (a.Height < 2)
+			{
+				return index;
+			}
+
+			int32 indexB = a.Left;
+			int32 indexC = a.Right;
+			AabbTreeNode& b = tree.Nodes[indexB];
+			AabbTreeNode& c = tree.Nodes[indexC];
+			int32 balance = c.Height - b.Height;
+			if (balance >= -1 && balance <= 1)
+			{
+				return index;
+			}
+
+			// Whichever child moves up takes a's place under a's parent, and a keeps the taller of its grandchildren
+			bool rotateRight = balance > 1;
+			int32 indexUp = rotateRight ? indexC : indexB;
+			AabbTreeNode& up = rotateRight ? c : b;
+			AabbTreeNode& stays = rotateRight ? b : c;
+			int32 indexF = up.Left;
+			int32 indexG = up.Right;
+			AabbTreeNode& f = tree.Nodes[indexF];
+			AabbTreeNode& g = tree.Nodes[indexG];
+
+			up.Left = index;
+			up.Parent = a.Parent;
+			a.Parent = indexUp;
+			if (up.Parent == -1)
+			{
+				tree.Root = indexUp;
+			}
+			else if (tree.Nodes[up.Parent].Left == index)
+			{
+				tree.Nodes[up.Parent].Left = indexUp;
+			}
+			else
+			{
+				tree.Nodes[up.Parent].Right = indexUp;
+			}
+
+			int32 indexKept = f.Height > g.Height ? indexF : indexG;
+			int32 indexMoved = f.Height > g.Height ? indexG : indexF;
+			AabbTreeNode& kept = tree.Nodes[indexKept];
+			AabbTreeNode& moved = tree.Nodes[indexMoved];
+			up.Right = indexKept;
+			if (rotateRight)
+			{
+				a.Right = indexMoved;
+			}
+			else
+			{
+				a.Left = indexMoved;
+			}
+			moved.Parent = index;
+
+			a.Min = glm::min(stays.Min, moved.Min);
+			a.Max = glm::max(stays.Max, moved.Max);
+			a.Height = 1 + CMath::Max(stays.Height, moved.Height);
+			up.Min = glm::min(a.Min, kept.Min);
+			up.Max = glm::max(a.Max, kept.Max);
+			up.Height = 1 + CMath::Max(a.Height, kept.Height);
+			return indexUp;
+		}
+
+		static float DescendCost(const DynamicAabbTree& tree, int32 child, const glm::vec2& leafMin, const glm::vec2& leafMax)
+		{
+			const AabbTreeNode& node = tree.Nodes[child];
+			float combinedPerimeter = Perimeter(glm::min(node.Min, leafMin), glm::max(node.Max, leafMax));
+			if (node.Height == 0)
+			{
+				return combinedPerimeter;
+			}
+
+			// Going past an internal node only costs what it grows by
+			return combinedPerimeter - Perimeter(node.Min, node.Max);
+		}
+
+		static float Perimeter(const glm::vec2& min, const glm::vec2& max)
+		{
+			return 2.0f * ((max.x - min.x) + (max.y - min.y));
+		}
+	}
+}
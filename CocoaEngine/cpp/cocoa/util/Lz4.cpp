@@ -0,0 +1,230 @@
+#include "cocoa/util/Lz4.h"
+
+namespace Cocoa
+{
+	namespace Lz4
+	{
+		// Internal Variables
+		static const int MIN_MATCH = 4;
+		static const int LAST_LITERALS = 5;
+		static const int MATCH_FIND_LIMIT = 12;
+		static const int MAX_OFFSET = 65535;
+		static const int HASH_BITS = 16;
+
+		// Forward Declarations
+		static uint32 Read32(const uint8* data);
+		static uint32 HashSequence(uint32 sequence);
+		static bool WriteLength(uint8*& op, const uint8* opEnd, int length);
+		static bool WriteSequence(uint8*& op, const uint8* opEnd, const uint8* literals, int literalLength, int offset, int matchLength);
+		static bool ReadLength(const uint8*& ip, const uint8* ipEnd, size_t& length);
+
+		int CompressBound(int srcSize)
+		{
+			return srcSize + srcSize / 255 + 16;
+		}
+
+		int Compress(const uint8* src, int srcSize, uint8* dst, int dstCapacity)
+		{
+			uint8* op = dst;
+			const uint8* opEnd = dst + dstCapacity;
+			int anchor = 0;
+
+			// The format requires the last match to start 12 bytes before the end and end 5 bytes before it
+			if (srcSize >= MATCH_FIND_LIMIT)
+			{
+				std::vector<int> hashTable(1 << HASH_BITS, -1);
+				int matchLimit = srcSize - LAST_LITERALS;
+				int ip = 0;
+				while (ip <= srcSize - MATCH_FIND_LIMIT)
+				{
+					uint32 sequence = Read32(src + ip);
+					uint32 hash = HashSequence(sequence);
+					int ref = hashTable[hash];
+					hashTable[hash] = ip;
+					if (ref < 0 || ip - ref > MAX_OFFSET || Read32(src + ref) != sequence)
+					{
+						ip++;
+						continue;
+					}
+
+					int matchLength = MIN_MATCH;
+					while (ip + matchLength < matchLimit && src[ref + matchLength] == src[ip + matchLength])
+					{
+						matchLength++;
+					}
+
+					if (!WriteSequence(op, opEnd, src + anchor, ip - anchor, ip - ref, matchLength))
+					{
+						return 0;
+					}
+
+					ip += matchLength;
+					anchor = ip;
+				}
+			}
+
+			// Whatever is left goes out as a literal only sequence
+			if (!WriteSequence(op, opEnd, src + anchor, srcSize - anchor, 0, 0))
+			{
+				return 0;
+			}
+
+			return (int)(op - dst);
+		}
+
+		int Decompress(const uint8* src, int srcSize, uint8* dst, int dstSize)
+		{
+			const uint8* ip = src;
+			const uint8* ipEnd = src + srcSize;
+			uint8* op = dst;
+			uint8* opEnd = dst + dstSize;
+
+			while (ip < ipEnd)
+			{
+				uint8 token = *ip++;
+				size_t literalLength = token >> 4;
+				if (literalLength == 15 && !ReadLength(ip, ipEnd, literalLength))
+				{
+					return -1;
+				}
+
+				if ((size_t)(ipEnd - ip) < literalLength || (size_t)(opEnd - op) < literalLength)
+				{
+					return -1;
+				}
+				memcpy(op, ip, literalLength);
+				op += literalLength;
+				ip += literalLength;
+
+				// The last sequence has no match
+				if (ip == ipEnd)
+				{
+					break;
+				}
+
+				if (ipEnd - ip < 2)
+				{
+					return -1;
+				}
+				size_t offset = (size_t)ip[0] | ((size_t)ip[1] << 8);
+				ip += 2;
+				if (offset == 0 || offset > (size_t)(op - dst))
+				{
+					return -1;
+				}
+
+				size_t matchLength = token & 15;
+				if (matchLength == 15 && !ReadLength(ip, ipEnd, matchLength))
+				{
+					return -1;
+				}
+				matchLength += MIN_MATCH;
+				if ((size_t)(opEnd - op) < matchLength)
+				{
+					return -1;
+				}
+
+				// Matches can overlap the bytes they produce, so this has to go one byte at a time
+				const uint8* match = op - offset;
+				for (size_t i = 0; i < matchLength; i++)
+				{
+					op[i] = match[i];
+				}
+				op += matchLength;
+			}
+
+			return (int)(op - dst);
+		}
+
+		// ---------------------------------------------------------------------
+		// Internal functions
+		// ---------------------------------------------------------------------
+		static uint32 Read32(const uint8* data)
+		{
+			uint32 result;
+			memcpy(&result, data, sizeof(uint32));
+			return result;
+		}
+
+		static uint32 HashSequence(uint32 sequence)
+		{
+			return (sequence * 2654435761u) >> (32 - HASH_BITS);
+		}
+
+		static bool WriteLength(uint8*& op, const uint8* opEnd, int length)
+		{
+			// Lengths of 15 or more continue in extra bytes after the token
+			length -= 15;
+			while (length >= 255)
+			{
+				if (op >= opEnd)
+				{
+					return false;
+				}
+				*op++ = 255;
+				length -= 255;
+			}
+
+			if (op >= opEnd)
+			{
+				return false;
+			}
+			*op++ = (uint8)length;
+			return true;
+		}
+
+		static bool WriteSequence(uint8*& op, const uint8* opEnd, const uint8* literals, int literalLength, int offset, int matchLength)
+		{
+			if (op >= opEnd)
+			{
+				return false;
+			}
+
+			uint8* token = op++;
+			*token = (uint8)((literalLength >= 15 ? 15 : literalLength) << 4);
+			if (literalLength >= 15 && !WriteLength(op, opEnd, literalLength))
+			{
+				return false;
+			}
+
+			if (opEnd - op < literalLength)
+			{
+				return false;
+			}
+			memcpy(op, literals, literalLength);
+			op += literalLength;
+
+			if (matchLength == 0)
+			{
+				return true;
+			}
+
+			if (opEnd - op < 2)
+			{
+				return false;
+			}
+			*op++ = (uint8)(offset & 0xFF);
+			*op++ = (uint8)(offset >> 8);
+
+			int extraMatchLength = matchLength - MIN_MATCH;
+			*token |= (uint8)(extraMatchLength >= 15 ? 15 : extraMatchLength);
+			return extraMatchLength < 15 || WriteLength(op, opEnd, extraMatchLength);
+		}
+
+		static bool ReadLength(const uint8*& ip, const uint8* ipEnd, size_t& length)
+		{
+			uint8 byte;
+			do
+			{
+				if (ip >= ipEnd)
+				{
+					return false;
+				}
+				byte = *ip++;
+				length += byte;
+			} while (byte == 255);
+
+			return true;
+		}
+	}
+}
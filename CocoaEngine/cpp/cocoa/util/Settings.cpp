@@ -21,6 +21,15 @@ namespace Cocoa
 			extern CPath General::s_EditorStyleData = NCPath::CreatePath("EditorStyle.json");
 		}
 
+		namespace Graphics
+		{
+			// =======================================================================
+			// Graphics Settings
+			// =======================================================================
+			extern int Graphics::s_TextureMemoryBudgetMb = 256;
+			extern int Graphics::s_AssetMemoryBudgetMb = 512;
+		}
+
 		namespace Physics2D
 		{
 			// =======================================================================
@@ -29,6 +38,20 @@ namespace Cocoa
 			extern int Physics2D::s_PositionIterations = 3;
 			extern int Physics2D::s_VelocityIterations = 8;
 			extern float Physics2D::s_Timestep = 1.0f / 60.0f;
+			extern int Physics2D::s_MaxSubsteps = 5;
+		}
+
+		namespace Streaming
+		{
+			// =======================================================================
+			// World Streaming Settings
+			// =======================================================================
+			extern float Streaming::s_CellSize = 1024.0f;
+			// In cells around the camera's view. Cells load inside the load radius and only unload once they leave
+			// the larger unload radius, so moving back and forth over a cell border doesn't reload it every frame
+			extern int Streaming::s_LoadRadius = 1;
+			extern int Streaming::s_UnloadRadius = 2;
+			extern int Streaming::s_MaxCellsPerFrame = 2;
 		}
 	}
 }
\ No newline at end of file
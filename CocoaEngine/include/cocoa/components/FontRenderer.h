@@ -12,5 +12,8 @@ namespace Cocoa
 		Handle<Font> m_Font;
 		std::string text;
 		int fontSize;
+
+		// When set the text is rendered once into a texture and drawn as a single quad until it changes
+		bool m_Cached = false;
 	};
 }
\ No newline at end of file
@@ -22,24 +22,74 @@ namespace Cocoa
 	class COCOA AssetManager
 	{
 	public:
-		static Handle<Texture> LoadTextureFromJson(const json& j, bool isDefault = false, int id = -1);
+		static Handle<Texture> LoadTextureFromJson(const json& j, bool isDefault = false, int id = -1, bool async = false);
 		static Handle<Texture> LoadTextureFromFile(Texture& texture, const CPath& path, int id = -1);
+
+		// Returns immediately with a handle to a 1x1 placeholder, the file is decoded on a worker thread and uploaded
+		// when AsyncTextureLoader::Update runs
+		static Handle<Texture> LoadTextureFromFileAsync(Texture& texture, const CPath& path, int id = -1);
+
 		static Handle<Texture> GetTexture(const CPath& path);
-		static const Texture& GetTexture(uint32 resourceId);
+		static const Texture& GetTexture(Handle<Texture> handle);
+		static Handle<Texture> GetTextureHandle(uint32 resourceId);
+
+		// Registers a texture that was generated at runtime, like a framebuffer attachment. These are never serialized.
+		static Handle<Texture> AddGeneratedTexture(const Texture& texture);
 
 		static Handle<Font> LoadFontFromJson(const CPath& path, const json& j, bool isDefault = false, int id = -1);
-		static Handle<Font> LoadFontFromTtfFile(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution);
+		static Handle<Font> LoadFontFromTtfFile(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution,
+			FontSdfType sdfType = FontSdfType::SingleChannel);
 		static Handle<Font> GetFont(const CPath& path);
-		static const Font& GetFont(uint32 resourceId);
+		static const Font& GetFont(Handle<Font> handle);
+		static Handle<Font> GetFontHandle(uint32 resourceId);
 
 		static Handle<Shader> LoadShaderFromFile(const CPath& path, bool isDefault = false, int id = -1);
 		static Handle<Shader> GetShader(const CPath& path);
-		static const Shader& GetShader(uint32 resourceId);
+		static const Shader& GetShader(Handle<Shader> handle);
+		static Handle<Shader> GetShaderHandle(uint32 resourceId);
+
+		// Frees a single asset and its slot. Existing handles to it become invalid, even once the slot is reused
+		static void UnloadTexture(Handle<Texture> handle);
+		static void UnloadFont(Handle<Font> handle);
+		static void UnloadShader(Handle<Shader> handle);
+
+		static bool IsValid(Handle<Texture> handle);
+		static bool IsValid(Handle<Font> handle);
+		static bool IsValid(Handle<Shader> handle);
+
+		// Serialized asset references only store the slot index (the resource id), this returns -1 for null handles
+		template<typename T>
+		static uint32 GetResourceId(Handle<T> handle) { return handle.IsNull() ? (uint32)-1 : handle.Index(); }
 
 		static void LoadTexturesFrom(const json& j);
 		static void LoadFontsFrom(const json& j);
 		static json Serialize();
 
+		// Resource ids in a scene file may not match the slots its assets end up in, since assets another scene already
+		// had loaded are reused. These resolve ids from the scene file that was loaded last
+		static Handle<Texture> GetSceneTexture(uint32 resourceId);
+		static Handle<Font> GetSceneFont(uint32 resourceId);
+
+		// Files that outlive the scene they were saved from, like prefabs, keep their own table of the assets they use
+		// and look them up by path. These return the asset already loaded from that path or load it from its json, and
+		// the current scene takes a reference on it either way. The scene's resource id table is left alone
+		static Handle<Texture> ResolveTexture(const json& assetJson);
+		static Handle<Font> ResolveFont(const json& assetJson, Handle<Texture> fontTexture);
+
+		// Every scene holds a reference on the non-default assets it loads or imports. Releasing a scene only drops its
+		// references, assets nothing references anymore stay loaded so the next scene can reuse them, until
+		// EvictUnreferenced needs the memory back
+		static void ReleaseScene(uint32 scene);
+
+		// Unloads unreferenced textures, least recently released first, until everything fits inside
+		// Settings::Graphics::s_AssetMemoryBudgetMb
+		static void EvictUnreferenced();
+
+		static uint32 GetReferenceCount(Handle<Texture> handle);
+		static uint32 GetReferenceCount(Handle<Font> handle);
+		static uint32 GetReferenceCount(Handle<Shader> handle);
+		static uint64 GetResidentBytes();
+
 		static void Clear();
 		static void Init(uint32 scene);
 
@@ -6,23 +6,33 @@ namespace Cocoa
 {
 	class AssetManager;
 
+	// A handle packs the asset's slot index into the low bits and the slot's generation into the high bits. The
+	// AssetManager bumps the generation every time a slot is freed, so handles to an unloaded asset stop being valid
+	// instead of pointing at whatever gets loaded into the slot next.
 	template<typename T>
 	class COCOA Handle
 	{
 	public:
+		static constexpr uint32 INDEX_BITS = 20;
+		static constexpr uint32 INDEX_MASK = (1u << INDEX_BITS) - 1;
+		static constexpr uint32 GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+		static constexpr uint32 NULL_ID = (uint32)-1;
+
 		Handle()
 		{
-			m_AssetId = m_NullId;
+			m_AssetId = NULL_ID;
 		}
 
-		Handle(uint32 id)
+		// Takes an already packed id. Explicit so a serialized resource id, which is only the slot index, can't silently
+		// pass for a handle without its generation
+		explicit Handle(uint32 id)
 		{
 			m_AssetId = id;
 		}
 
-		Handle(const Handle& other)
+		Handle(uint32 index, uint32 generation)
 		{
-			m_AssetId = other.m_AssetId;
+			m_AssetId = (index & INDEX_MASK) | ((generation & GENERATION_MASK) << INDEX_BITS);
 		}
 
 		inline bool operator==(Handle other) const
@@ -42,13 +52,20 @@ namespace Cocoa
 
 		inline bool IsNull() const
 		{
-			return m_AssetId == m_NullId;
+			return m_AssetId == NULL_ID;
+		}
+
+		inline uint32 Index() const
+		{
+			return m_AssetId & INDEX_MASK;
+		}
+
+		inline uint32 Generation() const
+		{
+			return m_AssetId >> INDEX_BITS;
 		}
 
 	public:
 		uint32 m_AssetId;
-
-	private:
-		uint32 m_NullId = -1;
 	};
-}
\ No newline at end of file
+}
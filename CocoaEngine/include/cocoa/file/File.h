@@ -10,13 +10,35 @@ namespace Cocoa
 		char* m_Data = nullptr;
 		uint32 m_Size = 0;
 		bool m_Open = false;
+
+		// Set when m_Data points into a mounted pack file instead of memory the handle owns
+		bool m_Mapped = false;
+	};
+
+	struct MemoryMappedFile
+	{
+		const uint8* m_Data = nullptr;
+		uint64 m_Size = 0;
+		void* m_FileHandle = nullptr;
+		void* m_MappingHandle = nullptr;
 	};
 
 	namespace File
 	{
 		COCOA FileHandle* OpenFile(const CPath& filename);
 		COCOA void CloseFile(FileHandle* file);
+
+		// Maps the whole file copy-on-write, writes through the mapping never reach the file. Pages are loaded on first
+		// access, so this is cheap even for big files
+		COCOA MemoryMappedFile* MemoryMapFile(const CPath& filename);
+		COCOA void UnmapFile(MemoryMappedFile* file);
+
 		COCOA bool WriteFile(const char* data, const CPath& filename);
+		COCOA bool WriteFile(const uint8* data, uint32 size, const CPath& filename);
+
+		// Writes to a temporary file next to filename and renames it over filename, so a crash or a failed write never
+		// leaves a half written file behind. Safe to call from worker threads
+		COCOA bool WriteFileAtomic(const uint8* data, uint32 size, const CPath& filename);
 		COCOA bool CreateFile(const CPath& filename, const char* extToAppend = "");
 		COCOA bool DeleteFile(const CPath& filename);
 		COCOA bool CopyFile(const CPath& fileToCopy, const CPath& newFileLocation, const char* newFilename = "");
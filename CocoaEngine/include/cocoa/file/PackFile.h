@@ -0,0 +1,65 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/file/CPath.h"
+
+namespace Cocoa
+{
+	enum class PackCompression : uint32
+	{
+		None = 0,
+		Lz4 = 1
+	};
+
+	// One entry in the table of contents. Entries are sorted by PathHash, so lookups binary search straight over the
+	// mapped file
+	struct PackEntry
+	{
+		uint64 PathHash;
+		uint64 Offset;
+		uint32 Size;
+		uint32 StoredSize;
+		PackCompression Compression;
+		uint32 Padding;
+	};
+
+	struct PackData
+	{
+		const uint8* Data = nullptr;
+		uint32 Size = 0;
+
+		// Only filled in for compressed entries, Data points into it then
+		std::vector<uint8> Decompressed;
+	};
+
+	// Bundles every file under a directory into one archive that shipping builds read through a single memory mapping,
+	// instead of opening hundreds of loose files. File::OpenFile, shaders, textures and fonts look in the mounted pack
+	// before they touch the disk.
+	// Mount and Unmount are not thread safe, everything else can be called from worker threads while a pack is mounted.
+	namespace PackFile
+	{
+		// Packs every file under rootDirectory, entries that shrink enough get LZ4 compressed. Returns the number of
+		// files packed, or -1 if the pack could not be written
+		COCOA int Build(const CPath& rootDirectory, const CPath& outputFile, bool compress = true);
+
+		// Paths are looked up relative to rootDirectory, which should match the directory the pack was built from
+		COCOA bool Mount(const CPath& packFile, const CPath& rootDirectory);
+		COCOA void Unmount();
+		COCOA bool IsMounted();
+
+		COCOA const PackEntry* Find(const CPath& path);
+
+		// Returns the entry's bytes inside the mapping, or nullptr for compressed entries. The data is followed by a null
+		// terminator that is not counted in Size
+		COCOA const uint8* GetMappedData(const PackEntry& entry);
+
+		// Output must have room for entry.Size bytes
+		COCOA bool Decompress(const PackEntry& entry, uint8* output);
+
+		// Returns false if there is no pack mounted or the file is not in it
+		COCOA bool Read(const CPath& path, PackData& result);
+
+		COCOA CPath GetDefaultPath(const CPath& rootDirectory);
+	};
+}
@@ -3,6 +3,7 @@
 #include "cocoa/core/Core.h"
 
 #include "cocoa/physics2d/PhysicsComponents.h"
+#include "cocoa/components/TransformStruct.h"
 #include "cocoa/core/Entity.h"
 #include "cocoa/scenes/SceneData.h"
 
@@ -10,14 +11,91 @@ namespace Cocoa
 {
 	namespace Physics2D
 	{
-		COCOA void Init(const glm::vec2& gravity);
+		// The world lives as long as the scene does. Bodies are created when an entity has both a Rigidbody2D and a
+		// TransformData and go back to a pool of bodies when it loses either, driven by the registry's component events.
+		// A Box2D or Circle on the same entity becomes the body's fixture, scaled by the transform
+		COCOA void Init(SceneData& scene, const glm::vec2& gravity);
 		COCOA void Destroy(SceneData& scene);
 
+		// Destroys every body in the world, pooled ones included, but keeps the world itself around
+		COCOA void DestroyBodies(SceneData& scene);
+
+		// Puts every body back to what its components say, with no velocity, and creates or releases bodies for any
+		// component changes that haven't been picked up yet. Called when play starts and after the scene is restored
+		// on stop
+		COCOA void ResetBodies(SceneData& scene);
+
+		// Picks up component changes while the world isn't stepping, so entering play has nothing left to create
+		COCOA void EditorUpdate(SceneData& scene);
+
 		COCOA bool PointInBox(const glm::vec2& point, const glm::vec2& halfSize, const glm::vec2& position, float rotationDegrees);
 
+		// ----------------------------------------------------------------------------
+		// Queries
+		// ----------------------------------------------------------------------------
+		// Queries walk the world's broadphase and only report bodies whose CollisionFilter2D category is in the mask.
+		// The world is only idle between Update and StartStep, which is when scripts run, so queries made there answer
+		// right away against the poses scripts see. Anywhere else they block until the running step is done.
+		// Results are written to the caller's arrays and the number written is returned. Rays skip their m_Ignore
+		// entity and never hit anything without a direction or max distance
+		COCOA bool Raycast(const Ray2D& ray, uint16 mask, RaycastHit2D& hit);
+
+		// Sorted from closest to furthest
+		COCOA int RaycastAll(const Ray2D& ray, uint16 mask, RaycastHit2D* hits, int maxHits);
+		COCOA int OverlapBox(const glm::vec2& center, const glm::vec2& halfSize, uint16 mask, entt::entity* results, int maxResults);
+		COCOA int OverlapPoint(const glm::vec2& point, uint16 mask, entt::entity* results, int maxResults);
+
+		// Finds the closest hit for every ray, hits[i] belongs to rays[i] and has a null entity if nothing was hit.
+		// Large batches are split across the query worker threads
+		COCOA void RaycastBatch(const Ray2D* rays, int numRays, uint16 mask, RaycastHit2D* hits);
+
+		// ----------------------------------------------------------------------------
+		// Contact Events
+		// ----------------------------------------------------------------------------
+		// Contacts are appended to one flat buffer while the world steps instead of calling back into gameplay code.
+		// The events of every step run since the last Update can be read once Update returns and stay valid until the
+		// next Update. Entities in them may have been destroyed since
+		COCOA ContactEventSpan2D GetContactEvents();
+		COCOA ContactEventStats2D GetContactEventStats();
+
+		// Only contacts where either body's CollisionFilter2D category is in the mask are recorded. Pre-solve events
+		// fire for every touching pair on every step, so they have their own mask and are off by default. Like the
+		// queries, this waits for a running step
+		COCOA void SetContactEventMasks(uint16 mask, uint16 preSolveMask);
+
+		// The world steps on its own thread while the main thread renders. Everything below that changes a body is
+		// queued while a step is running and applied at the start of the next Update, otherwise it happens right away,
+		// which is always the case for calls from scripts.
+		// Bodies follow component events on their own, AddEntity only forces the body to be created now
 		COCOA void AddEntity(Entity entity);
+
+		// Releases the entity's body, if it has one. The component forgets the body immediately, it only gets a new
+		// one when its physics components change or play starts again
+		COCOA void RemoveEntity(Entity entity);
+
+		COCOA void ApplyForce(Entity entity, const glm::vec2& force);
+		COCOA void ApplyImpulse(Entity entity, const glm::vec2& impulse);
+		COCOA void SetVelocity(Entity entity, const glm::vec2& velocity);
+		COCOA void Teleport(Entity entity, const glm::vec2& position, float rotationDegrees);
+
+		// Reads back the poses of the step started last frame, applies queued commands and works out how many steps of
+		// the fixed Settings::Physics2D::s_Timestep, at most s_MaxSubsteps, this frame needs. Transforms lag the
+		// simulation by one frame
 		COCOA void Update(SceneData& scene, float dt);
 
+		// Hands the steps counted by Update to the step thread. Call it once gameplay code is done with the world for
+		// the frame, so the step only overlaps rendering and nothing in between has to wait for it
+		COCOA void StartStep(SceneData& scene);
+
+		// Blocks until the running step is done, anything that reads the world directly has to call this first
+		COCOA void WaitForStep();
+
+		// How far the leftover frame time is into the next step, from 0 to 1
+		COCOA float GetInterpolationAlpha();
+
+		// Blends the body's previous pose towards its transform by the interpolation alpha
+		COCOA void GetInterpolatedPose(const TransformData& transform, const Rigidbody2D& rb, glm::vec3& position, float& rotationDegrees);
+
         // ----------------------------------------------------------------------------
         // Serialization
         // ----------------------------------------------------------------------------
@@ -27,5 +105,7 @@ namespace Cocoa
         COCOA void DeserializeBox2D(json& j, Entity entity);
         COCOA void Serialize(json& j, Entity entity, const Rigidbody2D& rigidbody);
         COCOA void DeserializeRigidbody2D(json& j, Entity entity);
+        COCOA void Serialize(json& j, Entity entity, const CollisionFilter2D& filter);
+        COCOA void DeserializeCollisionFilter2D(json& j, Entity entity);
 	};
 }
\ No newline at end of file
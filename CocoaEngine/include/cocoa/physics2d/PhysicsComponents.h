@@ -40,6 +40,61 @@ namespace Cocoa
         Entity m_Ignore = NEntity::CreateNull();
     };
 
+    // Which layers a body is on and which layers it collides with and shows up in queries for. Bodies without one are
+    // on layer 1 and collide with everything
+    struct CollisionFilter2D
+    {
+        uint16 m_Category = 0x0001;
+        uint16 m_Mask = 0xFFFF;
+    };
+
+    struct RaycastHit2D
+    {
+        entt::entity m_Entity = entt::null;
+        glm::vec2 m_Point = glm::vec2();
+        glm::vec2 m_Normal = glm::vec2();
+        float m_Fraction = 1.0f;
+    };
+
+    enum class ContactEventType2D : uint8
+    {
+        Begin = 0,
+        End = 1,
+        PreSolve = 2
+    };
+
+    // The normal points from A to B. The impulse is the total normal impulse over the contact points. For Begin it's
+    // what the solver applied in the step the contact started, for pre-solve it's what the previous step applied, and
+    // End and sensor contacts have none
+    struct ContactEvent2D
+    {
+        ContactEventType2D m_Type = ContactEventType2D::Begin;
+        entt::entity m_EntityA = entt::null;
+        entt::entity m_EntityB = entt::null;
+        glm::vec2 m_Normal = glm::vec2();
+        float m_NormalImpulse = 0.0f;
+    };
+
+    // A view over contact events owned by the physics system, so scripts can range-for over them
+    struct ContactEventSpan2D
+    {
+        const ContactEvent2D* m_Events = nullptr;
+        int m_NumEvents = 0;
+
+        const ContactEvent2D* begin() const { return m_Events; }
+        const ContactEvent2D* end() const { return m_Events + m_NumEvents; }
+    };
+
+    struct ContactEventStats2D
+    {
+        uint32 m_NumBeginEvents = 0;
+        uint32 m_NumEndEvents = 0;
+        uint32 m_NumPreSolveEvents = 0;
+
+        // Contacts that happened but weren't recorded because neither body was in the event mask
+        uint32 m_NumFilteredEvents = 0;
+    };
+
     struct Rigidbody2D
     {
         glm::vec2 m_Velocity = glm::vec2();
@@ -52,5 +107,13 @@ namespace Cocoa
         bool m_ContinuousCollision = false;
 
         void* m_RawRigidbody = nullptr;
+
+        // The transform as physics last saw it, a transform that no longer matches was moved by the editor or a script
+        glm::vec2 m_SyncedPosition = glm::vec2();
+        float m_SyncedRotation = 0.0f;
+
+        // The pose one step before the synced one, rendering blends between the two
+        glm::vec2 m_PreviousPosition = glm::vec2();
+        float m_PreviousRotation = 0.0f;
     };
 }
\ No newline at end of file
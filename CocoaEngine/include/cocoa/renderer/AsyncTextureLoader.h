@@ -0,0 +1,35 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Handle.h"
+#include "cocoa/renderer/Texture.h"
+#include "cocoa/file/CPath.h"
+
+namespace Cocoa
+{
+	// Decodes texture files on worker threads and uploads the results through pixel buffer objects on the GL thread.
+	// Textures that are queued keep a 1x1 placeholder until their upload finishes.
+	namespace AsyncTextureLoader
+	{
+		COCOA void Init(int numThreads = 0);
+		COCOA void Destroy();
+
+		// Queues the file to be decoded into the texture referenced by the handle. The texture must already have a
+		// placeholder generated for it. Compressed and mipmapped textures are cooked on the worker thread as well, and
+		// mipmapped textures are handed to the TextureStreamer once they are ready
+		COCOA void Queue(Handle<Texture> textureHandle, const CPath& path, CompressionQuality compression = CompressionQuality::None, bool generateMips = false);
+
+		// Must be called on the GL thread. Uploads up to maxUploads decoded textures, pass 0 to upload everything that is ready
+		COCOA void Update(int maxUploads = 8);
+
+		// Blocks the GL thread until every queued texture has been decoded and uploaded
+		COCOA void WaitAll();
+
+		// Drops every pending load, used when the assets they would be uploaded into are cleared
+		COCOA void CancelAll();
+
+		COCOA bool IsLoading(Handle<Texture> textureHandle);
+		COCOA int NumPending();
+	};
+}
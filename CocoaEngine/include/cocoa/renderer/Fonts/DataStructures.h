@@ -2,6 +2,14 @@
 
 namespace Cocoa
 {
+	enum class FontSdfType
+	{
+		// Classic single channel sdf generated from an upscaled rasterized glyph
+		SingleChannel = 0,
+		// Multi-channel sdf generated from the glyph outline, keeps sharp corners at small glyph sizes
+		MultiChannel = 1
+	};
+
 	struct CharInfo
 	{
 		float ux0, uy0;
@@ -13,7 +13,8 @@ namespace Cocoa
 		Font();
 
 		const CharInfo& GetCharacterInfo(int codepoint) const;
-		void GenerateSdf(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart = 0, int glyphRangeEnd = 'z' + 1, int padding = 5, int upscaleResolution = 4096);
+		void GenerateSdf(const CPath& fontFile, int fontSize, const CPath& outputFile, int glyphRangeStart = 0, int glyphRangeEnd = 'z' + 1, int padding = 5, int upscaleResolution = 4096,
+			FontSdfType sdfType = FontSdfType::SingleChannel);
 		void Free();
 
 		inline bool IsNull() const { return m_IsNull; }
@@ -32,6 +33,7 @@ namespace Cocoa
 		int m_CharacterMapSize = 0;
 		int m_GlyphRangeStart = 0;
 		int m_GlyphRangeEnd = 0;
+		FontSdfType m_SdfType = FontSdfType::SingleChannel;
 		bool m_IsDefault;
 		bool m_IsNull = false;
 	};
@@ -0,0 +1,26 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "DataStructures.h"
+#include "cocoa/file/CPath.h"
+
+namespace Cocoa
+{
+	// Caches generated SDF atlases and glyph metrics on disk, keyed by a hash of the font file and the import settings,
+	// so importing the same font again skips the generation entirely.
+	// Textures go through TextureCooker, which keeps its own cache the same way.
+	namespace FontCooker
+	{
+		// Returns 0 if the font file could not be read
+		COCOA uint64 HashImport(const CPath& fontFile, int fontSize, int glyphRangeStart, int glyphRangeEnd, int padding, int upscaleResolution, FontSdfType sdfType);
+
+		// Fills in the character map and writes the cached atlas to outputFile. Returns false if nothing is cached for
+		// importHash
+		COCOA bool ReadCache(uint64 importHash, CharInfo* characterMap, int characterMapSize, const CPath& outputFile);
+		COCOA bool WriteCache(uint64 importHash, const CharInfo* characterMap, int characterMapSize, const CPath& atlasFile);
+
+		COCOA CPath GetCacheDirectory();
+		COCOA CPath GetCachePath(uint64 importHash);
+	};
+}
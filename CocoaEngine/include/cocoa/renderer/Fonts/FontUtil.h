@@ -18,7 +18,12 @@ namespace Cocoa
 
 		COCOA SdfBitmapContainer GenerateSdfCodepointBitmap(int codepoint, FT_Face font, int fontSize, int padding = 5, int upscaleResolution = 4096, bool flipVertically = false);
 
+		// Generates a multi-channel sdf directly from the glyph outline. The bitmap returned is RGBA, where RGB hold the
+		// multi-channel distances (take the median to reconstruct the edge) and A holds the true single channel distance.
+		// Padding doubles as the distance range in pixels
+		COCOA SdfBitmapContainer GenerateMsdfCodepointBitmap(int codepoint, FT_Face font, int fontSize, int padding = 5);
+
 		COCOA void CreateSdfFontTexture(const CPath& fontFile, int fontSize, CharInfo* characterMap, int characterMapSize, const CPath& outputFile, 
-			int padding = 5, int upscaleResolution = 4096, int glyphOffset = 0);
+			int padding = 5, int upscaleResolution = 4096, int glyphOffset = 0, FontSdfType sdfType = FontSdfType::SingleChannel);
 	}
 }
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include "cocoa/renderer/fonts/Font.h"
 #include "cocoa/renderer/Texture.h"
 #include "cocoa/renderer/Shader.h"
+#include "cocoa/renderer/TextCache.h"
 
 namespace Cocoa
 {
@@ -44,7 +45,11 @@ namespace Cocoa
         COCOA void Clear(RenderBatchData& data);
         COCOA void Start(RenderBatchData& data);
         COCOA void Add(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr);
+
+        // Draws the sprite at position and rotation instead of the transform's own, used for interpolated bodies
+        COCOA void Add(RenderBatchData& data, const TransformData& transform, const SpriteRenderer& spr, const glm::vec3& position, float rotationDegrees);
         COCOA void Add(RenderBatchData& data, const TransformData& transform, const FontRenderer& fontRenderer);
+        COCOA void Add(RenderBatchData& data, const TransformData& transform, const FontRenderer& fontRenderer, const CachedText& cachedText);
         COCOA void Add(RenderBatchData& data, const glm::vec2& min, const glm::vec2& max, const glm::vec3& color);
         COCOA void Add(RenderBatchData& data, const glm::vec2* vertices, const glm::vec3& color);
         COCOA void Add(RenderBatchData& data, Handle<Texture> textureHandle, const glm::vec2& size, const glm::vec2& position,
@@ -0,0 +1,45 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Handle.h"
+#include "cocoa/renderer/Texture.h"
+#include "cocoa/renderer/Shader.h"
+#include "cocoa/renderer/fonts/Font.h"
+#include "cocoa/components/FontRenderer.h"
+#include "cocoa/components/TransformStruct.h"
+
+namespace Cocoa
+{
+	// A text block that was rendered once into an offscreen texture, so it can be drawn as a single quad
+	struct CachedText
+	{
+		Handle<Texture> TextureHandle;
+
+		// Bounds of the text relative to the transform position
+		glm::vec2 Min;
+		glm::vec2 Max;
+		glm::vec2 TexCoordMax;
+
+		// Everything that forces the text to be re-rendered when it changes
+		std::string Text;
+		Handle<Font> FontHandle;
+		int FontSize;
+		glm::vec2 Scale;
+
+		int PoolIndex;
+		uint32 LastUsedFrame;
+	};
+
+	namespace TextCache
+	{
+		COCOA void Init(Handle<Shader> fontShader);
+		COCOA void Destroy();
+
+		// Returns the cached text for this entity, re-rendering it first if the text, font, size or scale changed
+		COCOA const CachedText& Get(entt::entity entity, const TransformData& transform, const FontRenderer& fontRenderer);
+
+		// Returns the textures of any cached text that was not drawn this frame back to the texture pool
+		COCOA void EndFrame();
+	};
+}
@@ -17,6 +17,15 @@ namespace Cocoa
 		Repeat
 	};
 
+	// Quality of the block compression encoder, None uploads the texture uncompressed
+	enum class CompressionQuality
+	{
+		None=0,
+		Fast,
+		Normal,
+		High
+	};
+
 	enum class ByteFormat
 	{
 		None=0,
@@ -29,10 +38,17 @@ namespace Cocoa
 		R32UI,
 		RED_INTEGER,
 
+		// Block compressed formats
+		BC1_RGB,
+		BC3_RGBA,
+		BC7_RGBA,
+
 		// Depth/Stencil formats
 		DEPTH24_STENCIL8
 	};
 
+	struct CookedTexture;
+
 	struct COCOA Texture
 	{
 		uint32 GraphicsId = (uint32)-1;
@@ -46,6 +62,12 @@ namespace Cocoa
 		WrapMode WrapT = WrapMode::None;
 		ByteFormat InternalFormat = ByteFormat::None;
 		ByteFormat ExternalFormat = ByteFormat::None;
+		CompressionQuality Compression = CompressionQuality::None;
+		bool GenerateMips = false;
+
+		// Number of mip levels currently on the GPU. Streamed textures drop their finest levels, so level 0 on the GPU
+		// may be smaller than Width x Height
+		int32 NumMips = 1;
 
 		CPath Path = CPath();
 		bool IsDefault = false;
@@ -72,12 +94,40 @@ namespace Cocoa
 		// Allocates memory space on the GPU according to the texture specifications listed here
 		COCOA void Generate(Texture& texture);
 
+		// Generates a 1x1 white texture to stand in for a texture that is still being loaded
+		COCOA void GeneratePlaceholder(Texture& texture);
+
+		// Uploads width * height pixels in the texture's external format to an already generated texture. If a pixel
+		// unpack buffer is bound, pixels is an offset into that buffer instead
+		COCOA void Upload(Texture& texture, const void* pixels);
+
+		// Uploads block compressed data to an already generated texture, the internal format must be a compressed format.
+		// If a pixel unpack buffer is bound, data is an offset into that buffer instead
+		COCOA void UploadCompressed(Texture& texture, const void* data, uint32 dataSize);
+
+		// Replaces the texture's GPU storage with the cooked mip levels from firstLevel down to 1x1
+		COCOA void UploadMips(Texture& texture, const CookedTexture& cookedTexture, int firstLevel = 0);
+
+		// Picks the internal/external format for an 8 bit per channel image, returns false for unsupported channel counts
+		COCOA bool SetFormatFromChannels(Texture& texture, int channels);
+
+		// Decodes the image out of the mounted pack, or from disk when it is not packed. Free the result with
+		// stbi_image_free. Safe to call from worker threads
+		COCOA uint8* LoadPixels(const CPath& path, int* width, int* height, int* channels, int desiredChannels = 0);
+
 		COCOA bool IsNull(const Texture& texture);
 
+		// Estimate of the GPU memory the texture and its resident mip levels take up
+		COCOA uint64 GetMemorySize(const Texture& texture);
+
 		COCOA uint32 ToGl(ByteFormat format);
 		COCOA uint32 ToGl(WrapMode wrapMode);
 		COCOA uint32 ToGl(FilterMode filterMode);
 		COCOA uint32 ToGlDataType(ByteFormat format);
 		COCOA bool ByteFormatIsInt(ByteFormat format);
+		COCOA bool ByteFormatIsCompressed(ByteFormat format);
+
+		// Asks the driver whether it can sample the block compressed format, needs a current GL context
+		COCOA bool SupportsCompressedFormat(ByteFormat format);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,40 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Handle.h"
+#include "cocoa/renderer/Texture.h"
+#include "cocoa/file/CPath.h"
+
+namespace Cocoa
+{
+	struct AtlasRegion
+	{
+		Handle<Texture> Source;
+		Handle<Texture> Page;
+		glm::vec2 UvMin;
+		glm::vec2 UvSize;
+	};
+
+	// Packs small textures into shared pages so sprites that use different images can still be drawn in one batch.
+	// Sprites keep referencing their original texture, the renderer resolves the handle and texture coordinates to the
+	// page when it batches them.
+	namespace TextureAtlas
+	{
+		// Packs every loaded texture no bigger than maxTextureSize into pages, writes the pages and a manifest to
+		// outputDirectory and loads the result. Returns the number of textures that were packed
+		COCOA int Build(const CPath& outputDirectory, int pageSize = 2048, int maxTextureSize = 256, int padding = 2);
+
+		// Loads a manifest written by Build. Regions whose texture is not loaded or has changed size are skipped
+		COCOA bool Load(const CPath& outputDirectory);
+		COCOA void Clear();
+
+		// Returns the page the texture was packed into and remaps texCoords into that page. Textures that are not in an
+		// atlas, or texture coordinates that wrap outside of 0-1, are left unchanged
+		COCOA Handle<Texture> Resolve(Handle<Texture> textureHandle, glm::vec2* texCoords, int numTexCoords = 4);
+
+		COCOA const AtlasRegion* GetRegion(Handle<Texture> textureHandle);
+		COCOA int NumPages();
+		COCOA CPath GetDefaultDirectory();
+	};
+}
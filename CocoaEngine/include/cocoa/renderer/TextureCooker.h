@@ -0,0 +1,68 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/renderer/Texture.h"
+#include "cocoa/file/CPath.h"
+
+namespace Cocoa
+{
+	struct CookedTexture
+	{
+		ByteFormat Format = ByteFormat::None;
+		int32 Width = 0;
+		int32 Height = 0;
+		int32 NumMips = 1;
+
+		// Every mip level back to back, starting with the full resolution image
+		std::vector<uint8> Data;
+	};
+
+	// Encodes textures into BCn blocks and mip chains on the CPU and caches the results on disk, keyed by a hash of the
+	// source file.
+	// Nothing in here touches the GPU, so it is safe to call from worker threads.
+	namespace TextureCooker
+	{
+		// Fully opaque images are encoded as BC1 (4 bits per pixel), everything else as BC3 (8 bits per pixel), or as BC7
+		// (also 8 bits per pixel) at High quality when the GPU supports it
+		COCOA bool Encode(const uint8* pixels, int width, int height, int channels, CompressionQuality quality, CookedTexture& result);
+
+		// Encodes a 4x4 block of RGBA pixels, output must have room for 8 bytes
+		COCOA void EncodeBC1Block(const uint8* rgbaBlock, CompressionQuality quality, uint8* output);
+
+		// Encodes a 4x4 block of RGBA pixels, output must have room for 16 bytes
+		COCOA void EncodeBC3Block(const uint8* rgbaBlock, CompressionQuality quality, uint8* output);
+
+		// Encodes a 4x4 block of RGBA pixels in BC7 mode 6, output must have room for 16 bytes
+		COCOA void EncodeBC7Block(const uint8* rgbaBlock, CompressionQuality quality, uint8* output);
+
+		// BC7 is only picked once this was told the GPU can sample it, see TextureUtil::SupportsCompressedFormat
+		COCOA void SetBC7Supported(bool supported);
+		COCOA bool IsBC7Supported();
+
+		// Generates every mip level down to 1x1 from 8 bit RGBA pixels. Colors are averaged in linear space and weighted
+		// by alpha, so mips do not darken or pick up the color of fully transparent pixels. Levels are encoded with quality,
+		// or left as RGBA8 when quality is None
+		COCOA bool EncodeMipChain(const uint8* rgbaPixels, int width, int height, CompressionQuality quality, CookedTexture& result);
+
+		// Downsamples an 8 bit sRGB RGBA image to half its size, rounded down to at least 1 pixel like OpenGL's mip sizes.
+		// Odd dimensions use a 3 tap filter, so the last row and column still contribute
+		COCOA void GenerateMip(const uint8* rgbaPixels, int width, int height, uint8* output);
+
+		// Returns the cooked texture for the source file, encoding it and writing it to the cache if it is not there yet
+		COCOA bool Cook(const CPath& sourcePath, CompressionQuality quality, CookedTexture& result, bool generateMips = false);
+
+		COCOA bool ReadCache(const CPath& cachePath, uint64 sourceHash, CookedTexture& result);
+		COCOA bool WriteCache(const CPath& cachePath, uint64 sourceHash, const CookedTexture& cookedTexture);
+
+		COCOA CPath GetCacheDirectory();
+		COCOA CPath GetCachePath(uint64 sourceHash, CompressionQuality quality, bool generateMips = false);
+		COCOA uint64 HashBytes(const uint8* data, size_t size);
+
+		COCOA int NumMipLevels(int width, int height);
+		COCOA uint32 LevelSize(ByteFormat format, int width, int height);
+
+		// Byte offset of the mip level in CookedTexture::Data, passing NumMips gives the size of the whole chain
+		COCOA uint32 MipOffset(ByteFormat format, int width, int height, int level);
+	};
+}
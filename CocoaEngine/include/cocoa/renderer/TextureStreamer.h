@@ -0,0 +1,35 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Handle.h"
+#include "cocoa/renderer/Texture.h"
+#include "cocoa/renderer/TextureCooker.h"
+
+namespace Cocoa
+{
+	// Keeps only the mip levels of a texture that are actually needed on the GPU. The renderer reports the largest size
+	// each texture was drawn at, and the streamer uploads finer levels on demand or drops them to stay inside
+	// Settings::Graphics::s_TextureMemoryBudgetMb.
+	namespace TextureStreamer
+	{
+		COCOA void Init();
+		COCOA void Destroy();
+
+		// Takes ownership of the cooked mip chain and uploads its coarsest levels into the texture
+		COCOA void Register(Handle<Texture> textureHandle, CookedTexture& cookedTexture);
+		COCOA void Unregister(Handle<Texture> textureHandle);
+		COCOA void Clear();
+
+		// Size in framebuffer pixels that the whole texture would cover if it were drawn at this scale
+		COCOA void ReportUsage(Handle<Texture> textureHandle, const glm::vec2& screenSize);
+
+		// Must be called once per frame on the GL thread, after everything has been reported. Uploads at most maxUploads
+		// textures with finer mips
+		COCOA void Update(int maxUploads = 2);
+
+		COCOA bool IsStreamed(Handle<Texture> textureHandle);
+		COCOA uint64 GetResidentBytes();
+		COCOA uint64 GetBudgetBytes();
+	};
+}
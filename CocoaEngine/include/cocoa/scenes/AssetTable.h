@@ -0,0 +1,34 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Entity.h"
+#include "cocoa/core/Handle.h"
+#include "cocoa/renderer/Texture.h"
+#include "cocoa/renderer/fonts/Font.h"
+
+namespace Cocoa
+{
+	// Resource id in a file's asset table -> handle the asset resolved to
+	struct AssetRemap
+	{
+		std::unordered_map<uint32, Handle<Texture>> Textures;
+		std::unordered_map<uint32, Handle<Font>> Fonts;
+	};
+
+	// Files that get loaded into whatever scene is open, like prefabs and world cells, can't rely on the scene's resource
+	// ids. They carry a table of the textures and fonts their entities use, which is resolved by filepath on load.
+	namespace AssetTable
+	{
+		// Writes the textures and fonts the entities' SpriteRenderers and FontRenderers use. Default assets are left out,
+		// every session loads them into the same slots
+		COCOA json Serialize(const Entity* entities, int numEntities);
+
+		// Loads or retains every asset in the table for the current scene
+		COCOA void Resolve(const json& table, AssetRemap& remap);
+
+		// The component serializers resolved the component's asset id through the scene's table, this points it at the
+		// asset from the file's own table instead
+		COCOA void Remap(const json& component, Entity entity, const AssetRemap& remap);
+	};
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/file/CPath.h"
+#include "cocoa/scenes/SceneData.h"
+
+namespace Cocoa
+{
+	typedef void (*SceneSavedFn)(const CPath& filename, bool success);
+
+	// Saves scenes without stalling the main thread. Save only takes a snapshot of the scene, encoding it and writing the
+	// file happen on a worker thread. Files are written to a temporary file and renamed over the old one, so an
+	// interrupted save leaves the previous version intact.
+	namespace AsyncSceneSaver
+	{
+		COCOA void Init();
+
+		// Finishes every pending save before returning
+		COCOA void Destroy();
+
+		// Must be called on the main thread. If a save to the same file is still waiting for the worker it is replaced
+		// by this one
+		COCOA void Save(SceneData& data, const CPath& filename, SceneSavedFn onSaved = nullptr);
+
+		// Must be called on the main thread. Reports finished saves and calls their callbacks
+		COCOA void Update();
+
+		// Blocks until every queued save has been written and reported
+		COCOA void WaitAll();
+
+		COCOA bool IsSaving();
+	};
+}
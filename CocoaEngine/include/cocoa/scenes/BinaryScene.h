@@ -0,0 +1,46 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/scenes/SceneData.h"
+
+namespace Cocoa
+{
+	// The scene format Scene::Save writes. A versioned header is followed by one chunk per component type, each chunk is a
+	// packed column of entity ids followed by a column of fixed size component records, so loading is a bulk insert
+	// per component type instead of a DOM walk. Assets and script components go in as CBOR chunks, since their layout
+	// is owned by the AssetManager and the script library.
+	// JSON stays around as the interchange format, see Scene::ExportJson.
+	// Entities owned by world cells are left out, the scene stores the hash of the cell index it was saved with instead.
+	struct SceneSnapshot
+	{
+		std::string Project;
+		json Assets;
+		json Scripts;
+
+		// Zero when the scene isn't split into world cells
+		uint64 WorldCellsHash;
+
+		// Entity and component chunks, already in their final layout
+		std::vector<uint8> Chunks;
+		uint32 NumChunks;
+	};
+
+	namespace BinaryScene
+	{
+		COCOA bool IsBinary(const uint8* data, uint32 size);
+
+		COCOA void Serialize(SceneData& data, std::vector<uint8>& output);
+
+		// Serialize split in two. The snapshot copies everything out of the registry, the asset manager and the script
+		// library, so it has to be taken on the main thread. Encoding only reads the snapshot and can run anywhere
+		COCOA void TakeSnapshot(SceneData& data, SceneSnapshot& snapshot);
+		COCOA void Encode(const SceneSnapshot& snapshot, std::vector<uint8>& output);
+
+		// Loads the scene's assets and components into an initialized scene
+		COCOA bool Deserialize(SceneData& data, const uint8* input, uint32 size);
+
+		// The world cell index hash the scene was saved with, zero if it doesn't use world cells
+		COCOA uint64 GetWorldCellsHash(const uint8* input, uint32 size);
+	};
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Entity.h"
+#include "cocoa/scenes/SceneData.h"
+
+namespace Cocoa
+{
+	// A copy of one component type's storage, Components holds a std::vector of the component type
+	struct ComponentArray
+	{
+		entt::id_type TypeId;
+		std::vector<entt::entity> Entities;
+		std::shared_ptr<void> Components;
+	};
+
+	typedef void (*SerializeComponentsFn)(json& j, SceneData& scene);
+	typedef void (*DeserializeComponentFn)(json& j, Entity entity);
+	typedef void (*CopyComponentFn)(Entity from, Entity to);
+	typedef void (*SnapshotComponentsFn)(SceneData& scene, ComponentArray& array);
+	typedef void (*RestoreComponentsFn)(SceneData& scene, const ComponentArray& array);
+	typedef std::shared_ptr<const void> (*CopyOutComponentFn)(Entity entity);
+	typedef void (*InsertComponentsFn)(SceneData& scene, const entt::entity* first, const entt::entity* last, const void* component);
+
+	struct ComponentSerializerEntry
+	{
+		std::string Name;
+		entt::id_type NameHash;
+		entt::id_type TypeId;
+		bool IsScript;
+
+		// Writes every instance of the component in the scene to j["Components"]
+		SerializeComponentsFn SerializeAll;
+		DeserializeComponentFn Deserialize;
+		CopyComponentFn Copy;
+
+		// Copies the whole storage in and out of a ComponentArray, used for in memory snapshots of the registry
+		SnapshotComponentsFn Snapshot;
+		RestoreComponentsFn Restore;
+
+		// Copies one entity's component out of the registry, or returns nullptr if it doesn't have one. InsertRange adds
+		// a copy of that component to every entity in [first, last) with one bulk insert, these back prefabs
+		CopyOutComponentFn CopyOut;
+		InsertComponentsFn InsertRange;
+	};
+
+	// Every serializable component registers here once, keyed by its type id and by the hash of its name. Saving walks the
+	// entries, loading and duplicating look the component up directly instead of comparing against each known type.
+	namespace ComponentSerializer
+	{
+		// Registers the engine's own components
+		COCOA void Init();
+
+		// Fills in the entry's NameHash
+		COCOA void Register(ComponentSerializerEntry entry);
+
+		// Script components live in the script library's registry, so the engine only knows them by name and loads them
+		// through the ScriptSystem. The generated InitScripts registers them, FreeScriptLibrary drops them again.
+		COCOA void RegisterScript(const char* name);
+		COCOA void UnregisterScripts();
+
+		COCOA const ComponentSerializerEntry* Find(entt::id_type typeId);
+		COCOA const ComponentSerializerEntry* Find(const std::string& name);
+		COCOA const std::vector<ComponentSerializerEntry>& GetEntries();
+
+		COCOA void Serialize(json& j, SceneData& scene);
+
+		// Expects a single component in the form {"Name": {"Entity": id, ...}}, unknown names are handed to the script
+		// library
+		COCOA void Deserialize(json& component, SceneData& scene);
+
+		// Copies every registered component. Script components are copied too when both entities are in the same scene,
+		// the script library's registry only belongs to the scene it was loaded for
+		COCOA void CopyComponents(Entity from, Entity to);
+
+		template<typename T, void(*SerializeFn)(json&, Entity, const T&), void(*DeserializeFn)(json&, Entity)>
+		void Register(const char* name)
+		{
+			ComponentSerializerEntry entry;
+			entry.Name = name;
+			entry.TypeId = entt::type_info<T>().id();
+			entry.IsScript = false;
+			entry.SerializeAll = [](json& j, SceneData& scene)
+			{
+				auto view = scene.Registry.view<T>();
+				for (entt::entity entity : view)
+				{
+					SerializeFn(j, Entity{ entity, &scene }, scene.Registry.get<T>(entity));
+				}
+			};
+			entry.Deserialize = DeserializeFn;
+			entry.Copy = [](Entity from, Entity to)
+			{
+				if (NEntity::HasComponent<T>(from))
+				{
+					to.Scene->Registry.emplace_or_replace<T>(to.Handle, NEntity::GetComponent<T>(from));
+				}
+			};
+			entry.Snapshot = [](SceneData& scene, ComponentArray& array)
+			{
+				auto view = scene.Registry.view<T>();
+				std::shared_ptr<std::vector<T>> components = std::make_shared<std::vector<T>>();
+				array.TypeId = entt::type_info<T>().id();
+				array.Entities.assign(view.data(), view.data() + view.size());
+				if constexpr (std::is_trivially_copyable<T>::value)
+				{
+					components->resize(view.size());
+					memcpy(components->data(), view.raw(), view.size() * sizeof(T));
+				}
+				else
+				{
+					components->assign(view.raw(), view.raw() + view.size());
+				}
+				array.Components = components;
+			};
+			entry.Restore = [](SceneData& scene, const ComponentArray& array)
+			{
+				const std::vector<T>& components = *static_cast<const std::vector<T>*>(array.Components.get());
+				scene.Registry.insert<T>(array.Entities.begin(), array.Entities.end(), components.begin(), components.end());
+			};
+			entry.CopyOut = [](Entity entity) -> std::shared_ptr<const void>
+			{
+				if (!NEntity::HasComponent<T>(entity))
+				{
+					return nullptr;
+				}
+				return std::make_shared<const T>(NEntity::GetComponent<T>(entity));
+			};
+			entry.InsertRange = [](SceneData& scene, const entt::entity* first, const entt::entity* last, const void* component)
+			{
+				scene.Registry.insert<T>(first, last, *static_cast<const T*>(component));
+			};
+			Register(entry);
+		}
+	};
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/scenes/SceneData.h"
+
+namespace Cocoa
+{
+	// Loads json scenes straight from the token stream. Built in components are filled in as their fields arrive and added
+	// to the registry when their object closes, so the file is never parsed into a DOM. Only the asset table and script
+	// components are gathered into small json objects, since the AssetManager and the script library own their layout.
+	namespace JsonSceneReader
+	{
+		// Loads the scene's assets and components into an initialized scene
+		COCOA bool Load(SceneData& data, const char* input, uint32 size);
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Entity.h"
+#include "cocoa/file/CPath.h"
+#include "cocoa/components/TransformStruct.h"
+#include "cocoa/scenes/SceneData.h"
+
+namespace Cocoa
+{
+	struct PrefabComponent
+	{
+		entt::id_type TypeId;
+		std::shared_ptr<const void> Component;
+	};
+
+	// An immutable template of one entity's components. Instantiating a prefab creates all of its entities at once and
+	// fills each component storage with a single bulk insert, so spawning hundreds of copies doesn't go through
+	// DuplicateEntity one entity and one component at a time.
+	struct Prefab
+	{
+		std::vector<PrefabComponent> Components;
+
+		// Script components live in the script library's registry, so they are kept as json and added per entity
+		json Scripts;
+	};
+
+	namespace NPrefab
+	{
+		COCOA Prefab Create(Entity entity);
+
+		// Creates count copies of the prefab. If transforms is not null it must hold count transforms, which replace the
+		// prefab's own transform. The new entities are written to outEntities if it is not null
+		COCOA void Instantiate(SceneData& scene, const Prefab& prefab, uint32 count, const TransformData* transforms = nullptr, entt::entity* outEntities = nullptr);
+		COCOA Entity Instantiate(SceneData& scene, const Prefab& prefab);
+
+		COCOA bool HasComponent(const Prefab& prefab, entt::id_type typeId);
+
+		// Prefab assets are stored in the same json component format as scenes, plus a table of the textures and fonts
+		// they use so they load in any scene
+		COCOA bool Save(const Prefab& prefab, const CPath& filename);
+		COCOA bool Load(Prefab& prefab, const CPath& filename);
+	};
+}
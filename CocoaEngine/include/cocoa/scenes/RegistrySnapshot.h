@@ -0,0 +1,32 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/scenes/SceneData.h"
+#include "cocoa/scenes/ComponentSerializer.h"
+
+namespace Cocoa
+{
+	// An in memory copy of a scene's registry. Component storages are copied as whole arrays and restored with one bulk
+	// insert per type, and entities keep their exact ids. Script components go through the script library as json since
+	// they live in its own registry.
+	struct RegistrySnapshot
+	{
+		std::vector<entt::entity> Entities;
+		std::vector<ComponentArray> Components;
+		json Scripts;
+	};
+
+	namespace NRegistrySnapshot
+	{
+		COCOA void Capture(SceneData& scene, RegistrySnapshot& snapshot);
+
+		// Replaces every entity and component in the scene with the ones in the snapshot. Physics bodies are kept and
+		// reset to the restored components
+		COCOA void Restore(SceneData& scene, const RegistrySnapshot& snapshot);
+
+		// Only the script components, used around a script hot reload
+		COCOA void CaptureScripts(RegistrySnapshot& snapshot);
+		COCOA void RestoreScripts(SceneData& scene, const RegistrySnapshot& snapshot);
+	};
+}
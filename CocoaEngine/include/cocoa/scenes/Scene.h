@@ -29,8 +29,8 @@ namespace Cocoa
 		COCOA void Play(SceneData& data);
 		COCOA void Stop(SceneData& data);
 		COCOA void Save(SceneData& data, const CPath& filename);
+		COCOA void ExportJson(SceneData& data, const CPath& filename);
 		COCOA void Load(SceneData& data, const CPath& filename);
-		COCOA void LoadScriptsOnly(SceneData& data, const CPath& filename);
 
 		COCOA Entity CreateEntity(SceneData& data);
 		COCOA Entity DuplicateEntity(SceneData& data, Entity entity);
@@ -0,0 +1,36 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/core/Entity.h"
+#include "cocoa/scenes/SceneData.h"
+
+namespace Cocoa
+{
+	// Keeps the bounds of every entity with a SpriteRenderer or an AABB in a DynamicAabbTree, so the editor can pick,
+	// box select and cull without reading back the picking buffer or touching the physics world, which only exists
+	// while playing. Transforms are changed in place all over the editor, so Update compares each entity's transform
+	// against the one it was last indexed with and only touches the tree for entities that changed. Removals come from
+	// the registry's component events instead of a sweep over everything indexed.
+	namespace SpatialIndex
+	{
+		// Listens for removed bounds components on the scene's registry
+		COCOA void Init(SceneData& scene);
+		COCOA void Destroy(SceneData& scene);
+
+		// Must be called on the main thread once per editor frame
+		COCOA void Update(SceneData& scene);
+
+		// Drops every entity. The index stays inactive until the next Update
+		COCOA void Clear();
+
+		// False until Update has run, queries on an inactive index find nothing
+		COCOA bool IsActive();
+
+		// Returns the topmost entity under point, by SpriteRenderer z index
+		COCOA Entity Pick(SceneData& scene, const glm::vec2& point);
+
+		// Appends every entity whose bounds overlap [min, max]
+		COCOA void QueryBox(const glm::vec2& min, const glm::vec2& max, std::vector<entt::entity>& results);
+	};
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+#include "cocoa/file/CPath.h"
+#include "cocoa/scenes/SceneData.h"
+
+namespace Cocoa
+{
+	// Splits a scene into fixed size spatial cells and streams them in around the scene camera, so only the part of a
+	// level near the camera is resident, in the editor as well as while playing. Each cell is its own file
+	// holding the cell's components in the scene json format plus a table of the assets they use, encoded as CBOR.
+	// Reading and decoding cells happens on a worker thread, the main thread only adds the decoded components to the
+	// registry, at most Settings::Streaming::s_MaxCellsPerFrame cells per frame.
+	// Once a scene has a cell directory the cells are the only copy of the entities they own, the scene file keeps the
+	// rest. Entities with script components stay in the scene file, the script library can't remove single components.
+	namespace WorldStreamer
+	{
+		COCOA void Init();
+		COCOA void Destroy();
+
+		// Does nothing unless sceneFile has a cell directory. Otherwise every resident cell is rewritten from the scene,
+		// entities that moved into a cell that isn't resident pull that cell in first, and cells that aren't resident
+		// keep their files. Afterwards the cells own every entity with a transform and no scripts, the scene file is
+		// expected to leave those out and store GetIndexHash so it's only ever loaded together with these cells
+		COCOA bool SaveCells(SceneData& scene, const CPath& sceneFile);
+
+		// Starts streaming the cells of sceneFile. Refuses cells whose index doesn't hash to indexHash, those were not
+		// written by the save that wrote the scene file
+		COCOA bool Open(SceneData& scene, const CPath& sceneFile, uint64 indexHash);
+
+		// Destroys every streamed entity and drops pending loads
+		COCOA void Close(SceneData& scene);
+
+		// Blocks until every cell is resident
+		COCOA void LoadAll(SceneData& scene);
+
+		// Cells streamed in by the editor may hold unsaved edits and are part of the editor's play snapshot, so they stay
+		// resident until the scene is closed. Only cells streamed in while playing are unloaded again, Stop unloads
+		// whatever is left of them
+		COCOA void Stop(SceneData& scene);
+
+		// Must be called on the main thread once per frame
+		COCOA void Update(SceneData& scene);
+
+		COCOA bool IsOpen();
+		COCOA bool OwnsEntity(entt::entity entity);
+		COCOA uint64 GetIndexHash();
+		COCOA int NumResidentCells();
+
+		// Cells for scene.cocoa are kept in scene_cells next to it
+		COCOA CPath GetCellDirectory(const CPath& sceneFile);
+	};
+}
@@ -21,6 +21,7 @@ namespace Cocoa
 
 		COCOA void AddEntity(const TransformData& transform, const FontRenderer& fontRenderer);
 		COCOA void AddEntity(const TransformData& transform, const SpriteRenderer& spr);
+		COCOA void AddEntity(const TransformData& transform, const SpriteRenderer& spr, const glm::vec3& position, float rotationDegrees);
 		COCOA void Render(const SceneData& scene);
 		COCOA const Framebuffer& GetMainFramebuffer();
 
@@ -32,6 +32,9 @@ namespace Cocoa
         COCOA void Deserialize(json& j, Entity entity);
 
         COCOA bool FreeScriptLibrary();
+
+        // Removes every script component but keeps the library loaded
+        COCOA void ClearScripts();
         COCOA void AddComponentFromString(std::string className, entt::entity entity, entt::registry& registry);
     };
 }
\ No newline at end of file
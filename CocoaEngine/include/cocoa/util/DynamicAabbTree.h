@@ -0,0 +1,51 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+namespace Cocoa
+{
+	struct AabbTreeNode
+	{
+		glm::vec2 Min;
+		glm::vec2 Max;
+		uint32 UserData;
+
+		// Free nodes reuse Parent as the next node in the free list
+		int32 Parent;
+		int32 Left;
+		int32 Right;
+
+		// 0 for leaves, -1 for free nodes
+		int32 Height;
+	};
+
+	// A balanced bounding volume hierarchy over 2D boxes that can be changed one box at a time. Leaves store their box
+	// grown by Margin, so a box only has to be reinserted once it moves outside of its fat box. Proxies are node indices
+	// and stay valid until they are removed.
+	struct DynamicAabbTree
+	{
+		std::vector<AabbTreeNode> Nodes;
+		int32 Root = -1;
+		int32 FreeList = -1;
+		int32 NumLeaves = 0;
+		float Margin = 0.0f;
+	};
+
+	namespace NDynamicAabbTree
+	{
+		COCOA DynamicAabbTree Create(float margin);
+		COCOA void Clear(DynamicAabbTree& tree);
+
+		// Returns the proxy of the new leaf
+		COCOA int32 Insert(DynamicAabbTree& tree, const glm::vec2& min, const glm::vec2& max, uint32 userData);
+		COCOA void Remove(DynamicAabbTree& tree, int32 proxy);
+
+		// Returns true if the leaf left its fat box and had to be reinserted
+		COCOA bool Move(DynamicAabbTree& tree, int32 proxy, const glm::vec2& min, const glm::vec2& max);
+
+		COCOA uint32 GetUserData(const DynamicAabbTree& tree, int32 proxy);
+
+		// Appends the proxy of every leaf whose fat box overlaps [min, max]
+		COCOA void Query(const DynamicAabbTree& tree, const glm::vec2& min, const glm::vec2& max, std::vector<int32>& proxies);
+	};
+}
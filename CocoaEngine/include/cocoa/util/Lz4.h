@@ -0,0 +1,21 @@
+#pragma once
+#include "externalLibs.h"
+#include "cocoa/core/Core.h"
+
+namespace Cocoa
+{
+	// Reads and writes raw LZ4 blocks (no frame header). The output is compatible with the reference implementation, so
+	// packs can be built with other tools too. Nothing in here allocates through the tracked allocator, it is safe to
+	// call from worker threads.
+	namespace Lz4
+	{
+		// Largest size compressing srcSize bytes can produce
+		COCOA int CompressBound(int srcSize);
+
+		// Returns the number of bytes written to dst, or 0 if they did not fit in dstCapacity
+		COCOA int Compress(const uint8* src, int srcSize, uint8* dst, int dstCapacity);
+
+		// Returns the number of bytes written to dst, or -1 if the block is malformed or does not fit in dstSize
+		COCOA int Decompress(const uint8* src, int srcSize, uint8* dst, int dstSize);
+	};
+}
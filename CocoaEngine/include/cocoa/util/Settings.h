@@ -21,11 +21,26 @@ namespace Cocoa
 			extern COCOA CPath s_EditorStyle;
 		};
 
+		namespace Graphics
+		{
+			extern COCOA int s_TextureMemoryBudgetMb;
+			extern COCOA int s_AssetMemoryBudgetMb;
+		};
+
 		namespace Physics2D
 		{
 			extern COCOA int s_VelocityIterations;
 			extern COCOA int s_PositionIterations;
 			extern COCOA float s_Timestep;
+			extern COCOA int s_MaxSubsteps;
+		};
+
+		namespace Streaming
+		{
+			extern COCOA float s_CellSize;
+			extern COCOA int s_LoadRadius;
+			extern COCOA int s_UnloadRadius;
+			extern COCOA int s_MaxCellsPerFrame;
 		};
 	}
 }
\ No newline at end of file
@@ -40,6 +40,8 @@ using json = nlohmann::json;
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <memory>
 #include <array>
 #include <algorithm>
 #include <stdlib.h>